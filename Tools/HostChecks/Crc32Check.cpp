@@ -0,0 +1,185 @@
+/*
+ * Crc32Check.cpp
+ *
+ *  Host check of the slicing-by-4 block update in class CRC32.
+ *
+ *  We check the block update against the CRCs that zlib gives for some standard strings, and against a bit-at-a-time reference
+ *  implementation for random data of every length up to a few words, starting at every alignment, and split into several updates.
+ *  Then we time the block update against feeding the same data in a byte at a time, which is what the firmware did before.
+ */
+
+#include "Storage/CRC32.h"
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <random>
+
+namespace
+{
+	struct Vector
+	{
+		const char *data;
+		uint32_t crc;							// as returned by zlib's crc32()
+	};
+
+	const Vector vectors[] =
+	{
+		{ "",												0x00000000 },
+		{ "a",												0xe8b7be43 },
+		{ "abc",											0x352441c2 },
+		{ "123456789",										0xcbf43926 },
+		{ "message digest",									0x20159d7f },
+		{ "abcdefghijklmnopqrstuvwxyz",						0x4c2750bd },
+		{ "The quick brown fox jumps over the lazy dog",	0x414fa339 },
+		{ "G1 X10.5 Y20.25 E0.1234 F3000\n",				0x212a524c },
+	};
+
+	const size_t MaxAlignment = 8;				// we try every start offset from 0 to this minus 1
+	const size_t MaxRandomLength = 300;
+	const size_t BenchmarkBufferSize = 2048;	// the size of the buffer the firmware uses for uploads
+	const unsigned int BenchmarkRepeats = 20000;
+
+	uint32_t ReferenceCrc(const char *data, size_t len)
+	{
+		uint32_t crc = 0xffffffff;
+		while (len-- != 0)
+		{
+			crc ^= (uint8_t)*data++;
+			for (unsigned int bit = 0; bit < 8; ++bit)
+			{
+				crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+			}
+		}
+		return ~crc;
+	}
+
+	uint32_t BlockCrc(const char *data, size_t len)
+	{
+		CRC32 crc;
+		crc.Update(data, len);
+		return crc.Get();
+	}
+
+	uint32_t ByteCrc(const char *data, size_t len)
+	{
+		CRC32 crc;
+		for (size_t i = 0; i < len; ++i)
+		{
+			crc.Update(data[i]);
+		}
+		return crc.Get();
+	}
+
+	uint32_t SplitCrc(const char *data, size_t len, size_t split1, size_t split2)
+	{
+		CRC32 crc;
+		crc.Update(data, split1);
+		crc.Update(data + split1, split2 - split1);
+		crc.Update(data + split2, len - split2);
+		return crc.Get();
+	}
+
+	unsigned int failures = 0;
+
+	void Check(bool ok, const char *what, size_t len, size_t offset, uint32_t got, uint32_t expected)
+	{
+		if (!ok)
+		{
+			++failures;
+			if (failures <= 20)
+			{
+				printf("FAILED %s: length %zu offset %zu got %08x expected %08x\n", what, len, offset, (unsigned int)got, (unsigned int)expected);
+			}
+		}
+	}
+
+	void CheckVectors()
+	{
+		alignas(4) char buffer[64 + MaxAlignment];
+		for (const Vector& v : vectors)
+		{
+			const size_t len = strlen(v.data);
+			for (size_t offset = 0; offset < MaxAlignment; ++offset)
+			{
+				memcpy(buffer + offset, v.data, len);
+				const uint32_t block = BlockCrc(buffer + offset, len);
+				Check(block == v.crc, "zlib vector, block", len, offset, block, v.crc);
+				for (size_t split = 0; split <= len; ++split)
+				{
+					const uint32_t split2 = SplitCrc(buffer + offset, len, split, len);
+					Check(split2 == v.crc, "zlib vector, split", len, offset, split2, v.crc);
+				}
+			}
+			const uint32_t bytes = ByteCrc(v.data, len);
+			Check(bytes == v.crc, "zlib vector, bytes", len, 0, bytes, v.crc);
+		}
+	}
+
+	void CheckRandomData(std::mt19937& rng)
+	{
+		alignas(4) char buffer[MaxRandomLength + MaxAlignment];
+		for (char& c : buffer)
+		{
+			c = (char)rng();
+		}
+
+		for (size_t len = 0; len <= MaxRandomLength; ++len)
+		{
+			for (size_t offset = 0; offset < MaxAlignment; ++offset)
+			{
+				const char * const data = buffer + offset;
+				const uint32_t expected = ReferenceCrc(data, len);
+				const uint32_t block = BlockCrc(data, len);
+				Check(block == expected, "random data, block", len, offset, block, expected);
+
+				// Split the data into three updates, so that the later ones usually start at a different alignment to the first
+				const size_t split1 = (len == 0) ? 0 : rng() % (len + 1);
+				const size_t split2 = split1 + ((len == split1) ? 0 : rng() % (len - split1 + 1));
+				const uint32_t split = SplitCrc(data, len, split1, split2);
+				Check(split == expected, "random data, split", len, offset, split, expected);
+			}
+		}
+	}
+
+	template<class F> double Throughput(F crcFunction, const char *data, uint32_t& result)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		uint32_t combined = 0;
+		for (unsigned int i = 0; i < BenchmarkRepeats; ++i)
+		{
+			combined ^= crcFunction(data, BenchmarkBufferSize);
+		}
+		const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		result = combined;
+		return (double)BenchmarkBufferSize * BenchmarkRepeats/(elapsed.count() * 1.0e6);
+	}
+
+	void Benchmark(std::mt19937& rng)
+	{
+		alignas(4) static char buffer[BenchmarkBufferSize];
+		for (char& c : buffer)
+		{
+			c = (char)rng();
+		}
+
+		uint32_t byteResult, blockResult;
+		const double byteRate = Throughput(ByteCrc, buffer, byteResult);
+		const double blockRate = Throughput(BlockCrc, buffer, blockResult);
+		Check(byteResult == blockResult, "benchmark", BenchmarkBufferSize, 0, blockResult, byteResult);
+		printf("Throughput over %zu-byte buffers on this host: byte at a time %.0fMB/s, block %.0fMB/s (%.1f times faster)\n",
+				BenchmarkBufferSize, byteRate, blockRate, blockRate/byteRate);
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(1);
+	CheckVectors();
+	CheckRandomData(rng);
+	printf("%s: %zu zlib vectors and random data of lengths 0 to %zu at %zu alignments, whole and split\n",
+			(failures == 0) ? "CRCs ok" : "CRCs FAILED", sizeof(vectors)/sizeof(vectors[0]), MaxRandomLength, MaxAlignment);
+	Benchmark(rng);
+	return (failures == 0) ? 0 : 1;
+}
+
+// End
@@ -0,0 +1,133 @@
+/*
+ * FopDtCheck.cpp
+ *
+ *  Host check of FopDtIdentifier against simulated heaters.
+ *
+ *  Each simulated heater is a first order process with dead time and known G, tc and td, read with some noise. We drive it the way
+ *  PID::DoTuningStep drives a real heater during M303: heater on at the tuning PWM until the target temperature is reached, then off
+ *  until the model has settled and the heater has cooled a little, or until it has cooled well back towards the start temperature.
+ *  The check passes if the identified model is close enough to the simulated one for every heater.
+ */
+
+#include "Heating/FOPDT.h"
+#include <cstdio>
+#include <random>
+
+namespace
+{
+	// These match the constants at the top of Pid.cpp
+	const float HotEndIdentificationInterval = 0.5;
+	const float BedIdentificationInterval = 2.0;
+	const unsigned int ModelSettledUpdates = 20;
+	const float MinCoolingProportion = 0.15;
+	const float CoolDownProportion = 0.6;
+
+	const float SimulationStep = 0.01;				// the integration step of the simulated heater in seconds
+	const float ReadingNoise = 0.05;				// standard deviation of the temperature reading noise in degC
+	const float StartTemperature = 25.0;
+	const float MaxTuningTime = 3600.0;
+
+	// Acceptance limits
+	const float MaxGainError = 0.10;				// fractional
+	const float MaxTimeConstantError = 0.10;		// fractional
+	const float MaxDeadTimeErrorIntervals = 1.0;	// in identification intervals
+
+	struct Heater
+	{
+		const char *name;
+		float gain, timeConstant, deadTime;			// the process we simulate
+		float pwm, targetTemp, interval;			// how we tune it
+	};
+
+	const Heater heaters[] =
+	{
+		{ "E3D V6 hot end",		340.0, 140.0,  5.5, 1.0, 200.0, HotEndIdentificationInterval },
+		{ "fast hot end",		300.0, 100.0,  2.2, 1.0, 200.0, HotEndIdentificationInterval },
+		{ "hot end at 50% PWM",	560.0, 170.0,  4.0, 0.5, 210.0, HotEndIdentificationInterval },
+		{ "slow hot end",		250.0, 250.0,  7.3, 1.0, 180.0, HotEndIdentificationInterval },
+		{ "aluminium bed",		120.0, 800.0, 12.0, 1.0,  75.0, BedIdentificationInterval },
+		{ "glass on steel bed",	 95.0, 650.0, 21.0, 1.0,  60.0, BedIdentificationInterval },
+	};
+
+	// Simulate tuning one heater, returning true if the identifier produced a model close enough to it
+	bool CheckHeater(const Heater& h, std::mt19937& rng)
+	{
+		std::normal_distribution<float> noise(0.0, ReadingNoise);
+		const size_t delaySteps = (size_t)(h.deadTime/SimulationStep + 0.5);
+		float * const pwmDelayLine = new float[delaySteps + 1]();	// the PWM that the heater is seeing now, oldest first
+		size_t delayIndex = 0;
+
+		FopDtIdentifier identifier;
+		identifier.Start(StartTemperature, h.interval);
+
+		float temperature = StartTemperature;
+		float pwm = h.pwm;
+		float identifierPwm = pwm;
+		float peakTemperature = 0.0;
+		bool heating = true, finished = false;
+		const unsigned int stepsPerUpdate = (unsigned int)(h.interval/SimulationStep + 0.5);
+		unsigned int step = 0;
+		for (; !finished && (float)step * SimulationStep < MaxTuningTime; ++step)
+		{
+			pwmDelayLine[delayIndex] = pwm;
+			delayIndex = (delayIndex == delaySteps) ? 0 : delayIndex + 1;
+			const float effectivePwm = pwmDelayLine[delayIndex];
+			temperature += SimulationStep * (h.gain * effectivePwm - (temperature - StartTemperature))/h.timeConstant;
+
+			if ((step + 1) % stepsPerUpdate == 0)
+			{
+				const float reading = temperature + noise(rng);
+				identifier.Update(identifierPwm, reading);
+				identifierPwm = pwm;
+				if (heating)
+				{
+					if (reading >= h.targetTemp)
+					{
+						heating = false;
+						pwm = identifierPwm = 0.0;
+						peakTemperature = reading;
+					}
+				}
+				else
+				{
+					peakTemperature = max<float>(peakTemperature, reading);
+					const float rise = peakTemperature - StartTemperature;
+					finished = (identifier.GetStableUpdates() >= ModelSettledUpdates && reading <= peakTemperature - MinCoolingProportion * rise)
+								|| reading <= peakTemperature - CoolDownProportion * rise;
+				}
+			}
+		}
+		delete[] pwmDelayLine;
+
+		float gain, tc, td;
+		const bool haveModel = identifier.GetModel(gain, tc, td);
+		const float gainError = (gain - h.gain)/h.gain;
+		const float tcError = (tc - h.timeConstant)/h.timeConstant;
+		const float tdError = (td - h.deadTime)/h.interval;
+		const bool ok = finished && haveModel
+						&& fabsf(gainError) <= MaxGainError
+						&& fabsf(tcError) <= MaxTimeConstantError
+						&& fabsf(tdError) <= MaxDeadTimeErrorIntervals;
+		printf("%-20s G %6.1f (%+5.1f%%)  tc %6.1f (%+5.1f%%)  td %5.2f (%+5.2f intervals)  after %5.0fs  %s\n",
+				h.name, (double)gain, (double)(gainError * 100.0), (double)tc, (double)(tcError * 100.0), (double)td, (double)tdError,
+				(double)((float)step * SimulationStep), (ok) ? "ok" : "FAILED");
+		return ok;
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(1);
+	unsigned int failures = 0;
+	for (const Heater& h : heaters)
+	{
+		if (!CheckHeater(h, rng))
+		{
+			++failures;
+		}
+	}
+	printf("%u of %u heaters identified within limits\n", (unsigned int)(ARRAY_SIZE(heaters) - failures), (unsigned int)ARRAY_SIZE(heaters));
+	return (failures == 0) ? 0 : 1;
+}
+
+// End
@@ -0,0 +1,250 @@
+/*
+ * KinematicsCheck.cpp
+ *
+ *  Host check of the Cartesian to motor position conversions of the kinematics classes.
+ *
+ *  For each kinematics, configured the way config.g would, we convert random reachable positions to motor steps and back again with
+ *  MotorStepsToCartesian, and check that we get back to within a few steps of where we started. We also convert the motor positions we
+ *  got back to Cartesian coordinates and then to motor steps again, which must give the same motor positions to within one step.
+ *  Then we convert the same positions in batches with CartesianToMotorStepsBatch, which must give exactly the same motor positions as
+ *  converting them one at a time, and report how long each way takes.
+ */
+
+#include "RepRap.h"
+#include "Movement/Kinematics/Kinematics.h"
+#include <cstdio>
+#include <chrono>
+#include <random>
+
+namespace
+{
+	const size_t NumPoints = 20000;					// how many positions we check for each kinematics
+	const unsigned int BenchmarkRepeats = 50;		// how many times we convert all of them when timing the conversions
+
+	struct Machine
+	{
+		const char *name;
+		KinematicsType type;
+		unsigned int mCode;
+		const char *config;							// the parameters of the M665 or M669 command, or nullptr to use the defaults
+		float stepsPerUnit[XYZ_AXES];				// steps per mm, or steps per degree for an arm joint or turntable
+		float minRadius, maxRadius;					// we pick XY positions in this annulus...
+		float minAngle, maxAngle;					// ...between these angles in degrees from the X axis
+		float maxRoundTripError;					// how far in mm we allow a position to move in the round trip
+													// (the Hangprinter lines are nearly horizontal near the bed, so one step in them moves Z a long way)
+	};
+
+	const Machine machines[] =
+	{
+		{ "Cartesian",		KinematicsType::cartesian,	669, nullptr,							{  80.0,  80.0, 400.0 },	  0.0, 150.0, -180.0, 180.0, 0.01 },
+		{ "CoreXY",			KinematicsType::coreXY,		669, nullptr,							{  80.0,  80.0, 400.0 },	  0.0, 150.0, -180.0, 180.0, 0.02 },
+		{ "linear delta",	KinematicsType::linearDelta,665, "L250 R125 H300 B100",				{  80.0,  80.0,  80.0 },	  0.0, 100.0, -180.0, 180.0, 0.05 },
+		{ "Hangprinter",	KinematicsType::hangprinter,669, nullptr,							{  80.0,  80.0,  80.0 },	  0.0, 800.0, -180.0, 180.0, 0.50 },
+		{ "SCARA",			KinematicsType::scara,		669, "P150 D150 A-90:90 B-135:135",		{ 100.0, 100.0, 400.0 },	100.0, 320.0,  -60.0,  60.0, 0.10 },
+		{ "polar",			KinematicsType::polar,		669, "R0:200",							{  80.0, 100.0, 400.0 },	  5.0, 200.0, -180.0, 180.0, 0.05 },
+	};
+
+	unsigned int failures = 0;
+
+	void Fail(const Machine& m, const char *what, const float pos[])
+	{
+		++failures;
+		if (failures <= 20)
+		{
+			printf("FAILED %s: %s at X%.3f Y%.3f Z%.3f\n", m.name, what, (double)pos[X_AXIS], (double)pos[Y_AXIS], (double)pos[Z_AXIS]);
+		}
+	}
+
+	Kinematics *MakeKinematics(const Machine& m)
+	{
+		Kinematics * const k = Kinematics::Create(m.type);
+		if (m.config != nullptr)
+		{
+			GCodeBuffer gb(m.config);
+			String<FORMAT_STRING_LENGTH> reply;
+			StringRef replyRef = reply.GetRef();
+			bool error = false;
+			k->Configure(m.mCode, gb, replyRef, error);
+			if (error)
+			{
+				printf("FAILED %s: M%u %s gave \"%s\"\n", m.name, m.mCode, m.config, reply.c_str());
+				++failures;
+			}
+		}
+		return k;
+	}
+
+	template<class F> double NanosecondsPerPoint(F convertAll)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for (unsigned int i = 0; i < BenchmarkRepeats; ++i)
+		{
+			convertAll();
+		}
+		const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+		return elapsed.count()/((double)BenchmarkRepeats * NumPoints);
+	}
+
+	void CheckMachine(const Machine& m, std::mt19937& rng)
+	{
+		Platform& platform = reprap.GetPlatform();
+		for (size_t axis = 0; axis < XYZ_AXES; ++axis)
+		{
+			platform.SetDriveStepsPerUnit(axis, m.stepsPerUnit[axis]);
+		}
+		const float * const stepsPerUnit = platform.GetDriveStepsPerUnit();
+		Kinematics * const single = MakeKinematics(m);
+		Kinematics * const batch = MakeKinematics(m);				// separate, because SCARA kinematics remembers the arm mode
+
+		// Pick the positions
+		std::uniform_real_distribution<float> radius2Dist(fsquare(m.minRadius), fsquare(m.maxRadius));
+		std::uniform_real_distribution<float> angleDist(m.minAngle * DegreesToRadians, m.maxAngle * DegreesToRadians);
+		std::uniform_real_distribution<float> zDist(0.0, 100.0);
+		static float positions[NumPoints][MaxAxes];
+		for (float *pos : positions)
+		{
+			const float r = sqrtf(radius2Dist(rng)), angle = angleDist(rng);
+			pos[X_AXIS] = r * cosf(angle);
+			pos[Y_AXIS] = r * sinf(angle);
+			pos[Z_AXIS] = zDist(rng);
+		}
+
+		// Convert them one at a time and check the round trips
+		static int32_t singleMotorPos[NumPoints][MaxAxes];
+		size_t numUnreachable = 0;
+		float maxError = 0.0;
+		int32_t maxStepError = 0;
+		for (size_t i = 0; i < NumPoints; ++i)
+		{
+			const float * const pos = positions[i];
+			if (!single->CartesianToMotorSteps(pos, stepsPerUnit, XYZ_AXES, XYZ_AXES, singleMotorPos[i], false))
+			{
+				++numUnreachable;
+				continue;
+			}
+
+			float backPos[MaxAxes];
+			single->MotorStepsToCartesian(singleMotorPos[i], stepsPerUnit, XYZ_AXES, XYZ_AXES, backPos);
+			const float error = sqrtf(fsquare(backPos[X_AXIS] - pos[X_AXIS]) + fsquare(backPos[Y_AXIS] - pos[Y_AXIS]) + fsquare(backPos[Z_AXIS] - pos[Z_AXIS]));
+			maxError = max<float>(maxError, error);
+			if (!(error <= m.maxRoundTripError))
+			{
+				Fail(m, "Cartesian position changed too much in round trip", pos);
+			}
+
+			// Converting the position we got back must give the same motor positions, give or take rounding. Use another kinematics object so
+			// as not to disturb the arm mode that the single conversions are using.
+			int32_t againMotorPos[MaxAxes];
+			if (!batch->CartesianToMotorSteps(backPos, stepsPerUnit, XYZ_AXES, XYZ_AXES, againMotorPos, false))
+			{
+				Fail(m, "round trip position not reachable", pos);
+				continue;
+			}
+			for (size_t axis = 0; axis < XYZ_AXES; ++axis)
+			{
+				const int32_t stepError = labs(againMotorPos[axis] - singleMotorPos[i][axis]);
+				maxStepError = max<int32_t>(maxStepError, stepError);
+				if (stepError > 1)
+				{
+					Fail(m, "motor positions changed in round trip", pos);
+				}
+			}
+		}
+		delete batch;
+
+		// Convert them in batches, which must give exactly the same answers. Start with a fresh kinematics object again so that it is in the
+		// same state as the one we used for the single conversions was at the start.
+		Kinematics * const batchFromStart = MakeKinematics(m);
+		Kinematics * const singleFromStart = MakeKinematics(m);
+		size_t numMismatches = 0;
+		for (size_t first = 0; first < NumPoints; first += KinematicsBatchSize)
+		{
+			const size_t numInBatch = min<size_t>(KinematicsBatchSize, NumPoints - first);
+			float batchPos[MaxAxes][KinematicsBatchSize];
+			int32_t batchMotorPos[MaxAxes][KinematicsBatchSize];
+			for (size_t j = 0; j < numInBatch; ++j)
+			{
+				for (size_t axis = 0; axis < XYZ_AXES; ++axis)
+				{
+					batchPos[axis][j] = positions[first + j][axis];
+				}
+			}
+
+			// A batch only succeeds if every point in it does, so the single conversions stop at the first unreachable point too
+			const bool batchOk = batchFromStart->CartesianToMotorStepsBatch(batchPos, stepsPerUnit, XYZ_AXES, XYZ_AXES, numInBatch, batchMotorPos, false);
+			int32_t expectedMotorPos[KinematicsBatchSize][MaxAxes];
+			bool expectedOk = true;
+			for (size_t j = 0; j < numInBatch && expectedOk; ++j)
+			{
+				expectedOk = singleFromStart->CartesianToMotorSteps(positions[first + j], stepsPerUnit, XYZ_AXES, XYZ_AXES, expectedMotorPos[j], false);
+			}
+			if (batchOk != expectedOk)
+			{
+				Fail(m, "batch and single conversions disagree about reachability", positions[first]);
+				continue;
+			}
+			if (!batchOk)
+			{
+				continue;
+			}
+			for (size_t j = 0; j < numInBatch; ++j)
+			{
+				for (size_t axis = 0; axis < XYZ_AXES; ++axis)
+				{
+					if (batchMotorPos[axis][j] != expectedMotorPos[j][axis])
+					{
+						++numMismatches;
+						Fail(m, "batch conversion differs from single conversion", positions[first + j]);
+						break;
+					}
+				}
+			}
+		}
+
+		// Time the two ways of converting all the positions
+		const double singleTime = NanosecondsPerPoint([&]()
+			{
+				for (size_t i = 0; i < NumPoints; ++i)
+				{
+					single->CartesianToMotorSteps(positions[i], stepsPerUnit, XYZ_AXES, XYZ_AXES, singleMotorPos[i], false);
+				}
+			});
+		const double batchTime = NanosecondsPerPoint([&]()
+			{
+				float batchPos[MaxAxes][KinematicsBatchSize];
+				int32_t batchMotorPos[MaxAxes][KinematicsBatchSize];
+				for (size_t first = 0; first + KinematicsBatchSize <= NumPoints; first += KinematicsBatchSize)
+				{
+					for (size_t j = 0; j < KinematicsBatchSize; ++j)
+					{
+						for (size_t axis = 0; axis < XYZ_AXES; ++axis)
+						{
+							batchPos[axis][j] = positions[first + j][axis];
+						}
+					}
+					batchFromStart->CartesianToMotorStepsBatch(batchPos, stepsPerUnit, XYZ_AXES, XYZ_AXES, KinematicsBatchSize, batchMotorPos, false);
+					singleMotorPos[first][0] = batchMotorPos[0][0];
+				}
+			});
+
+		printf("%-13s round trip max %.4fmm and %d step, %zu unreachable, %zu batch mismatches, single %.0fns/point, batch %.0fns/point\n",
+				m.name, (double)maxError, (int)maxStepError, numUnreachable, numMismatches, singleTime, batchTime);
+
+		delete single;
+		delete batchFromStart;
+		delete singleFromStart;
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(1);
+	for (const Machine& m : machines)
+	{
+		CheckMachine(m, rng);
+	}
+	printf("%s\n", (failures == 0) ? "All kinematics ok" : "Kinematics FAILED");
+	return (failures == 0) ? 0 : 1;
+}
+
+// End
@@ -0,0 +1,38 @@
+/*
+ * Core.h
+ *
+ *  Host stand-in for the CoreNG header that RepRapFirmware.h includes, so that self-contained firmware modules can be compiled and
+ *  checked on a PC. It provides only what those modules use.
+ */
+
+#ifndef HOSTCHECKS_CORE_H_
+#define HOSTCHECKS_CORE_H_
+
+#include <cstdint>
+#include <cinttypes>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+using std::isnan;
+using std::min;
+using std::max;
+
+typedef uint8_t Pin;
+constexpr Pin NoPin = 0xFF;
+
+constexpr double PI = 3.141592653589793;
+
+#define ARRAY_SIZE(_x)	(sizeof(_x)/sizeof((_x)[0]))
+
+inline float fsquare(float arg) { return arg * arg; }
+inline double dsquare(double arg) { return arg * arg; }
+
+template<class T> inline T constrain(T val, T vmin, T vmax)
+{
+	return (val < vmin) ? vmin : (val > vmax) ? vmax : val;
+}
+
+uint32_t millis();
+
+#endif
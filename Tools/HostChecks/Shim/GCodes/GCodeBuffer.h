@@ -0,0 +1,98 @@
+/*
+ * GCodeBuffer.h
+ *
+ *  Host stand-in for src/GCodes/GCodeBuffer.h, holding a single command so that the checks can configure modules the way config.g does.
+ */
+
+#ifndef HOSTCHECKS_GCODEBUFFER_H_
+#define HOSTCHECKS_GCODEBUFFER_H_
+
+#include "RepRapFirmware.h"
+#include <cstdlib>
+#include <cctype>
+
+class GCodeBuffer
+{
+public:
+	explicit GCodeBuffer(const char *cmd) : command(cmd), readPointer(nullptr) { }
+
+	bool Seen(char c)
+	{
+		for (const char *p = command; *p != 0; ++p)
+		{
+			if (toupper(*p) == toupper(c) && (p == command || p[-1] == ' '))
+			{
+				readPointer = p + 1;
+				return true;
+			}
+		}
+		readPointer = nullptr;
+		return false;
+	}
+
+	float GetFValue()
+	{
+		return strtof(readPointer, nullptr);
+	}
+
+	const void GetFloatArray(float a[], size_t& length, bool doPad)
+	{
+		size_t count = 0;
+		const char *p = readPointer;
+		for (;;)
+		{
+			char *end;
+			const float f = strtof(p, &end);
+			if (end == p || count == length)
+			{
+				break;
+			}
+			a[count++] = f;
+			if (*end != ':')
+			{
+				break;
+			}
+			p = end + 1;
+		}
+		if (doPad && count == 1)
+		{
+			for (size_t i = 1; i < length; ++i)
+			{
+				a[i] = a[0];
+			}
+			count = length;
+		}
+		length = count;
+	}
+
+	void TryGetFValue(char c, float& val, bool& seen)
+	{
+		if (Seen(c))
+		{
+			val = GetFValue();
+			seen = true;
+		}
+	}
+
+	bool TryGetFloatArray(char c, size_t numVals, float vals[], const StringRef& reply, bool& seen, bool doPad = false)
+	{
+		if (Seen(c))
+		{
+			size_t count = numVals;
+			GetFloatArray(vals, count, doPad);
+			if (count != numVals)
+			{
+				reply.printf("Wrong number of values after '%c', expected %d", c, (int)numVals);
+				return true;
+			}
+			seen = true;
+		}
+		return false;
+	}
+
+private:
+	const char *command;
+	const char *readPointer;
+};
+
+#endif
@@ -0,0 +1,28 @@
+/*
+ * GCodes.h
+ *
+ *  Host stand-in for src/GCodes/GCodes.h. Only the axis letters and counts are needed.
+ */
+
+#ifndef HOSTCHECKS_GCODES_H_
+#define HOSTCHECKS_GCODES_H_
+
+#include "RepRapFirmware.h"
+#include "RepRap.h"
+#include "Platform.h"
+#include "GCodeBuffer.h"
+
+class GCodes
+{
+public:
+	GCodes() : numVisibleAxes(XYZ_AXES), numTotalAxes(XYZ_AXES) { }
+
+	size_t GetTotalAxes() const { return numTotalAxes; }
+	size_t GetVisibleAxes() const { return numVisibleAxes; }
+	const char *GetAxisLetters() const { return "XYZUVWABC"; }
+
+	size_t numVisibleAxes;
+	size_t numTotalAxes;
+};
+
+#endif
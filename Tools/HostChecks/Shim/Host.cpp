@@ -0,0 +1,62 @@
+/*
+ * Host.cpp
+ *
+ *  Definitions that the firmware modules under check expect to find elsewhere in the firmware or in CoreNG.
+ */
+
+#include "RepRap.h"
+#include "GCodes/GCodes.h"
+#include <cstdio>
+#include <chrono>
+
+static char scratchStringBuffer[256];
+StringRef scratchString(scratchStringBuffer, sizeof(scratchStringBuffer));
+
+static Platform platform;
+static GCodes gCodes;
+static Move move;
+RepRap reprap = { &platform, &gCodes, &move };
+
+Platform::Platform()
+{
+	for (size_t axis = 0; axis < MaxAxes; ++axis)
+	{
+		axisMinima[axis] = -1000.0;
+		axisMaxima[axis] = 1000.0;
+		axisDrivers[axis].numDrivers = 1;
+		axisDrivers[axis].driverNumbers[0] = (uint8_t)axis;
+	}
+	for (size_t drive = 0; drive < DRIVES; ++drive)
+	{
+		driveStepsPerUnit[drive] = 80.0;
+	}
+}
+
+void Platform::Message(MessageType type, const char *message)
+{
+	fputs(message, stdout);
+}
+
+void Platform::MessageF(MessageType type, const char *fmt, ...)
+{
+	va_list vargs;
+	va_start(vargs, fmt);
+	vprintf(fmt, vargs);
+	va_end(vargs);
+}
+
+extern "C" void debugPrintf(const char* fmt, ...)
+{
+	va_list vargs;
+	va_start(vargs, fmt);
+	vprintf(fmt, vargs);
+	va_end(vargs);
+}
+
+uint32_t millis()
+{
+	static const auto start = std::chrono::steady_clock::now();
+	return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// End
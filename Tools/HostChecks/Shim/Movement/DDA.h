@@ -0,0 +1,31 @@
+/*
+ * DDA.h
+ *
+ *  Host stand-in for src/Movement/DDA.h. The checks don't plan any moves, so this only has to satisfy the compiler.
+ */
+
+#ifndef HOSTCHECKS_DDA_H_
+#define HOSTCHECKS_DDA_H_
+
+#include "RepRapFirmware.h"
+
+class DDA
+{
+public:
+	static constexpr uint32_t stepClockRate = 750000;
+
+	DDA *GetPrevious() const { return nullptr; }
+	const int32_t *DriveCoordinates() const { return endPoint; }
+	void SetDriveCoordinate(int32_t a, size_t drive) { endPoint[drive] = a; }
+	float GetEndCoordinate(size_t drive, bool disableMotorMapping) { return 0.0; }
+	void SetPositions(const float move[], size_t numDrives) { }
+	float GetTotalDistance() const { return 0.0; }
+	void LimitSpeedAndAcceleration(float maxSpeed, float maxAcceleration) { }
+
+private:
+	int32_t endPoint[DRIVES];
+};
+
+#include "RepRap.h"
+
+#endif
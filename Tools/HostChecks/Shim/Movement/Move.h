@@ -0,0 +1,22 @@
+/*
+ * Move.h
+ *
+ *  Host stand-in for src/Movement/Move.h. The checks don't do any bed probing or auto calibration.
+ */
+
+#ifndef HOSTCHECKS_MOVE_H_
+#define HOSTCHECKS_MOVE_H_
+
+#include "RepRapFirmware.h"
+#include "Movement/DDA.h"
+#include "Movement/BedProbing/RandomProbePointSet.h"
+
+class Move
+{
+public:
+	float GetProbeCoordinates(int count, float& x, float& y, bool wantNozzlePosition) const { x = y = 0.0; return 0.0; }
+	void AdjustMotorPositions(const float adjustment[], size_t numMotors) { }
+	void AdjustLeadscrews(const floatc_t corrections[]) { }
+};
+
+#endif
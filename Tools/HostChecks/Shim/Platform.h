@@ -0,0 +1,48 @@
+/*
+ * Platform.h
+ *
+ *  Host stand-in for src/Platform.h. It holds the machine limits and drive settings that the kinematics read, and the checks can set them.
+ */
+
+#ifndef HOSTCHECKS_PLATFORM_H_
+#define HOSTCHECKS_PLATFORM_H_
+
+#include "RepRapFirmware.h"
+#include "MessageType.h"
+#include "Storage/FileStore.h"
+#include "Storage/MassStorage.h"
+
+struct AxisDriversConfig
+{
+	size_t numDrivers;								// Number of drivers assigned to each axis
+	uint8_t driverNumbers[MaxDriversPerAxis];		// The driver numbers assigned - only the first numDrivers are meaningful
+};
+
+class Platform
+{
+public:
+	Platform();
+
+	float AxisMinimum(size_t axis) const { return axisMinima[axis]; }
+	float AxisMaximum(size_t axis) const { return axisMaxima[axis]; }
+	void SetAxisMinimum(size_t axis, float value) { axisMinima[axis] = value; }
+	void SetAxisMaximum(size_t axis, float value) { axisMaxima[axis] = value; }
+	float DriveStepsPerUnit(size_t drive) const { return driveStepsPerUnit[drive]; }
+	const float *GetDriveStepsPerUnit() const { return driveStepsPerUnit; }
+	void SetDriveStepsPerUnit(size_t drive, float value) { driveStepsPerUnit[drive] = value; }
+	float Acceleration(size_t drive) const { return 1000.0; }
+	float MaxFeedrate(size_t drive) const { return 100.0; }
+	bool HomingZWithProbe() const { return false; }
+	MassStorage *GetMassStorage() const { return nullptr; }
+	const AxisDriversConfig& GetAxisDriversConfig(size_t axis) const { return axisDrivers[axis]; }
+	void Message(MessageType type, const char *message);
+	void MessageF(MessageType type, const char *fmt, ...) __attribute__ ((format (printf, 3, 4)));
+
+private:
+	float axisMinima[MaxAxes];
+	float axisMaxima[MaxAxes];
+	float driveStepsPerUnit[DRIVES];
+	AxisDriversConfig axisDrivers[MaxAxes];
+};
+
+#endif
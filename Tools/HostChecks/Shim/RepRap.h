@@ -0,0 +1,30 @@
+/*
+ * RepRap.h
+ *
+ *  Host stand-in for src/RepRap.h, giving the firmware modules under check access to the stand-in Platform, GCodes and Move.
+ */
+
+#ifndef HOSTCHECKS_REPRAP_H_
+#define HOSTCHECKS_REPRAP_H_
+
+#include "RepRapFirmware.h"
+#include "Platform.h"
+#include "Movement/Move.h"
+#include "GCodes/GCodeBuffer.h"
+
+class GCodes;
+
+class RepRap
+{
+public:
+	Platform& GetPlatform() const { return *platform; }
+	GCodes& GetGCodes() const { return *gCodes; }
+	Move& GetMove() const { return *move; }
+	bool Debug(Module module) const { return false; }
+
+	Platform *platform;
+	GCodes *gCodes;
+	Move *move;
+};
+
+#endif
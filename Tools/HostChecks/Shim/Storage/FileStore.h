@@ -0,0 +1,16 @@
+/*
+ * FileStore.h
+ *
+ *  Host stand-in for src/Storage/FileStore.h. The checks never write files, so this only has to satisfy the compiler.
+ */
+
+#ifndef HOSTCHECKS_FILESTORE_H_
+#define HOSTCHECKS_FILESTORE_H_
+
+class FileStore
+{
+public:
+	bool Write(const char *s) { return s != nullptr; }
+};
+
+#endif
@@ -0,0 +1,19 @@
+/*
+ * MassStorage.h
+ *
+ *  Host stand-in for src/Storage/MassStorage.h. The checks have no SD card.
+ */
+
+#ifndef HOSTCHECKS_MASSSTORAGE_H_
+#define HOSTCHECKS_MASSSTORAGE_H_
+
+#include "RepRapFirmware.h"
+
+class MassStorage
+{
+public:
+	bool FileExists(const char *file) const { return false; }
+	bool FileExists(const char* directory, const char *fileName) const { return false; }
+};
+
+#endif
@@ -0,0 +1,12 @@
+/*
+ * WMath.h
+ *
+ *  Host stand-in for the CoreNG maths header. Core.h already has what the firmware modules under check use.
+ */
+
+#ifndef HOSTCHECKS_WMATH_H_
+#define HOSTCHECKS_WMATH_H_
+
+#include "Core.h"
+
+#endif
@@ -0,0 +1,15 @@
+/*
+ * ecv.h
+ *
+ *  Host stand-in for the eCv annotations header in CoreNG. The annotations are only for the verifier, so they expand to nothing.
+ */
+
+#ifndef HOSTCHECKS_ECV_H_
+#define HOSTCHECKS_ECV_H_
+
+#define pre(...)
+#define post(...)
+#define invariant(...)
+#define assert(...)
+
+#endif
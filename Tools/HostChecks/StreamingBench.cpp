@@ -0,0 +1,764 @@
+/*
+ * StreamingBench.cpp
+ *
+ *  Throughput harness for the USB streaming protocol (M575 P0 S4) against the old one-ok-per-line protocol.
+ *
+ *  The sender half of this program is what a host needs to do to use either protocol. With no arguments we run it over a Linux pty
+ *  against a simulated firmware in a child process. The simulation follows the rules of GCodeBuffer::CheckStreamedLine,
+ *  GCodes::HandleStreamingReply and GCodes::FlushStreamingAcks, takes a fixed time to execute each line and delays everything it
+ *  receives and sends by a fixed latency, which stands in for the USB frame timing and the host's serial driver. It optionally
+ *  corrupts or drops some of the lines it receives. The child checks that every line was executed exactly once and in order, and
+ *  we report the lines per second that each protocol achieves.
+ *
+ *  Usage:
+ *    StreamingBench                                   run the standard simulated comparisons; exit status is nonzero if any failed
+ *    StreamingBench -l <us> -e <us> [-r <rate>]       simulate with the given one-way latency, execution time per line and error rate
+ *    StreamingBench -p /dev/ttyACM0 [-f <file>]       measure against a real board, sending G90 lines or the lines of the file
+ *  Use -n <lines> to change how many lines are sent.
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <random>
+#include <chrono>
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+namespace
+{
+	// These match the constants in GCodeInput.h and GCodeBuffer.cpp
+	const unsigned int StreamingLineCredits = 16;
+	const unsigned int StreamingAckBatch = StreamingLineCredits/2;
+	const uint32_t StreamingResendTimeoutMicros = 1000000;
+
+	const unsigned int DefaultLines = 2000;
+	const uint32_t ReplyTimeoutMicros = 5000000;		// how long the sender waits for a reply before giving up
+
+	typedef std::chrono::steady_clock Clock;
+
+	uint64_t Micros()
+	{
+		static const Clock::time_point start = Clock::now();
+		return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+	}
+
+	// Wait until the file is readable or the time is up. A time of zero means don't wait.
+	void WaitForInput(int fd, uint64_t micros)
+	{
+		pollfd pfd = { fd, POLLIN, 0 };
+		const timespec ts = { (time_t)(micros/1000000), (long)((micros % 1000000) * 1000) };
+		ppoll(&pfd, 1, &ts, nullptr);
+	}
+
+	bool WriteAll(int fd, const std::string& s)
+	{
+		size_t done = 0;
+		while (done < s.size())
+		{
+			const ssize_t n = write(fd, s.data() + done, s.size() - done);
+			if (n <= 0)
+			{
+				return false;
+			}
+			done += (size_t)n;
+		}
+		return true;
+	}
+
+	// Add the line number and the checksum that the firmware expects on a numbered line
+	std::string NumberedLine(unsigned int lineNumber, const std::string& command)
+	{
+		std::string line = "N" + std::to_string(lineNumber) + " " + command;
+		uint8_t checksum = 0;
+		for (char c : line)
+		{
+			checksum ^= (uint8_t)c;
+		}
+		return line + "*" + std::to_string(checksum) + "\n";
+	}
+
+	std::string ChecksummedCommand(const std::string& command)
+	{
+		uint8_t checksum = 0;
+		for (char c : command)
+		{
+			checksum ^= (uint8_t)c;
+		}
+		return command + "*" + std::to_string(checksum) + "\n";
+	}
+
+	void MakeRaw(int fd)
+	{
+		termios tio;
+		if (tcgetattr(fd, &tio) == 0)
+		{
+			cfmakeraw(&tio);
+			tcsetattr(fd, TCSANOW, &tio);
+		}
+	}
+
+	//*************************************************************************************
+	// The sender
+
+	class Sender
+	{
+	public:
+		Sender(int f, bool v) : fd(f), verbose(v) { }
+		bool SendOldProtocol(const std::vector<std::string>& commands, double& linesPerSecond);
+		bool SendStreaming(const std::vector<std::string>& commands, double& linesPerSecond, unsigned int& resends);
+
+	private:
+		bool ReadLine(std::string& line, uint64_t timeoutMicros);
+		bool WaitForOk();
+
+		int fd;
+		bool verbose;
+		std::string received;
+	};
+
+	// Return the next line that the firmware sent, waiting up to the timeout for it
+	bool Sender::ReadLine(std::string& line, uint64_t timeoutMicros)
+	{
+		const uint64_t start = Micros();
+		for (;;)
+		{
+			const size_t end = received.find('\n');
+			if (end != std::string::npos)
+			{
+				line = received.substr(0, end);
+				received.erase(0, end + 1);
+				if (!line.empty() && line.back() == '\r')
+				{
+					line.pop_back();
+				}
+				if (verbose && line.compare(0, 2, "ok") != 0)
+				{
+					printf("  board: %s\n", line.c_str());
+				}
+				return true;
+			}
+			const uint64_t waited = Micros() - start;
+			if (waited >= timeoutMicros)
+			{
+				return false;
+			}
+			WaitForInput(fd, timeoutMicros - waited);
+			char buf[256];
+			const ssize_t n = read(fd, buf, sizeof(buf));
+			if (n > 0)
+			{
+				received.append(buf, (size_t)n);
+			}
+		}
+	}
+
+	bool Sender::WaitForOk()
+	{
+		std::string line;
+		do
+		{
+			if (!ReadLine(line, ReplyTimeoutMicros))
+			{
+				printf("Timed out waiting for ok\n");
+				return false;
+			}
+		} while (line.compare(0, 2, "ok") != 0);
+		return true;
+	}
+
+	// Send each line and wait for its ok before sending the next one
+	bool Sender::SendOldProtocol(const std::vector<std::string>& commands, double& linesPerSecond)
+	{
+		const uint64_t start = Micros();
+		for (const std::string& command : commands)
+		{
+			if (!WriteAll(fd, command + "\n") || !WaitForOk())
+			{
+				return false;
+			}
+		}
+		linesPerSecond = (double)commands.size() * 1.0e6/(double)(Micros() - start);
+		return true;
+	}
+
+	// Switch to streaming mode, start the line sequence with M110, send the lines as fast as the credits allow and switch back.
+	// We keep every line we sent until it has been acknowledged, because after "Resend: <n>" we have to send it and all the ones after
+	// it again. The M110 is line 0, so command i is line i + 1.
+	bool Sender::SendStreaming(const std::vector<std::string>& commands, double& linesPerSecond, unsigned int& resends)
+	{
+		resends = 0;
+		if (!WriteAll(fd, "M575 P0 S4\n") || !WaitForOk() || !WriteAll(fd, NumberedLine(0, "M110 N0")))
+		{
+			return false;
+		}
+
+		const uint64_t start = Micros();
+		const unsigned int lastLine = (unsigned int)commands.size();
+		unsigned int acknowledged = 0, credits = 0, nextLine = 1;
+		bool started = false;
+		while (acknowledged < lastLine || !started)
+		{
+			std::string out;
+			while (started && nextLine <= lastLine && nextLine <= acknowledged + credits)
+			{
+				out += NumberedLine(nextLine, commands[nextLine - 1]);
+				++nextLine;
+			}
+			if (!out.empty() && !WriteAll(fd, out))
+			{
+				return false;
+			}
+
+			std::string line;
+			if (!ReadLine(line, ReplyTimeoutMicros))
+			{
+				printf("Timed out with lines %u to %u unacknowledged\n", acknowledged + 1, nextLine - 1);
+				return false;
+			}
+			unsigned int n, b;
+			if (sscanf(line.c_str(), "ok N%u B%u", &n, &b) == 2)
+			{
+				if (n > acknowledged)
+				{
+					acknowledged = n;
+				}
+				credits = b;
+				started = true;
+			}
+			else if (sscanf(line.c_str(), "Resend: %u", &n) == 1)
+			{
+				// The firmware may ask again for a line that we already resent, in which case it discards the lines it has already had
+				if (n >= 1 && n <= lastLine + 1)
+				{
+					nextLine = n;
+					++resends;
+				}
+			}
+		}
+		linesPerSecond = (double)commands.size() * 1.0e6/(double)(Micros() - start);
+
+		// Unnumbered lines still need a checksum in streaming mode
+		return WriteAll(fd, ChecksummedCommand("M575 P0 S0")) && WaitForOk();
+	}
+
+	//*************************************************************************************
+	// The simulated firmware
+
+	struct Simulation
+	{
+		uint64_t latency;						// one-way delay in microseconds
+		uint64_t executionTime;					// microseconds per line
+		double errorRate;						// proportion of lines that we corrupt or lose
+	};
+
+	class SimulatedFirmware
+	{
+	public:
+		SimulatedFirmware(int f, const Simulation& s) : fd(f), sim(s), rng(1) { }
+		int Run(unsigned int numCommands);
+
+	private:
+		struct Timed
+		{
+			uint64_t when;
+			std::string text;
+		};
+
+		void Receive(uint64_t now);
+		void Transmit(uint64_t now);
+		void Send(const std::string& s) { outgoing.push_back(Timed{ Micros() + sim.latency, s }); }
+		bool NextLine(std::string& line, uint64_t now);
+		bool ProcessLine(std::string line, std::string& command);
+		void Execute(const std::string& command);
+		void RequestResend(uint64_t now);
+		void FlushStreamingAcks();
+
+		int fd;
+		Simulation sim;
+		std::mt19937 rng;
+		std::deque<Timed> incoming, outgoing;
+		bool hostClosed = false;
+
+		// The state that GCodeBuffer and GCodes keep
+		bool streaming = false, lineSequenceStarted = false, awaitingResend = false;
+		unsigned int expectedLineNumber = 0, lastLineNumber = 0, acksPending = 0;
+		uint64_t resendRequestTime = 0;
+
+		// What we executed, to check against what the host sent
+		std::vector<unsigned int> executed;
+	};
+
+	void SimulatedFirmware::Receive(uint64_t now)
+	{
+		char buf[1024];
+		ssize_t n;
+		while ((n = read(fd, buf, sizeof(buf))) > 0)
+		{
+			incoming.push_back(Timed{ now + sim.latency, std::string(buf, (size_t)n) });
+		}
+		if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+		{
+			hostClosed = true;
+		}
+	}
+
+	void SimulatedFirmware::Transmit(uint64_t now)
+	{
+		std::string out;
+		while (!outgoing.empty() && outgoing.front().when <= now)
+		{
+			out += outgoing.front().text;
+			outgoing.pop_front();
+		}
+		if (!out.empty())
+		{
+			WriteAll(fd, out);
+		}
+	}
+
+	// Get the next complete line that has reached us, if there is one
+	bool SimulatedFirmware::NextLine(std::string& line, uint64_t now)
+	{
+		std::string pending;
+		size_t chunks = 0;
+		for (const Timed& t : incoming)
+		{
+			if (t.when > now)
+			{
+				break;
+			}
+			pending += t.text;
+			++chunks;
+			const size_t end = pending.find('\n');
+			if (end != std::string::npos)
+			{
+				line = pending.substr(0, end);
+				const std::string rest = pending.substr(end + 1);
+				incoming.erase(incoming.begin(), incoming.begin() + chunks);
+				if (!rest.empty())
+				{
+					incoming.push_front(Timed{ now, rest });
+				}
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Do what GCodeBuffer::LineFinished does with a line, returning the command to execute or false if there isn't one
+	bool SimulatedFirmware::ProcessLine(std::string line, std::string& command)
+	{
+		// Simulate errors on the line to the host. We only damage numbered lines, because the old protocol has no way to recover.
+		if (line[0] == 'N' && line.compare(0, 3, "N0 ") != 0 && std::uniform_real_distribution<double>(0.0, 1.0)(rng) < sim.errorRate)
+		{
+			if (rng() & 1)
+			{
+				return false;											// the line was lost
+			}
+			line[line.size()/2] ^= 0x04;								// a bit in the line was flipped
+		}
+
+		bool hadLineNumber = false, hadChecksum = false;
+		unsigned int lineNumber = 0, declaredChecksum = 0;
+		uint8_t computedChecksum = 0;
+		const size_t star = line.find('*');
+		if (star != std::string::npos)
+		{
+			hadChecksum = true;
+			declaredChecksum = (unsigned int)atoi(line.c_str() + star + 1);
+			for (size_t i = 0; i < star; ++i)
+			{
+				computedChecksum ^= (uint8_t)line[i];
+			}
+			line.erase(star);
+		}
+		if (line[0] == 'N')
+		{
+			hadLineNumber = true;
+			lineNumber = (unsigned int)atoi(line.c_str() + 1);
+			const size_t space = line.find(' ');
+			line.erase(0, (space == std::string::npos) ? line.size() : space + 1);
+		}
+		const bool badChecksum = hadChecksum && computedChecksum != declaredChecksum;
+		const bool checksumRequired = streaming;
+
+		if (streaming && hadLineNumber)
+		{
+			// This is GCodeBuffer::CheckStreamedLine
+			const uint64_t now = Micros();
+			if (!badChecksum)
+			{
+				if (line.compare(0, 4, "M110") == 0)
+				{
+					const size_t n = line.find('N');
+					lastLineNumber = (n != std::string::npos) ? (unsigned int)atoi(line.c_str() + n + 1) : lineNumber;
+					expectedLineNumber = lastLineNumber + 1;
+					lineSequenceStarted = true;
+					awaitingResend = false;
+					command = line;
+					return true;
+				}
+				if (lineSequenceStarted && lineNumber == expectedLineNumber)
+				{
+					expectedLineNumber = lineNumber + 1;
+					lastLineNumber = lineNumber;
+					awaitingResend = false;
+					command = line;
+					return true;
+				}
+				if (lineSequenceStarted && lineNumber < expectedLineNumber)
+				{
+					return false;
+				}
+			}
+			if (!lineSequenceStarted)
+			{
+				command = "M998";
+				return true;
+			}
+			if (awaitingResend && now - resendRequestTime < StreamingResendTimeoutMicros)
+			{
+				return false;
+			}
+			RequestResend(now);
+			command = "M998 P" + std::to_string(expectedLineNumber);
+			return true;
+		}
+
+		if (badChecksum)
+		{
+			if (!hadLineNumber)
+			{
+				return false;
+			}
+			command = "M998 P" + std::to_string(lineNumber);
+		}
+		else if (checksumRequired && !hadChecksum)
+		{
+			return false;
+		}
+		else
+		{
+			command = line;
+		}
+		return true;
+	}
+
+	void SimulatedFirmware::RequestResend(uint64_t now)
+	{
+		awaitingResend = true;
+		resendRequestTime = now;
+	}
+
+	void SimulatedFirmware::FlushStreamingAcks()
+	{
+		if (acksPending != 0)
+		{
+			Send("ok N" + std::to_string(lastLineNumber) + " B" + std::to_string(StreamingLineCredits) + "\n");
+			acksPending = 0;
+		}
+	}
+
+	// Execute a command and reply to it the way GCodes::HandleReply and GCodes::HandleStreamingReply do
+	void SimulatedFirmware::Execute(const std::string& command)
+	{
+		if (command.compare(0, 4, "M998") == 0)
+		{
+			if (streaming)
+			{
+				FlushStreamingAcks();
+				Send((command.size() > 4) ? "Resend: " + command.substr(6) + "\n" : std::string("Error: Send M110 to start the line sequence\n"));
+			}
+			else
+			{
+				Send("Checksum error on line " + command.substr(6) + "\nok\n");
+			}
+			return;
+		}
+
+		if (command.compare(0, 4, "M575") == 0)
+		{
+			const size_t s = command.find('S');
+			if (s != std::string::npos)
+			{
+				FlushStreamingAcks();
+				streaming = (atoi(command.c_str() + s + 1) & 4) != 0;
+			}
+		}
+		else if (command.compare(0, 3, "G1 ") == 0)
+		{
+			const size_t x = command.find('X');
+			executed.push_back((x != std::string::npos) ? (unsigned int)atoi(command.c_str() + x + 1) : 0);
+		}
+
+		if (streaming)
+		{
+			++acksPending;
+			if (acksPending >= StreamingAckBatch)
+			{
+				FlushStreamingAcks();
+			}
+		}
+		else
+		{
+			Send("ok\n");
+		}
+	}
+
+	// Run until the host closes the pty, then check that we executed every command exactly once and in order.
+	// This is the main loop of the firmware as far as the USB port is concerned: execute the next command if there is one,
+	// otherwise acknowledge what we have done and repeat a resend request if the last one timed out.
+	int SimulatedFirmware::Run(unsigned int numCommands)
+	{
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+		uint64_t busyUntil = 0;
+		std::string command;
+		bool executing = false;
+		while (!hostClosed)
+		{
+			const uint64_t now = Micros();
+			Receive(now);
+			Transmit(now);
+			if (executing)
+			{
+				if (now < busyUntil)
+				{
+					WaitForInput(fd, busyUntil - now);
+					continue;
+				}
+				Execute(command);
+				executing = false;
+			}
+
+			std::string line;
+			if (NextLine(line, now))
+			{
+				if (ProcessLine(line, command))
+				{
+					executing = true;
+					busyUntil = now + sim.executionTime;
+				}
+				continue;
+			}
+
+			// Nothing more has reached us, so the firmware would call FlushStreamingAcks and RepeatResendIfTimedOut
+			FlushStreamingAcks();
+			if (streaming && awaitingResend && now - resendRequestTime >= StreamingResendTimeoutMicros)
+			{
+				RequestResend(now);
+				command = "M998 P" + std::to_string(expectedLineNumber);
+				executing = true;
+				busyUntil = now + sim.executionTime;
+				continue;
+			}
+
+			uint64_t wait = 10000;
+			if (!incoming.empty())
+			{
+				wait = std::min<uint64_t>(wait, incoming.front().when - std::min(now, incoming.front().when));
+			}
+			if (!outgoing.empty())
+			{
+				wait = std::min<uint64_t>(wait, outgoing.front().when - std::min(now, outgoing.front().when));
+			}
+			WaitForInput(fd, wait);
+		}
+
+		// Each protocol is run separately, so we expect the commands once each
+		bool ok = executed.size() == numCommands;
+		for (size_t i = 0; ok && i < executed.size(); ++i)
+		{
+			ok = executed[i] == i;
+		}
+		if (!ok)
+		{
+			printf("FAILED: the simulated firmware executed %zu lines out of %u, or not in order\n", executed.size(), numCommands);
+		}
+		return (ok) ? 0 : 1;
+	}
+
+	//*************************************************************************************
+
+	std::vector<std::string> MakeCommands(unsigned int numLines)
+	{
+		// Each line moves to a different X so that the simulated firmware can tell which one it is executing
+		std::vector<std::string> commands;
+		for (unsigned int i = 0; i < numLines; ++i)
+		{
+			commands.push_back("G1 X" + std::to_string(i) + " Y20.25 E0.1234");
+		}
+		return commands;
+	}
+
+	// Run one protocol over a fresh pty against a fresh simulated firmware
+	bool RunSimulated(const Simulation& sim, bool streaming, unsigned int numLines, double& linesPerSecond, unsigned int& resends)
+	{
+		int master, slave;
+		if (openpty(&master, &slave, nullptr, nullptr, nullptr) != 0)
+		{
+			perror("openpty");
+			return false;
+		}
+		MakeRaw(slave);
+		fflush(stdout);
+		const pid_t child = fork();
+		if (child == 0)
+		{
+			close(slave);
+			_exit(SimulatedFirmware(master, sim).Run(numLines));
+		}
+		close(master);
+
+		const std::vector<std::string> commands = MakeCommands(numLines);
+		Sender sender(slave, false);
+		resends = 0;
+		const bool sent = (streaming) ? sender.SendStreaming(commands, linesPerSecond, resends) : sender.SendOldProtocol(commands, linesPerSecond);
+		close(slave);
+		if (!sent)
+		{
+			kill(child, SIGTERM);
+		}
+		int status;
+		waitpid(child, &status, 0);
+		return sent && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+	}
+
+	bool Compare(const Simulation& sim, unsigned int numLines)
+	{
+		printf("Latency %4uus each way, %3uus per line, %4.1f%% errors: ", (unsigned int)sim.latency, (unsigned int)sim.executionTime, sim.errorRate * 100.0);
+		fflush(stdout);
+		double oldRate = 0.0, streamingRate = 0.0;
+		unsigned int resends;
+		const bool oldOk = sim.errorRate != 0.0 || RunSimulated(sim, false, numLines, oldRate, resends);
+		const bool streamingOk = RunSimulated(sim, true, numLines, streamingRate, resends);
+		if (sim.errorRate == 0.0)
+		{
+			printf("old %6.0f lines/s, streaming %6.0f lines/s (%.1f times faster)", oldRate, streamingRate, streamingRate/oldRate);
+		}
+		else
+		{
+			printf("streaming %6.0f lines/s with %u resends (the old protocol can't recover)", streamingRate, resends);
+		}
+		printf(" %s\n", (oldOk && streamingOk) ? "ok" : "FAILED");
+		return oldOk && streamingOk;
+	}
+
+	int RunOnBoard(const char *port, const char *file, unsigned int numLines)
+	{
+		const int fd = open(port, O_RDWR | O_NOCTTY);
+		if (fd < 0)
+		{
+			perror(port);
+			return 1;
+		}
+		MakeRaw(fd);
+		tcflush(fd, TCIOFLUSH);
+
+		std::vector<std::string> commands;
+		if (file != nullptr)
+		{
+			FILE * const f = fopen(file, "r");
+			if (f == nullptr)
+			{
+				perror(file);
+				return 1;
+			}
+			char buf[256];
+			while (fgets(buf, sizeof(buf), f) != nullptr)
+			{
+				std::string line(buf);
+				line.erase(std::min(line.find(';'), line.find_last_not_of(" \t\r\n") + 1));
+				if (!line.empty())
+				{
+					commands.push_back(line);
+				}
+			}
+			fclose(f);
+		}
+		else
+		{
+			commands.assign(numLines, "G90");		// does nothing and has no reply, so we measure the protocol and not the machine
+		}
+
+		Sender sender(fd, true);
+		double oldRate = 0.0, streamingRate = 0.0;
+		unsigned int resends = 0;
+		if (!sender.SendOldProtocol(commands, oldRate))
+		{
+			return 1;
+		}
+		printf("Old protocol: %zu lines at %.0f lines/s\n", commands.size(), oldRate);
+		if (!sender.SendStreaming(commands, streamingRate, resends))
+		{
+			return 1;
+		}
+		printf("Streaming: %zu lines at %.0f lines/s with %u resends (%.1f times faster)\n", commands.size(), streamingRate, resends, streamingRate/oldRate);
+		close(fd);
+		return 0;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	const char *port = nullptr, *file = nullptr;
+	unsigned int numLines = DefaultLines;
+	Simulation sim = { 0, 0, 0.0 };
+	bool custom = false;
+	int opt;
+	while ((opt = getopt(argc, argv, "p:f:n:l:e:r:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'p': port = optarg; break;
+		case 'f': file = optarg; break;
+		case 'n': numLines = (unsigned int)atoi(optarg); break;
+		case 'l': sim.latency = (uint64_t)atol(optarg); custom = true; break;
+		case 'e': sim.executionTime = (uint64_t)atol(optarg); custom = true; break;
+		case 'r': sim.errorRate = atof(optarg); custom = true; break;
+		default:
+			fprintf(stderr, "Usage: %s [-p port [-f file]] [-n lines] [-l latency_us] [-e execution_us] [-r error_rate]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if (port != nullptr)
+	{
+		return RunOnBoard(port, file, numLines);
+	}
+
+	if (custom)
+	{
+		return (Compare(sim, numLines)) ? 0 : 1;
+	}
+
+	// One USB full speed frame is 1ms, so a reply usually waits up to that long to go out and the next line as long again to come in
+	const Simulation standard[] =
+	{
+		{  125, 100, 0.0 },
+		{  500, 100, 0.0 },
+		{ 1000, 100, 0.0 },
+		{  500, 400, 0.0 },
+		{  500, 100, 0.01 },
+		{  500, 100, 0.05 },
+	};
+	bool ok = true;
+	for (const Simulation& s : standard)
+	{
+		ok = Compare(s, numLines) && ok;
+	}
+	printf("%s\n", (ok) ? "Streaming protocol ok" : "Streaming protocol FAILED");
+	return (ok) ? 0 : 1;
+}
+
+// End
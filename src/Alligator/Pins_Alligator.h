@@ -23,6 +23,8 @@ const size_t NumFirmwareUpdateModules = 1;
 #define SUPPORT_SCANNER		0					// set nonzero to support FreeLSS scanners
 #define SUPPORT_IOBITS		0					// set to support P parameter in G0/G1 commands
 #define SUPPORT_DHT_SENSOR	0					// set nonzero to support DHT temperature/humidity sensors
+#define SUPPORT_SCURVE		0					// S-curve acceleration needs the FPU
+#define SUPPORT_SEGMENT_FREE_JOINTS	0		// segment-free SCARA and polar motion needs the FPU
 
 // The physical capabilities of the machine
 
@@ -46,6 +46,7 @@ constexpr float ROOM_TEMPERATURE = 21.0;				// Celsius
 constexpr uint32_t LongTime = 300000;					// Milliseconds (5 minutes)
 constexpr uint32_t FanCheckInterval = 500;				// Milliseconds
 constexpr uint32_t MinimumWarningInterval = 4000;		// Milliseconds, must be at least as long as FanCheckInterval
+constexpr uint32_t FastSimulationSliceTime = 20;		// Milliseconds to spend simulating before letting the other modules run
 constexpr uint32_t LogFlushInterval = 15000;			// Milliseconds
 constexpr uint32_t DriverCoolingTimeout = 4000;			// Milliseconds
 constexpr float DefaultMessageTimeout = 10.0;			// How long a message is displayed by default, in seconds
@@ -172,21 +173,30 @@ constexpr size_t GCODE_REPLY_LENGTH = 2048;
 constexpr size_t MESSAGE_LENGTH = 256;
 
 constexpr size_t FILENAME_LENGTH = 100;
+constexpr unsigned int DefaultFileListPageSize = 50;		// Number of files returned per call when a client asks for a directory listing in parts
 constexpr size_t MaxHeaterNameLength = 20;				// Maximum number of characters in a heater name
 
 // Output buffer lengths
+// The output buffers are carved out of a single memory region. Short messages use the small chunks,
+// long responses (file lists, config responses, M122) continue into the large chunks when they are available.
 #if SAM4E || SAM4S
-constexpr uint16_t OUTPUT_BUFFER_SIZE = 256;			// How many bytes does each OutputBuffer hold?
-constexpr size_t OUTPUT_BUFFER_COUNT = 32;				// How many OutputBuffer instances do we have?
+constexpr uint16_t OUTPUT_BUFFER_SIZE = 256;			// How many bytes does each small OutputBuffer hold?
+constexpr size_t OUTPUT_BUFFER_COUNT = 24;				// How many small OutputBuffer instances do we have?
+constexpr uint16_t LARGE_OUTPUT_BUFFER_SIZE = 1024;		// How many bytes does each large OutputBuffer hold?
+constexpr size_t LARGE_OUTPUT_BUFFER_COUNT = 2;			// How many large OutputBuffer instances do we have?
 constexpr size_t RESERVED_OUTPUT_BUFFERS = 1;			// Number of reserved output buffers after long responses. Must be enough for an HTTP header
 #elif SAM3XA
-constexpr uint16_t OUTPUT_BUFFER_SIZE = 128;			// How many bytes does each OutputBuffer hold?
-constexpr size_t OUTPUT_BUFFER_COUNT = 32;				// How many OutputBuffer instances do we have?
+constexpr uint16_t OUTPUT_BUFFER_SIZE = 128;			// How many bytes does each small OutputBuffer hold?
+constexpr size_t OUTPUT_BUFFER_COUNT = 24;				// How many small OutputBuffer instances do we have?
+constexpr uint16_t LARGE_OUTPUT_BUFFER_SIZE = 512;		// How many bytes does each large OutputBuffer hold?
+constexpr size_t LARGE_OUTPUT_BUFFER_COUNT = 2;			// How many large OutputBuffer instances do we have?
 constexpr size_t RESERVED_OUTPUT_BUFFERS = 2;			// Number of reserved output buffers after long responses. Must be enough for an HTTP header
 #else
 # error
 #endif
 
+constexpr size_t OUTPUT_BUFFER_ARENA_SIZE = OUTPUT_BUFFER_COUNT * OUTPUT_BUFFER_SIZE + LARGE_OUTPUT_BUFFER_COUNT * LARGE_OUTPUT_BUFFER_SIZE;
+
 // Move system
 constexpr float DefaultFeedrate = 3000.0;				// The initial requested feed rate after resetting the printer, in mm/min
 constexpr float DefaultRetractSpeed = 1000.0;			// The default firmware retraction and un-retraction speed, in mm
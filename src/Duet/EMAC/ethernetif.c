@@ -286,21 +286,25 @@ static err_t low_level_output(struct netif *netif, struct pbuf *p)
 		return ERR_BUF;
 	}
 
-	/* Clear the output buffer */
-	memset(bufptr, 0x0, NET_RW_BUFF_SIZE);
-
-	for (q = p; q != NULL; q = q->next) {
-		/* Send the data from the pbuf to the interface, one pbuf at a
-		 * time. The size of the data in each pbuf is kept in the ->len
-		 * variable. */
+	if (p->next == NULL) {
+		/* The frame is in a single pbuf, so the EMAC driver can copy it
+		 * straight into its transmit buffer */
+		bufptr = (int8_t *)p->payload;
+	} else {
+		for (q = p; q != NULL; q = q->next) {
+			/* Send the data from the pbuf to the interface, one pbuf at a
+			 * time. The size of the data in each pbuf is kept in the ->len
+			 * variable. */
 
-		/* Send data from(q->payload, q->len); */
-		memcpy(bufptr, q->payload, q->len);
-		bufptr += q->len;
+			/* Send data from(q->payload, q->len); */
+			memcpy(bufptr, q->payload, q->len);
+			bufptr += q->len;
+		}
+		bufptr = &pc_buf[0];
 	}
 
 	/* Signal that packet should be sent(); */
-	uc_rc = emac_dev_write(&gs_emac_dev, pc_buf, p->tot_len, NULL);
+	uc_rc = emac_dev_write(&gs_emac_dev, bufptr, p->tot_len, NULL);
 	if (uc_rc != EMAC_OK) {
 		return ERR_BUF;
 	}
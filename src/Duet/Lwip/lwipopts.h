@@ -87,7 +87,7 @@ a lot of data that needs to be copied, this should be set high. */
 /* MEMP_NUM_PBUF: the number of memp struct pbufs. If the application
    sends a lot of data out of ROM (or other static memory), this
    should be set high. */
-#define MEMP_NUM_PBUF				4
+#define MEMP_NUM_PBUF				8
 
 /* Number of raw connection PCBs */
 #define MEMP_NUM_RAW_PCB			0
@@ -196,8 +196,9 @@ a lot of data that needs to be copied, this should be set high. */
 /* TCP receive window. */
 #define TCP_WND						(2 * TCP_MSS)
 
-/* TCP sender buffer space (bytes). */
-#define TCP_SND_BUF					(2 * TCP_MSS)
+/* TCP sender buffer space (bytes). This is also the amount of data we send before waiting for an ACK.
+   Keep it an even number of segments, else the last segment of each window waits for the client's delayed ACK. */
+#define TCP_SND_BUF					(4 * TCP_MSS)
 
 /* TCP sender buffer space (pbufs). This must be at least = 2 * TCP_SND_BUF/TCP_MSS for things to work. */
 #define TCP_SND_QUEUELEN			(3 * TCP_SND_BUF / TCP_MSS)
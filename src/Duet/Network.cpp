@@ -109,7 +109,7 @@ static bool closingDataPort = false;
 
 ConnectionState *sendingConnection = nullptr;
 
-static uint32_t sendingWindow32[(TCP_WND + 3)/4];						// should be 32-bit aligned for efficiency
+static uint32_t sendingWindow32[(TCP_SND_BUF + 3)/4];						// should be 32-bit aligned for efficiency
 char * const sendingWindow = reinterpret_cast<char *>(sendingWindow32);
 uint16_t sendingWindowSize, sentDataOutstanding;
 uint8_t sendingRetries;
@@ -271,7 +271,7 @@ bool NetworkTransaction::Send()
 	}
 
 	// Fill up the TCP window with some data chunks from our OutputBuffer instances
-	size_t bytesBeingSent = 0, bytesLeftToSend = TCP_WND;
+	size_t bytesBeingSent = 0, bytesLeftToSend = TCP_SND_BUF;
 	while (sendBuffer != nullptr && bytesLeftToSend > 0)
 	{
 		size_t copyLength = min<size_t>(bytesLeftToSend, sendBuffer->BytesLeft());
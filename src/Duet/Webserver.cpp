@@ -47,15 +47,18 @@
  	 	 	 may also request different status responses by specifying the "type" keyword, followed
  	 	 	 by a custom status response type. Also see "M105 S1".
 
- rr_filelist?dir=xxx
+ rr_filelist?dir=xxx&first=nnn&max=mmm
  	 	 	 Returns a JSON-formatted list of all the files in xxx including the type and size in the
 			 following format: "files":[{"type":'f/d',"name":"xxx",size:yyy},...]
+			 If 'first' is present, the listing starts at that directory entry and returns at most 'max'
+			 files. The "next" value in the response is the value of 'first' to use to get the rest of
+			 the listing, or 0 if the listing is complete.
 
- rr_files?dir=xxx&flagDirs={1/0} [DEPRECATED]
+ rr_files?dir=xxx&flagDirs={1/0}&first=nnn&max=mmm [DEPRECATED]
  	 	 	 Returns a listing of the filenames in the /gcode directory of the SD card. 'dir' is a
  	 	 	 directory path relative to the root of the SD card. If the 'dir' variable is not present,
  	 	 	 it defaults to the /gcode directory. If flagDirs is set to 1, all directories will be
-			 prefixed by an asterisk.
+			 prefixed by an asterisk. 'first', 'max' and "next" work as for rr_filelist.
 
  rr_reply    Returns the last-known G-code reply as plain text (not encapsulated as JSON).
 
@@ -382,6 +385,7 @@ bool ProtocolInterpreter::StartUpload(FileStore *file, const char *fileName)
 		filenameBeingUploaded[ARRAY_UPB(filenameBeingUploaded)] = 0;
 
 		uploadState = uploadOK;
+		checkCrc = false;
 		return true;
 	}
 
@@ -448,16 +452,31 @@ bool ProtocolInterpreter::FinishUpload(uint32_t fileLength)
 		platform->MessageF(GenericMessage, "Error: Uploaded file size is different (%" PRIu32 " vs. expected %" PRIu32 " bytes)!\n", fileBeingUploaded.Length(), fileLength);
 	}
 
+	// Check the CRC if the client sent one
+	if (uploadState == uploadOK && checkCrc && fileBeingUploaded.GetCRC32() != expectedCrc)
+	{
+		uploadState = uploadError;
+		platform->MessageF(GenericMessage, "Error: Uploaded file CRC32 is different (%08" PRIx32 " vs. expected %08" PRIx32 ")!\n", fileBeingUploaded.GetCRC32(), expectedCrc);
+	}
+
 	// Close the file
 	if (fileBeingUploaded.IsLive())
 	{
 		fileBeingUploaded.Close();
 	}
 
-	// Delete the file again if an error has occurred
-	if (uploadState == uploadError && filenameBeingUploaded[0] != 0)
+	// Delete the file again if an error has occurred, otherwise make sure that directory listings show the final size
+	if (filenameBeingUploaded[0] != 0)
 	{
-		platform->GetMassStorage()->Delete(FS_PREFIX, filenameBeingUploaded);
+		if (uploadState == uploadError)
+		{
+			platform->GetMassStorage()->Delete(FS_PREFIX, filenameBeingUploaded);
+		}
+		else
+		{
+			platform->GetMassStorage()->UpdateCachedFileInfo(FS_PREFIX, filenameBeingUploaded);
+			reprap.GetGCodes().FileUploaded(filenameBeingUploaded);
+		}
 	}
 
 	// Clean up again
@@ -858,7 +877,10 @@ void Webserver::HttpInterpreter::SendJsonResponse(const char* command)
 	NetworkTransaction *transaction = webserver->currentTransaction;
 	if (transaction->GetStatus() == TransactionStatus::deferred || transaction->GetStatus() == TransactionStatus::sending)
 	{
-		OutputBuffer::Release(jsonResponse);
+		if (jsonResponse != nullptr)
+		{
+			OutputBuffer::Release(jsonResponse);
+		}
 		return;
 	}
 
@@ -983,8 +1005,14 @@ void Webserver::HttpInterpreter::GetJsonResponse(const char* request, OutputBuff
 	}
 	else if (StringEquals(request, "filelist") && GetKeyValue("dir") != nullptr)
 	{
+		unsigned int startAt, maxItems;
+		GetListingRange(startAt, maxItems);
 		OutputBuffer::Release(response);
-		response = reprap.GetFilelistResponse(GetKeyValue("dir"));
+		response = reprap.GetFilelistResponse(GetKeyValue("dir"), startAt, maxItems);
+		if (response == nullptr)
+		{
+			RejectMessage("Service Unavailable", 503);			// not enough output buffers for even one entry, so the client should try again
+		}
 	}
 	else if (StringEquals(request, "files"))
 	{
@@ -995,8 +1023,14 @@ void Webserver::HttpInterpreter::GetJsonResponse(const char* request, OutputBuff
 		}
 		const char* const flagDirsVal = GetKeyValue("flagDirs");
 		const bool flagDirs = flagDirsVal != nullptr && atoi(flagDirsVal) == 1;
+		unsigned int startAt, maxItems;
+		GetListingRange(startAt, maxItems);
 		OutputBuffer::Release(response);
-		response = reprap.GetFilesResponse(dir, flagDirs);
+		response = reprap.GetFilesResponse(dir, startAt, maxItems, flagDirs);
+		if (response == nullptr)
+		{
+			RejectMessage("Service Unavailable", 503);			// not enough output buffers for even one entry, so the client should try again
+		}
 	}
 	else if (StringEquals(request, "fileinfo"))
 	{
@@ -1073,6 +1107,19 @@ const char* Webserver::HttpInterpreter::GetKeyValue(const char *key) const
 	return nullptr;
 }
 
+// Get the range of directory entries that the client wants in a file listing.
+// Clients that pass 'first' get the listing in pages of 'max' entries, or DefaultFileListPageSize if 'max' is missing.
+// Older clients that pass neither get as much of the listing as fits in the output buffers.
+void Webserver::HttpInterpreter::GetListingRange(unsigned int& startAt, unsigned int& maxItems) const
+{
+	const char* const firstVal = GetKeyValue("first");
+	const char* const maxVal = GetKeyValue("max");
+	startAt = (firstVal == nullptr) ? 0 : strtoul(firstVal, nullptr, 10);
+	maxItems = (maxVal != nullptr) ? strtoul(maxVal, nullptr, 10)
+				: (firstVal != nullptr) ? DefaultFileListPageSize
+					: 0;
+}
+
 void Webserver::HttpInterpreter::ResetState()
 {
 	clientPointer = 0;
@@ -1570,6 +1617,22 @@ bool Webserver::HttpInterpreter::ProcessMessage()
 				{
 					return RejectMessage("could not start file upload");
 				}
+				(void)fileBeingUploaded.PreAllocate(postFileLength);		// so that the file is contiguous and quick to read when we print it
+
+				// If the client sent the CRC32 of the file then we check it when the upload completes, so that we don't accept a corrupted file
+				const char *crcString = GetKeyValue("crc32");
+				for (size_t i = 0; crcString == nullptr && i < numHeaderKeys; i++)
+				{
+					if (StringEquals(headers[i].key, "X-CRC32"))
+					{
+						crcString = headers[i].value;
+					}
+				}
+				if (crcString != nullptr)
+				{
+					expectedCrc = strtoul(crcString, nullptr, 16);
+					checkCrc = true;
+				}
 
 				// Try to get the last modified file date and time
 				const char* const lastModifiedString = GetKeyValue("time");
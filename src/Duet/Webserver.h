@@ -111,6 +111,8 @@ class ProtocolInterpreter
 		UploadState uploadState;
 		FileData fileBeingUploaded;
 		char filenameBeingUploaded[FILENAME_LENGTH];
+		uint32_t expectedCrc;								// the CRC32 the client says the file should have
+		bool checkCrc;										// true if the client sent the CRC32 of the file
 
 		bool StartUpload(FileStore *file, const char *fileName);
 		bool IsUploading() const;
@@ -225,6 +227,7 @@ protected:
 		void UpdateAuthentication();
 		bool RemoveAuthentication();
 		const char* GetKeyValue(const char *key) const;	// return the value of the specified key, or nullptr if not present
+		void GetListingRange(unsigned int& startAt, unsigned int& maxItems) const;	// get the requested range of a file listing
 
 		// Responses from GCodes class
 		uint32_t seq;									// Sequence number for G-Code replies
@@ -36,6 +36,8 @@ constexpr size_t NumFirmwareUpdateModules = 1;		// 1 module
 #define SUPPORT_SCANNER		1						// set zero to disable support for FreeLSS scanners
 #define SUPPORT_IOBITS		1						// set to support P parameter in G0/G1 commands
 #define SUPPORT_DHT_SENSOR	1						// set nonzero to support DHT temperature/humidity sensors
+#define SUPPORT_SCURVE		1						// set nonzero to support S-curve acceleration (needs the FPU)
+#define SUPPORT_SEGMENT_FREE_JOINTS	1				// set nonzero to drive SCARA and polar arms without segmentation (needs the FPU)
 
 #define USE_CACHE			1						// set nonzero to enable the cache
 
@@ -11,10 +11,13 @@
 #include "Platform.h"
 #include "RepRap.h"
 
+const uint32_t StreamingResendTimeout = 1000;	// how long we wait for a line we asked the host to resend before we ask again, in milliseconds
+
 // Create a default GCodeBuffer
 GCodeBuffer::GCodeBuffer(const char* id, MessageType mt, bool usesCodeQueue)
 	: machineState(new GCodeMachineState()), identity(id), checksumRequired(false), writingFileDirectory(nullptr),
-	  toolNumberAdjust(0), responseMessageType(mt), queueCodes(usesCodeQueue), binaryWriting(false)
+	  toolNumberAdjust(0), responseMessageType(mt), streaming(false), awaitingResend(false), lineSequenceStarted(false),
+	  expectedLineNumber(0), lastLineNumber(0), queueCodes(usesCodeQueue), binaryWriting(false)
 {
 	Init();
 }
@@ -67,6 +70,15 @@ void GCodeBuffer::Diagnostics(MessageType mtype)
 	reprap.GetPlatform().Message(mtype, scratchString.Pointer());
 }
 
+// Set the communication properties. Bit 0 of the M575 S parameter means require a checksum, bit 2 means use the streaming protocol.
+// Streaming relies on line numbers and checksums to detect lost or corrupted lines, so it implies that a checksum is required.
+void GCodeBuffer::SetCommsProperties(uint32_t arg)
+{
+	streaming = (arg & 4) != 0;
+	checksumRequired = (arg & 1) != 0 || streaming;
+	awaitingResend = lineSequenceStarted = false;
+}
+
 inline void GCodeBuffer::AddToChecksum(char c)
 {
 	computedChecksum ^= (uint8_t)c;
@@ -248,11 +260,16 @@ bool GCodeBuffer::LineFinished()
 		reprap.GetPlatform().MessageF(DebugMessage, "%s%s: %s\n", identity, ((badChecksum) ? "(bad-csum)" : (missingChecksum) ? "(no-csum)" : ""), gcodeBuffer);
 	}
 
+	if (streaming && hadLineNumber && machineState->previous == nullptr)
+	{
+		return CheckStreamedLine(badChecksum);
+	}
+
 	if (badChecksum)
 	{
 		if (hadLineNumber)
 		{
-			snprintf(gcodeBuffer, ARRAY_SIZE(gcodeBuffer), "M998 P%u", lineNumber);	// request resend
+			gcodeLineEnd = snprintf(gcodeBuffer, ARRAY_SIZE(gcodeBuffer), "M998 P%u", lineNumber);	// request resend
 		}
 		else
 		{
@@ -272,6 +289,86 @@ bool GCodeBuffer::LineFinished()
 	return true;
 }
 
+// Check a numbered line received using the streaming protocol and return true if it is ready to execute.
+// The host may send several lines ahead of our acknowledgements, so when a line is corrupted or missing we ask for a resend
+// of the first line we didn't accept and then discard everything until that line arrives, as the host will send the rest again.
+// The sequence must be started by M110, so until we have had a good M110 we reject every numbered line.
+bool GCodeBuffer::CheckStreamedLine(bool badChecksum)
+{
+	if (!badChecksum)
+	{
+		commandStart = 0;
+		DecodeCommand();
+		if (commandLetter == 'M' && commandNumber == 110)
+		{
+			// M110 restarts the sequence. The new line number may be given as a parameter, else the line number of this line is used.
+			const unsigned int newLineNumber = (Seen('N')) ? GetUIValue() : lineNumber;
+			expectedLineNumber = newLineNumber + 1;
+			lastLineNumber = newLineNumber;
+			lineSequenceStarted = true;
+			awaitingResend = false;
+			return true;
+		}
+
+		if (lineSequenceStarted && lineNumber == expectedLineNumber)
+		{
+			expectedLineNumber = lineNumber + 1;
+			lastLineNumber = lineNumber;
+			awaitingResend = false;
+			return true;
+		}
+
+		if (lineSequenceStarted && lineNumber < expectedLineNumber)
+		{
+			// The host resent a line that we already accepted, e.g. because an acknowledgement was lost. Our next acknowledgement covers it.
+			Init();
+			return false;
+		}
+	}
+
+	if (!lineSequenceStarted)
+	{
+		// We don't know which line to ask for, so replace the line by M998 without a line number, which tells the host to send M110 first
+		gcodeLineEnd = snprintf(gcodeBuffer, ARRAY_SIZE(gcodeBuffer), "M998");
+		commandStart = 0;
+		DecodeCommand();
+		return true;
+	}
+
+	// The line is corrupt or some lines went missing. Ask for a resend, unless we did so very recently, in which case this is probably
+	// one of the lines that the host sent before it saw our request. If the resent line is lost as well, we ask again.
+	if (awaitingResend && millis() - resendRequestTime < StreamingResendTimeout)
+	{
+		Init();
+		return false;
+	}
+	RequestResend();
+	return true;
+}
+
+// If we asked for a resend and nothing we could use has arrived for a while, ask again in case the request or the resent line was lost.
+// Called when the host has stopped sending. Return true if we made a resend request ready to execute.
+bool GCodeBuffer::RepeatResendIfTimedOut()
+{
+	if (streaming && awaitingResend && bufferState == GCodeBufferState::parseNotStarted && gcodeLineEnd == 0
+		&& millis() - resendRequestTime >= StreamingResendTimeout)
+	{
+		RequestResend();
+		return true;
+	}
+	return false;
+}
+
+// Replace the line in the buffer by a request to resend the line we expect next
+void GCodeBuffer::RequestResend()
+{
+	awaitingResend = true;
+	resendRequestTime = millis();
+	gcodeLineEnd = snprintf(gcodeBuffer, ARRAY_SIZE(gcodeBuffer), "M998 P%u", expectedLineNumber);
+	commandStart = 0;
+	DecodeCommand();
+}
+
 // Decode this command command and find the start of the next one on the same line.
 // On entry, 'commandStart' has already been set to the address the start of where the command should be.
 // On return, the state must be set to 'ready' to indicate that a command is available and we should stop adding characters.
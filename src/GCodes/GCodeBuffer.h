@@ -59,7 +59,10 @@ public:
 	void SetWritingFileDirectory(const char* wfd);		// Set the directory for the file to write the GCode in
 	int GetToolNumberAdjust() const { return toolNumberAdjust; }
 	void SetToolNumberAdjust(int arg) { toolNumberAdjust = arg; }
-	void SetCommsProperties(uint32_t arg) { checksumRequired = (arg & 1); }
+	void SetCommsProperties(uint32_t arg);				// Set checksum and streaming options from the M575 S parameter
+	bool IsStreaming() const { return streaming; }
+	unsigned int GetLastLineNumber() const { return lastLineNumber; }
+	bool RepeatResendIfTimedOut();						// Ask for a resend again if the last request has gone unanswered, returning true if we did
 	bool StartingNewCode() const { return gcodeLineEnd == 0; }
 	MessageType GetResponseMessageType() const { return responseMessageType; }
 	GCodeMachineState& MachineState() const { return *machineState; }
@@ -101,6 +104,8 @@ private:
 	void AddToChecksum(char c);
 	void StoreAndAddToChecksum(char c);
 	bool LineFinished();								// Deal with receiving end-of-line and return true if we have a command
+	bool CheckStreamedLine(bool badChecksum);			// Check the sequence of a streamed line, returning true if it should be executed
+	void RequestResend();								// Replace the line by a request to resend the line we expect next
 	void DecodeCommand();
 	bool InternalGetQuotedString(const StringRef& str)
 		pre (gcodeBuffer[readPointer] == '"'; str.IsEmpty());
@@ -126,6 +131,12 @@ private:
 	uint8_t computedChecksum;
 	bool hadLineNumber;
 	bool hadChecksum;
+	bool streaming;										// True if the host sends numbered lines ahead and we acknowledge them in batches
+	bool awaitingResend;								// True if we have asked for a resend and are discarding lines until it arrives
+	bool lineSequenceStarted;							// True if we know what line number to expect next
+	unsigned int expectedLineNumber;					// The line number we expect next when streaming
+	unsigned int lastLineNumber;						// The number of the last numbered line we accepted
+	uint32_t resendRequestTime;							// When we last asked the host to resend a line
 	bool hasCommandNumber;
 	char commandLetter;
 	int commandNumber;
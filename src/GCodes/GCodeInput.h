@@ -16,6 +16,8 @@
 
 const size_t GCodeInputBufferSize = 256;				// How many bytes can we cache per input source?
 const size_t GCodeInputFileReadThreshold = 128;			// How many free bytes must be available before data is read from the SD card?
+const unsigned int StreamingLineCredits = 16;			// How many unacknowledged lines a host using the USB streaming protocol may send ahead
+const unsigned int StreamingAckBatch = StreamingLineCredits/2;	// How many streamed lines we acknowledge at a time when the host keeps us busy
 
 
 // This base class is intended to provide incoming G-codes for the GCodeBuffer class
@@ -56,6 +56,14 @@ enum class GCodeState : uint8_t
 	gridProbing5,
 	gridProbing6,
 
+	// These next 6 must be contiguous
+	gridSweeping1,
+	gridSweeping2,
+	gridSweeping3,
+	gridSweeping4,
+	gridSweeping5,
+	gridSweeping6,
+
 	// These next 8 must be contiguous
 	probingAtPoint0,
 	probingAtPoint1,
@@ -34,6 +34,7 @@
 #include "PrintMonitor.h"
 #include "RepRap.h"
 #include "Tools/Tool.h"
+#include "Version.h"
 
 #if defined(DUET_NG) || defined(DUET_M)
 # include "FirmwareUpdater.h"
@@ -92,6 +93,10 @@ void GCodes::Init()
 	eofStringCounter = 0;
 	eofStringLength = strlen(eofString);
 	runningConfigFile = false;
+	startupConfigFile = nullptr;
+	startupConfigSignature[0] = 0;
+	configErrors = 0;
+	streamingAcksPending = 0;
 	doingToolChange = false;
 	active = true;
 	fileSize = 0;
@@ -182,6 +187,9 @@ void GCodes::Reset()
 
 	simulationMode = 0;
 	exitSimulationWhenFileComplete = false;
+	simulateUploadedFiles = false;
+	uploadedFileToSimulate[0] = 0;
+	simulatingUploadedFile = false;
 	simulationTime = 0.0;
 	isPaused = false;
 #if HAS_VOLTAGE_MONITOR
@@ -191,6 +199,7 @@ void GCodes::Reset()
 	doingManualBedProbe = false;
 	pausePending = false;
 	probeIsDeployed = false;
+	probingOnTheFly = false;
 	moveBuffer.filePos = noFilePosition;
 	lastEndstopStates = platform.GetAllEndstopStates();
 	firmwareUpdateModuleMap = 0;
@@ -238,10 +247,65 @@ float GCodes::FractionOfFilePrinted() const
 // We use triggerCGode as the source to prevent any triggers being executed until we have finished
 bool GCodes::RunConfigFile(const char* fileName)
 {
+	configErrors = 0;
 	runningConfigFile = DoFileMacro(*daemonGCode, fileName, false);
 	return runningConfigFile;
 }
 
+// Check whether we have a snapshot of the specified config file that was made by this firmware version from the current
+// contents of the file. Also record the size and CRC of the config file, so that we can tell later whether a snapshot of it would be valid.
+bool GCodes::ConfigSnapshotValid(const char* configFile)
+{
+	startupConfigFile = configFile;
+	StringRef signature(startupConfigSignature, ARRAY_SIZE(startupConfigSignature));
+	if (!GetConfigFileSignature(configFile, signature))
+	{
+		startupConfigFile = nullptr;
+		return false;
+	}
+
+	FileStore * const f = platform.GetFileStore(platform.GetSysDir(), CONFIG_SNAPSHOT_G, OpenMode::read);
+	if (f == nullptr)
+	{
+		return false;
+	}
+
+	char header[80], expectedHeaderBuffer[80];
+	const int len = f->ReadLine(header, ARRAY_SIZE(header));
+	f->Close();
+	StringRef expectedHeader(expectedHeaderBuffer, ARRAY_SIZE(expectedHeaderBuffer));
+	expectedHeader.printf("; config snapshot %s %s", VERSION, startupConfigSignature);
+	return len > 0 && strcmp(header, expectedHeader.Pointer()) == 0;
+}
+
+// Describe the contents of a file in the system directory by its size and CRC32, returning true if successful.
+// We don't use the file date, because it doesn't change when the file is edited if the clock has not been set.
+bool GCodes::GetConfigFileSignature(const char *fileName, StringRef& signature) const
+{
+	FileStore * const f = platform.GetFileStore(platform.GetSysDir(), fileName, OpenMode::read);
+	if (f == nullptr)
+	{
+		return false;
+	}
+
+	CRC32 fileCrc;
+	uint32_t fileSize = 0;
+	char buf[256];
+	int nRead;
+	while ((nRead = f->Read(buf, ARRAY_SIZE(buf))) > 0)
+	{
+		fileCrc.Update(buf, nRead);
+		fileSize += nRead;
+	}
+	f->Close();
+	if (nRead != 0)
+	{
+		return false;
+	}
+	signature.printf("%" PRIu32 " %08" PRIx32, fileSize, fileCrc.Get());
+	return true;
+}
+
 // Return true if the daemon is busy running config.g or a trigger file
 bool GCodes::IsDaemonBusy() const
 {
@@ -267,10 +331,12 @@ void GCodes::Spin()
 	CheckTriggers();
 	CheckHeaterFault();
 	CheckFilament();
+	CheckUploadedFileSimulation();
 
 	// Get the GCodeBuffer that we want to process a command from. Give priority to auto-pause.
-	GCodeBuffer *gbp = autoPauseGCode;
-	if (gbp->IsCompletelyIdle() && !(gbp->MachineState().fileState.IsLive()))
+	// While we are running the config file at startup nothing else can be active, so don't waste time polling the other sources.
+	GCodeBuffer *gbp = (runningConfigFile) ? daemonGCode : autoPauseGCode;
+	if (!runningConfigFile && gbp->IsCompletelyIdle() && !(gbp->MachineState().fileState.IsLive()))
 	{
 		gbp = gcodeSources[nextGcodeSource];
 		++nextGcodeSource;											// move on to the next gcode source ready for next time
@@ -790,6 +856,27 @@ void GCodes::RunStateMachine(GCodeBuffer& gb, StringRef& reply)
 			}
 			reprap.GetMove().AccessHeightMap().SetGridHeight(gridXindex, gridYindex, heightError);
 
+			if (probingOnTheFly)
+			{
+				// Calibrate the probe reading against height by lifting the head slowly from where the probe triggered
+				SweepProbe& sweepProbe = reprap.GetMove().AccessSweepProbe();
+				sweepProbe.StartCalibration(moveBuffer.coords[Z_AXIS], sweepCalibrationRange);
+				sweepProbe.SetSampling(true);
+				moveBuffer.moveType = 0;
+				moveBuffer.isCoordinated = false;
+				moveBuffer.endStopsToCheck = 0;
+				moveBuffer.usePressureAdvance = false;
+				moveBuffer.filePos = noFilePosition;
+				moveBuffer.coords[Z_AXIS] += sweepCalibrationRange;
+				moveBuffer.feedRate = platform.GetCurrentZProbeParameters().probeSpeed;
+				moveBuffer.xAxes = DefaultXAxisMapping;
+				moveBuffer.yAxes = DefaultYAxisMapping;
+				totalSegments = 1;
+				segmentsLeft = 1;
+				gb.SetState(GCodeState::gridSweeping1);
+				break;
+			}
+
 			// Move back up to the dive height
 			moveBuffer.moveType = 0;
 			moveBuffer.isCoordinated = false;
@@ -871,6 +958,173 @@ void GCodes::RunStateMachine(GCodeBuffer& gb, StringRef& reply)
 		gb.SetState(GCodeState::normal);
 		break;
 
+	// States used for probing the grid on the fly
+	case GCodeState::gridSweeping1:	// calibrating the probe at the first grid point
+		ProcessSweepSamples(true);
+		if (LockMovementAndWaitForStandstill(gb))
+		{
+			SweepProbe& sweepProbe = reprap.GetMove().AccessSweepProbe();
+			sweepProbe.SetSampling(false);
+			ProcessSweepSamples(true);
+			if (sweepProbe.FinishCalibration(reply))
+			{
+				platform.MessageF(ErrorMessage, "%s\n", reply.Pointer());
+				reply.Clear();
+				probingOnTheFly = false;
+				gb.SetState(GCodeState::normal);
+				if (!probeIsDeployed)
+				{
+					DoFileMacro(gb, RETRACTPROBE_G, false);
+				}
+				break;
+			}
+			gridYindex = 0;
+			gb.AdvanceState();
+		}
+		break;
+
+	case GCodeState::gridSweeping2:	// ready to move to the start of the next row
+		{
+			// Find the first and last points in this row that the probe can reach
+			Move& move = reprap.GetMove();
+			const GridDefinition& grid = move.AccessHeightMap().GetGrid();
+			const float y = grid.GetYCoordinate(gridYindex);
+			int firstXindex = -1, lastXindex = -1;
+			for (size_t xIndex = 0; xIndex < grid.NumXpoints(); ++xIndex)
+			{
+				const float x = grid.GetXCoordinate(xIndex);
+				if (grid.IsInRadius(x, y) && move.IsAccessibleProbePoint(x, y))
+				{
+					if (firstXindex < 0)
+					{
+						firstXindex = (int)xIndex;
+					}
+					lastXindex = (int)xIndex;
+				}
+			}
+			if (firstXindex < 0)
+			{
+				gb.SetState(GCodeState::gridSweeping5);
+				break;
+			}
+
+			// Sweep alternate rows in opposite directions. Start and finish the sweep far enough beyond the end points that the probe is at
+			// constant speed when it passes them, allowing for the acceleration having been reduced when the move was prepared.
+			const float speed = platform.GetZProbeTravelSpeed();
+			const float runIn = fsquare(speed)/platform.Acceleration(X_AXIS) + SweepBinFraction * grid.GetXSpacing();
+			const bool forwards = (gridYindex & 1) == 0;
+			float startX = (forwards) ? grid.GetXCoordinate(firstXindex) - runIn : grid.GetXCoordinate(lastXindex) + runIn;
+			float endX = (forwards) ? grid.GetXCoordinate(lastXindex) + runIn : grid.GetXCoordinate(firstXindex) - runIn;
+			if (!move.IsAccessibleProbePoint(startX, y))
+			{
+				startX = grid.GetXCoordinate((forwards) ? firstXindex : lastXindex);
+			}
+			if (!move.IsAccessibleProbePoint(endX, y))
+			{
+				endX = grid.GetXCoordinate((forwards) ? lastXindex : firstXindex);
+			}
+			const float xOffset = platform.GetCurrentZProbeParameters().xOffset;
+			sweepEndX = constrain<float>(endX - xOffset, platform.AxisMinimum(X_AXIS), platform.AxisMaximum(X_AXIS));
+
+			moveBuffer.moveType = 0;
+			moveBuffer.isCoordinated = false;
+			moveBuffer.endStopsToCheck = 0;
+			moveBuffer.usePressureAdvance = false;
+			moveBuffer.filePos = noFilePosition;
+			moveBuffer.coords[X_AXIS] = constrain<float>(startX - xOffset, platform.AxisMinimum(X_AXIS), platform.AxisMaximum(X_AXIS));
+			moveBuffer.coords[Y_AXIS] = y - platform.GetCurrentZProbeParameters().yOffset;
+			moveBuffer.coords[Z_AXIS] = move.AccessSweepProbe().GetSweepHeight();
+			moveBuffer.feedRate = speed;
+			moveBuffer.xAxes = DefaultXAxisMapping;
+			moveBuffer.yAxes = DefaultYAxisMapping;
+			totalSegments = 1;
+			segmentsLeft = 1;
+			gb.AdvanceState();
+		}
+		break;
+
+	case GCodeState::gridSweeping3:	// ready to sweep the current row
+		if (LockMovementAndWaitForStandstill(gb))
+		{
+			SweepProbe& sweepProbe = reprap.GetMove().AccessSweepProbe();
+			sweepProbe.StartRow();
+			sweepProbe.SetSampling(true);
+			moveBuffer.moveType = 0;
+			moveBuffer.isCoordinated = false;
+			moveBuffer.endStopsToCheck = 0;
+			moveBuffer.usePressureAdvance = false;
+			moveBuffer.filePos = noFilePosition;
+			moveBuffer.coords[X_AXIS] = sweepEndX;
+			moveBuffer.feedRate = platform.GetZProbeTravelSpeed();
+			moveBuffer.xAxes = DefaultXAxisMapping;
+			moveBuffer.yAxes = DefaultYAxisMapping;
+			totalSegments = 1;
+			segmentsLeft = 1;
+			gb.AdvanceState();
+		}
+		break;
+
+	case GCodeState::gridSweeping4:	// sweeping the current row
+		ProcessSweepSamples(false);
+		if (LockMovementAndWaitForStandstill(gb))
+		{
+			SweepProbe& sweepProbe = reprap.GetMove().AccessSweepProbe();
+			sweepProbe.SetSampling(false);
+			ProcessSweepSamples(false);
+			HeightMap& heightMap = reprap.GetMove().AccessHeightMap();
+			for (size_t xIndex = 0; xIndex < heightMap.GetGrid().NumXpoints(); ++xIndex)
+			{
+				float heightError;
+				if (sweepProbe.GetRowHeight(xIndex, heightError))
+				{
+					heightMap.SetGridHeight(xIndex, gridYindex, heightError);
+				}
+			}
+			gb.AdvanceState();
+		}
+		break;
+
+	case GCodeState::gridSweeping5:	// finished a row
+		++gridYindex;
+		if (gridYindex < reprap.GetMove().AccessHeightMap().GetGrid().NumYpoints())
+		{
+			gb.SetState(GCodeState::gridSweeping2);
+		}
+		else
+		{
+			// Move back up to the dive height
+			moveBuffer.moveType = 0;
+			moveBuffer.isCoordinated = false;
+			moveBuffer.endStopsToCheck = 0;
+			moveBuffer.usePressureAdvance = false;
+			moveBuffer.filePos = noFilePosition;
+			moveBuffer.coords[Z_AXIS] = platform.GetZProbeStartingHeight();
+			moveBuffer.feedRate = platform.GetZProbeTravelSpeed();
+			moveBuffer.xAxes = DefaultXAxisMapping;
+			moveBuffer.yAxes = DefaultYAxisMapping;
+			totalSegments = 1;
+			segmentsLeft = 1;
+			gb.AdvanceState();
+		}
+		break;
+
+	case GCodeState::gridSweeping6:	// finished all the rows
+		if (LockMovementAndWaitForStandstill(gb))
+		{
+			const uint32_t lostSamples = reprap.GetMove().AccessSweepProbe().GetAndClearLostSamples();
+			if (lostSamples != 0)
+			{
+				platform.MessageF(WarningMessage, "%" PRIu32 " Z probe samples were lost while probing on the fly\n", lostSamples);
+			}
+			probingOnTheFly = false;
+			gb.SetState(GCodeState::gridProbing6);
+			if (!probeIsDeployed)
+			{
+				DoFileMacro(gb, RETRACTPROBE_G, false);
+			}
+		}
+		break;
+
 	// States used for G30 probing
 	case GCodeState::probingAtPoint0:
 		// Initial state when executing G30 with a P parameter. Start by moving to the dive height at the current position.
@@ -1278,7 +1532,11 @@ void GCodes::StartNextGCode(GCodeBuffer& gb, StringRef& reply)
 			)
 	{
 		// USB interface. This line may be shared with a 3D scanner
-		serialInput->FillBuffer(serialGCode);
+		if (!serialInput->FillBuffer(serialGCode) && serialInput->BytesCached() == 0 && serialGCode->StartingNewCode())
+		{
+			FlushStreamingAcks();			// the host has nothing more for us at present, so acknowledge what we have done
+			serialGCode->RepeatResendIfTimedOut();
+		}
 	}
 	else if (&gb == auxGCode)
 	{
@@ -1424,6 +1682,109 @@ void GCodes::CheckTriggers()
 	}
 }
 
+// This is called when a file has been uploaded. If it is a GCode file and we have been asked to, simulate it when we are next idle so that we can
+// record in the file how long it will take to print. We only keep the most recent one.
+void GCodes::FileUploaded(const char *fileName)
+{
+	if (simulateUploadedFiles
+		&& (StringEndsWith(fileName, ".gcode") || StringEndsWith(fileName, ".g") || StringEndsWith(fileName, ".gco") || StringEndsWith(fileName, ".gc"))
+	   )
+	{
+		SafeStrncpy(uploadedFileToSimulate, fileName, ARRAY_SIZE(uploadedFileToSimulate));
+	}
+}
+
+// If an uploaded file is waiting to be simulated and the machine is idle, start simulating it using the daemon.
+// Don't do it if a file has been selected for printing, because the simulation would replace that selection.
+void GCodes::CheckUploadedFileSimulation()
+{
+	if (   uploadedFileToSimulate[0] != 0
+		&& simulationMode == 0
+		&& !reprap.GetPrintMonitor().IsPrinting()
+		&& !fileToPrint.IsLive()
+		&& !IsDaemonBusy()
+		&& daemonGCode->GetState() == GCodeState::normal
+		&& daemonGCode->IsCompletelyIdle()
+	   )
+	{
+		String<FILENAME_LENGTH + 10> command;
+		command.GetRef().printf("M37 P\"%s\"", uploadedFileToSimulate);
+		uploadedFileToSimulate[0] = 0;
+		simulatingUploadedFile = true;
+		daemonGCode->Put(command.c_str());
+	}
+}
+
+// Cancel any pending or running simulation of an uploaded file, because the user has asked to print a file.
+// Returns false if we are waiting for the simulated moves to finish and need to be called again.
+bool GCodes::CancelUploadedFileSimulation(GCodeBuffer& gb)
+{
+	uploadedFileToSimulate[0] = 0;
+	if (simulatingUploadedFile)
+	{
+		if (exitSimulationWhenFileComplete && fileGCode->OriginalMachineState().fileState.IsLive())
+		{
+			// The simulation is running, so abandon it without recording a simulated time
+			if (!LockMovementAndWaitForStandstill(gb) || !IsCodeQueueIdle())
+			{
+				return false;
+			}
+			StopPrint(false);
+		}
+		simulatingUploadedFile = false;			// if the daemon hasn't started the simulation yet, this makes it skip the M37 command
+	}
+	return true;
+}
+
+// Append the simulated print time to a file that we have just finished simulating, so that PrintMonitor can report it.
+// If we simulated the file before then the time we recorded then is the last line of the file, so we overwrite it instead.
+void GCodes::AppendSimulatedTime(const char *fileName, uint32_t seconds)
+{
+	static const char * const SimulatedTimeLine = "\n; Simulated print time:";
+
+	// Look for a simulated time line at the end of the file
+	FileStore *f = platform.GetFileStore(platform.GetGCodeDir(), fileName, OpenMode::read);
+	if (f == nullptr)
+	{
+		platform.MessageF(ErrorMessage, "Failed to record simulated print time in file %s\n", fileName);
+		return;
+	}
+
+	const FilePosition length = f->Length();
+	FilePosition writePos = length;
+	size_t oldLineLength = 0;
+	char tail[48];
+	const size_t tailLength = min<size_t>(length, ARRAY_UPB(tail));
+	if (f->Seek(length - tailLength) && f->Read(tail, tailLength) == (int)tailLength)
+	{
+		tail[tailLength] = 0;
+		const char * const pos = strstr(tail, SimulatedTimeLine);
+		if (pos != nullptr && strchr(pos + 1, '\n') == tail + tailLength - 1)
+		{
+			oldLineLength = tail + tailLength - pos;
+			writePos = length - oldLineLength;
+		}
+	}
+	f->Close();
+
+	// If the new line is shorter than the one it replaces, pad the number with spaces so that we overwrite the old line completely
+	const size_t fixedLength = strlen(SimulatedTimeLine) + 2;
+	const int width = (oldLineLength > fixedLength) ? oldLineLength - fixedLength : 0;
+	String<48> line;
+	line.GetRef().printf("%s %-*" PRIu32 "\n", SimulatedTimeLine, width, seconds);
+
+	f = platform.GetFileStore(platform.GetGCodeDir(), fileName, OpenMode::append);
+	if (f == nullptr || !f->Seek(writePos) || !f->Write(line.c_str()))
+	{
+		platform.MessageF(ErrorMessage, "Failed to record simulated print time in file %s\n", fileName);
+	}
+	if (f != nullptr)
+	{
+		f->Close();
+	}
+	platform.GetMassStorage()->UpdateCachedFileInfo(platform.GetGCodeDir(), fileName);
+}
+
 // Check for and respond to filament errors
 void GCodes::CheckFilament()
 {
@@ -2240,6 +2601,19 @@ bool GCodes::DoStraightMove(GCodeBuffer& gb, StringRef& reply, bool isCoordinate
 			const float xyLength = sqrtf(fsquare(currentUserPosition[X_AXIS] - initialX) + fsquare(currentUserPosition[Y_AXIS] - initialY));
 			const float moveTime = xyLength/moveBuffer.feedRate;			// this is a best-case time, often the move will take longer
 			totalSegments = (unsigned int)max<int>(1, min<int>(rintf(xyLength/kin.GetMinSegmentLength()), rintf(moveTime * kin.GetSegmentsPerSecond())));
+#if SUPPORT_SEGMENT_FREE_JOINTS
+			if (isCoordinated && kin.GetMotionType(X_AXIS) == MotionType::segmentFreeJoint)
+			{
+				// The movement code follows the joint trajectory through several knots in each move, so we need fewer moves.
+				// The knots are not bed compensated, so if we are using the mesh we still need the segments to be smaller than the mesh spacing.
+				totalSegments = (totalSegments + MaxJointSegments - 1)/MaxJointSegments;
+				if (reprap.GetMove().IsUsingMesh())
+				{
+					const HeightMap& heightMap = reprap.GetMove().AccessHeightMap();
+					totalSegments = max<unsigned int>(totalSegments, heightMap.GetMinimumSegments(currentUserPosition[X_AXIS] - initialX, currentUserPosition[Y_AXIS] - initialY));
+				}
+			}
+#endif
 		}
 		else if (reprap.GetMove().IsUsingMesh())
 		{
@@ -2877,8 +3251,9 @@ bool GCodes::DefineGrid(GCodeBuffer& gb, StringRef &reply)
 }
 
 // Start probing the grid, returning true if we didn't because of an error.
+// If onTheFly is true then we probe the first point normally and sweep the probe along the rows to get the other heights.
 // Prior to calling this the movement system must be locked.
-GCodeResult GCodes::ProbeGrid(GCodeBuffer& gb, StringRef& reply)
+GCodeResult GCodes::ProbeGrid(GCodeBuffer& gb, StringRef& reply, bool onTheFly)
 {
 	if (!defaultGrid.IsValid())
 	{
@@ -2892,6 +3267,25 @@ GCodeResult GCodes::ProbeGrid(GCodeBuffer& gb, StringRef& reply)
 		return GCodeResult::error;
 	}
 
+	probingOnTheFly = onTheFly;
+	if (onTheFly)
+	{
+		if (platform.GetZProbeType() < 1 || platform.GetZProbeType() > 3)
+		{
+			reply.copy("Probing on the fly needs an analog Z probe (type 1, 2 or 3)");
+			return GCodeResult::error;
+		}
+		sweepCalibrationRange = DefaultSweepCalibrationRange;
+		bool dummy = false;
+		gb.TryGetFValue('H', sweepCalibrationRange, dummy);
+		if (sweepCalibrationRange <= 0.0 || sweepCalibrationRange > platform.GetZProbeDiveHeight())
+		{
+			probingOnTheFly = false;
+			reply.copy("Calibration height range must be greater than zero and no more than the probe dive height");
+			return GCodeResult::error;
+		}
+	}
+
 	Move& move = reprap.GetMove();
 	move.AccessHeightMap().SetGrid(defaultGrid);
 	move.AccessHeightMap().ClearGridHeights();
@@ -2906,6 +3300,36 @@ GCodeResult GCodes::ProbeGrid(GCodeBuffer& gb, StringRef& reply)
 	return GCodeResult::ok;
 }
 
+// Fetch the Z probe samples taken while probing on the fly. While calibrating we add them to the calibration table.
+// Otherwise we convert them to trigger heights and bin them into the nearest grid points of the row we are sweeping.
+void GCodes::ProcessSweepSamples(bool calibrating)
+{
+	SweepProbe& sweepProbe = reprap.GetMove().AccessSweepProbe();
+	const GridDefinition& grid = reprap.GetMove().AccessHeightMap().GetGrid();
+	const float xOffset = platform.GetCurrentZProbeParameters().xOffset;
+	SweepSample sample;
+	while (sweepProbe.GetSample(sample))
+	{
+		if (calibrating)
+		{
+			sweepProbe.AddCalibrationSample(sample);
+			continue;
+		}
+
+		const float x = sample.coords[X_AXIS] + xOffset;
+		const int xIndex = lrintf((x - grid.GetXCoordinate(0))/grid.GetXSpacing());
+		float triggerHeight;
+		if (   xIndex >= 0 && xIndex < (int)grid.NumXpoints()
+			&& fabsf(x - grid.GetXCoordinate(xIndex)) <= SweepBinFraction * grid.GetXSpacing()
+			&& grid.IsInRadius(grid.GetXCoordinate(xIndex), grid.GetYCoordinate(gridYindex))
+			&& sweepProbe.GetTriggerHeight(sample, triggerHeight)
+		   )
+		{
+			sweepProbe.AddRowSample(xIndex, triggerHeight - platform.ZProbeStopHeight());
+		}
+	}
+}
+
 bool GCodes::LoadHeightMap(GCodeBuffer& gb, StringRef& reply) const
 {
 	reprap.GetMove().SetIdentityTransform();					// stop using old-style bed compensation and clear the height map
@@ -3032,6 +3456,10 @@ bool GCodes::OpenFileToWrite(GCodeBuffer& gb, const char* directory, const char*
 	}
 	else
 	{
+		if (size != 0)
+		{
+			(void)fileBeingWritten->PreAllocate(size);		// so that the file is contiguous and quick to read
+		}
 		gb.SetCRC32(fileCRC32);
 		gb.SetBinaryWriting(binaryWrite);
 		gb.SetWritingFileDirectory(directory);
@@ -3521,6 +3949,11 @@ void GCodes::SaveFanSpeeds()
 // Note that 'reply' may be empty. If it isn't, then we need to append newline when sending it.
 void GCodes::HandleReply(GCodeBuffer& gb, bool error, const char* reply)
 {
+	if (error && runningConfigFile && &gb == daemonGCode)
+	{
+		++configErrors;
+	}
+
 	// Don't report "ok" responses if a (macro) file is being processed
 	// Also check that this response was triggered by a gcode
 	if ((gb.MachineState().doingFileMacro || &gb == fileGCode) && reply[0] == 0)
@@ -3535,6 +3968,11 @@ void GCodes::HandleReply(GCodeBuffer& gb, bool error, const char* reply)
 		return;
 	}
 
+	if (HandleStreamingReply(gb, error, reply, nullptr))
+	{
+		return;
+	}
+
 	const Compatibility c = (&gb == serialGCode || &gb == telnetGCode) ? platform.Emulating() : me;
 	const MessageType type = gb.GetResponseMessageType();
 	const char* const response = (gb.GetCommandLetter() == 'M' && gb.GetCommandNumber() == 998) ? "rs " : "ok";
@@ -3592,6 +4030,11 @@ void GCodes::HandleReply(GCodeBuffer& gb, bool error, const char* reply)
 
 void GCodes::HandleReply(GCodeBuffer& gb, bool error, OutputBuffer *reply)
 {
+	if (error && runningConfigFile && &gb == daemonGCode)
+	{
+		++configErrors;
+	}
+
 	// Although unlikely, it's possible that we get a nullptr reply. Don't proceed if this is the case
 	if (reply == nullptr)
 	{
@@ -3605,6 +4048,11 @@ void GCodes::HandleReply(GCodeBuffer& gb, bool error, OutputBuffer *reply)
 		return;
 	}
 
+	if (HandleStreamingReply(gb, error, nullptr, reply))
+	{
+		return;
+	}
+
 	const Compatibility c = (&gb == serialGCode || &gb == telnetGCode) ? platform.Emulating() : me;
 	const MessageType type = gb.GetResponseMessageType();
 	const char* const response = (gb.Seen('M') && gb.GetIValue() == 998) ? "rs " : "ok";
@@ -3688,6 +4136,76 @@ void GCodes::HandleReply(GCodeBuffer& gb, bool error, OutputBuffer *reply)
 	}
 }
 
+// Reply to a command received on the USB port using the streaming protocol, returning true if we handled it.
+// In this mode the host sends numbered lines ahead without waiting for each one to be acknowledged. Instead of sending "ok" after
+// each command we send "ok N<line> B<credits>" after a batch of them, meaning that every line up to and including <line> has been
+// completed and the host may have up to <credits> lines outstanding beyond that one. Any other reply is sent immediately, followed
+// by an acknowledgement. Lost or corrupted lines are reported as "Resend: <line>", after which the host must resend from that line.
+// The host must start the sequence with M110. Numbered lines received before that are answered with an error asking for M110.
+bool GCodes::HandleStreamingReply(GCodeBuffer& gb, bool error, const char *reply, OutputBuffer *replyBuffer)
+{
+	if (&gb != serialGCode || !gb.IsStreaming() || gb.IsDoingFileMacro())
+	{
+		return false;
+	}
+
+	const MessageType type = gb.GetResponseMessageType();
+	if (gb.GetCommandLetter() == 'M' && gb.GetCommandNumber() == 998)
+	{
+		OutputBuffer::ReleaseAll(replyBuffer);
+		FlushStreamingAcks();
+		if (gb.Seen('P'))
+		{
+			platform.MessageF(type, "Resend: %" PRIi32 "\n", gb.GetIValue());
+		}
+		else
+		{
+			platform.Message((MessageType)(type | ErrorMessageFlag), "Send M110 to start the line sequence\n");
+		}
+		return true;
+	}
+
+	bool flushNow = error;
+	if (replyBuffer != nullptr)
+	{
+		if (replyBuffer->Length() != 0)
+		{
+			if (error)
+			{
+				platform.Message(type, "Error: ");
+			}
+			platform.Message(type, replyBuffer);
+			flushNow = true;
+		}
+		else
+		{
+			OutputBuffer::ReleaseAll(replyBuffer);
+		}
+	}
+	else if (reply[0] != 0)
+	{
+		platform.MessageF((error) ? (MessageType)(type | ErrorMessageFlag) : type, "%s\n", reply);
+		flushNow = true;
+	}
+
+	++streamingAcksPending;
+	if (flushNow || streamingAcksPending >= StreamingAckBatch)
+	{
+		FlushStreamingAcks();
+	}
+	return true;
+}
+
+// Acknowledge all the streamed lines that we have completed. Called when we have a batch of them or when the host has stopped sending.
+void GCodes::FlushStreamingAcks()
+{
+	if (streamingAcksPending != 0)
+	{
+		platform.MessageF(serialGCode->GetResponseMessageType(), "ok N%u B%u\n", serialGCode->GetLastLineNumber(), StreamingLineCredits);
+		streamingAcksPending = 0;
+	}
+}
+
 // Set PID parameters (M301 or M304 command). 'heater' is the default heater number to use.
 void GCodes::SetPidParameters(GCodeBuffer& gb, int heater, StringRef& reply)
 {
@@ -4022,12 +4540,18 @@ void GCodes::StopPrint(bool normalCompletion)
 	if (exitSimulationWhenFileComplete)
 	{
 		exitSimulationWhenFileComplete = false;
+		simulatingUploadedFile = false;
 		simulationMode = 0;
 		reprap.GetMove().Simulate(simulationMode);
 		EndSimulation(nullptr);
-		const uint32_t simMinutes = lrintf((reprap.GetMove().GetSimulationTime() + simulationTime)/60.0);
+		const uint32_t simSeconds = lrintf(reprap.GetMove().GetSimulationTime() + simulationTime);
+		const uint32_t simMinutes = (simSeconds + 30u)/60u;
 		platform.MessageF(LoggedGenericMessage, "File %s will print in %" PRIu32 "h %" PRIu32 "m plus heating time\n",
 								printingFilename, simMinutes/60u, simMinutes % 60u);
+		if (normalCompletion && reprap.GetPrintMonitor().IsPrinting())
+		{
+			AppendSimulatedTime(printingFilename, simSeconds);
+		}
 	}
 	else if (reprap.GetPrintMonitor().IsPrinting())
 	{
@@ -4301,6 +4825,155 @@ void GCodes::SetAllAxesNotHomed()
 	axesHomed = 0;
 }
 
+// Write a snapshot of the config file that was run at startup, returning true if an error occurred.
+// The snapshot holds the commands of the config file with comments and redundant white space removed, preceded by a header that
+// identifies the firmware version and the size and CRC of the config file. At startup we run the snapshot instead of the config file
+// if the header matches. We only allow a snapshot to be written if the config file ran without errors and hasn't changed since.
+// Macro files called from the config file using M98 are not copied into the snapshot, so they are still read when it runs.
+bool GCodes::WriteConfigSnapshotFile(StringRef& reply)
+{
+	char currentSignatureBuffer[ARRAY_SIZE(startupConfigSignature)];
+	StringRef currentSignature(currentSignatureBuffer, ARRAY_SIZE(currentSignatureBuffer));
+	if (startupConfigFile == nullptr || !GetConfigFileSignature(startupConfigFile, currentSignature))
+	{
+		reply.copy("No config file was run at startup");
+		return true;
+	}
+	if (!StringEquals(currentSignature.Pointer(), startupConfigSignature))
+	{
+		reply.printf("File %s has changed since startup", startupConfigFile);
+		return true;
+	}
+	if (configErrors != 0)
+	{
+		reply.printf("File %s reported %u error(s) at startup", startupConfigFile, configErrors);
+		return true;
+	}
+
+	FileStore * const in = platform.GetFileStore(platform.GetSysDir(), startupConfigFile, OpenMode::read);
+	if (in == nullptr)
+	{
+		reply.printf("Failed to open file %s", startupConfigFile);
+		return true;
+	}
+	FileStore * const out = platform.GetFileStore(platform.GetSysDir(), CONFIG_SNAPSHOT_G, OpenMode::write);
+	if (out == nullptr)
+	{
+		in->Close();
+		reply.printf("Failed to create file %s", CONFIG_SNAPSHOT_G);
+		return true;
+	}
+
+	char headerBuffer[80];
+	StringRef header(headerBuffer, ARRAY_SIZE(headerBuffer));
+	header.printf("; config snapshot %s %s\n", VERSION, startupConfigSignature);
+	bool ok = out->Write(header.Pointer());
+
+	// Copy the commands, dropping comments, blank lines and white space that isn't needed to separate parameters or inside quoted strings
+	enum class CopyState : uint8_t { normal, quoted, bracketedComment, discarding } state = CopyState::normal;
+	char line[GCODE_LENGTH + 1];
+	size_t lineLength = 0;
+	bool pendingSpace = false;
+	char buf[256];
+	int nRead;
+	while (ok && (nRead = in->Read(buf, ARRAY_SIZE(buf))) > 0)
+	{
+		for (int i = 0; ok && i < nRead; ++i)
+		{
+			const char c = buf[i];
+			if (c == '\n' || c == '\r')
+			{
+				if (lineLength != 0)
+				{
+					line[lineLength++] = '\n';
+					ok = out->Write(line, lineLength);
+				}
+				lineLength = 0;
+				pendingSpace = false;
+				state = CopyState::normal;
+				continue;
+			}
+
+			CopyState newState = state;
+			switch (state)
+			{
+			case CopyState::normal:
+				if (c == ';')
+				{
+					state = CopyState::discarding;
+					continue;
+				}
+				if (c == '(')
+				{
+					state = CopyState::bracketedComment;
+					continue;
+				}
+				if (c == ' ' || c == '\t')
+				{
+					pendingSpace = (lineLength != 0);
+					continue;
+				}
+				if (c == '"')
+				{
+					newState = CopyState::quoted;
+				}
+				break;
+
+			case CopyState::quoted:
+				if (c == '"')
+				{
+					newState = CopyState::normal;
+				}
+				break;
+
+			case CopyState::bracketedComment:
+				if (c == ')')
+				{
+					state = CopyState::normal;
+				}
+				continue;
+
+			case CopyState::discarding:
+				continue;
+			}
+
+			if (lineLength + 3 > ARRAY_SIZE(line))			// allow for a pending space and the newline
+			{
+				reply.printf("Line too long in file %s", startupConfigFile);
+				ok = false;
+				break;
+			}
+			if (pendingSpace)
+			{
+				line[lineLength++] = ' ';
+				pendingSpace = false;
+			}
+			line[lineLength++] = c;
+			state = newState;
+		}
+	}
+	if (ok && lineLength != 0)
+	{
+		line[lineLength++] = '\n';
+		ok = out->Write(line, lineLength);
+	}
+
+	in->Close();
+	if (!out->Close())
+	{
+		ok = false;
+	}
+	if (!ok)
+	{
+		if (reply.strlen() == 0)
+		{
+			reply.printf("Failed to write file %s", CONFIG_SNAPSHOT_G);
+		}
+		platform.GetMassStorage()->Delete(platform.GetSysDir(), CONFIG_SNAPSHOT_G);
+	}
+	return !ok;
+}
+
 // Write the config-override file returning true if an error occurred
 bool GCodes::WriteConfigOverrideFile(StringRef& reply, const char *fileName) const
 {
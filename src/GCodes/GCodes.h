@@ -139,7 +139,12 @@ public:
 	void Diagnostics(MessageType mtype);								// Send helpful information out
 
 	bool RunConfigFile(const char* fileName);							// Start running the config file
+	bool ConfigSnapshotValid(const char* configFile);					// Return true if we have a snapshot of the config file that can be run instead of it
 	bool IsDaemonBusy() const;											// Return true if the daemon is busy running config.g or a trigger file
+	bool IsSimulatingFile() const { return exitSimulationWhenFileComplete; }	// Return true if we are simulating a whole file to find out how long it will take
+	void FileUploaded(const char *fileName);							// Called when a file has been uploaded, to simulate it if we have been asked to
+
+	static constexpr const char* CONFIG_SNAPSHOT_G = "config-snapshot.g";	// Condensed copy of config.g that we run instead of it if it is up to date
 
 	bool GetAxisIsHomed(unsigned int axis) const						// Has the axis been homed?
 		{ return IsBitSet(axesHomed, axis); }
@@ -283,6 +288,9 @@ private:
 	void ListTriggers(StringRef reply, TriggerInputsBitmap mask);		// Append a list of trigger inputs to a message
 	void CheckTriggers();												// Check for and execute triggers
 	void CheckFilament();												// Check for and respond to filament errors
+	void CheckUploadedFileSimulation();									// Start simulating an uploaded file if one is waiting and we are idle
+	bool CancelUploadedFileSimulation(GCodeBuffer& gb);					// Cancel any pending or running simulation of an uploaded file
+	void AppendSimulatedTime(const char *fileName, uint32_t seconds);	// Record the simulated print time at the end of a file
 	void CheckHeaterFault();											// Check for and respond to a heater fault, returning true if we should exit
 	void DoEmergencyStop();												// Execute an emergency stop
 
@@ -299,11 +307,17 @@ private:
 	bool DefineGrid(GCodeBuffer& gb, StringRef &reply);					// Define the probing grid, returning true if error
 	bool LoadHeightMap(GCodeBuffer& gb, StringRef& reply) const;		// Load the height map from file
 	bool SaveHeightMap(GCodeBuffer& gb, StringRef& reply) const;		// Save the height map to file
-	GCodeResult ProbeGrid(GCodeBuffer& gb, StringRef& reply);			// Start probing the grid, returning true if we didn't because of an error
+	GCodeResult ProbeGrid(GCodeBuffer& gb, StringRef& reply, bool onTheFly);	// Start probing the grid, returning true if we didn't because of an error
+	void ProcessSweepSamples(bool calibrating);							// Use the Z probe samples taken while probing the grid on the fly
 
 	bool WriteConfigOverrideFile(StringRef& reply, const char *fileName) const; // Write the config-override file
+	bool WriteConfigSnapshotFile(StringRef& reply);						// Write the config snapshot file, returning true if an error occurred
+	bool GetConfigFileSignature(const char *fileName, StringRef& signature) const;	// Describe the size and CRC of a file in the system directory
 	void CopyConfigFinalValues(GCodeBuffer& gb);						// Copy the feed rate etc. from the daemon to the input channels
 
+	bool HandleStreamingReply(GCodeBuffer& gb, bool error, const char *reply, OutputBuffer *replyBuffer);	// Reply to a command sent using the streaming protocol
+	void FlushStreamingAcks();											// Acknowledge all the streamed lines that we have completed
+
 	void ClearBabyStepping() { currentBabyStepZOffset = 0.0; }
 
 	MessageType GetMessageBoxDevice(GCodeBuffer& gb) const;				// Decide which device to display a message box on
@@ -346,6 +360,10 @@ private:
 	bool isPaused;								// true if the print has been paused manually or automatically
 	bool pausePending;							// true if we have been asked to pause but we are running a macro
 	bool runningConfigFile;						// We are running config.g during the startup process
+	const char *startupConfigFile;				// The config file that was run at startup, or nullptr if none
+	char startupConfigSignature[40];			// The size and CRC32 of the config file that was run at startup
+	unsigned int configErrors;					// The number of commands in the config file that reported errors at startup
+	unsigned int streamingAcksPending;			// The number of completed streamed lines on the USB port that we haven't acknowledged yet
 	bool doingToolChange;						// We are running tool change macros
 
 #if HAS_VOLTAGE_MONITOR
@@ -420,12 +438,18 @@ private:
 	uint32_t lastProbedTime;					// time in milliseconds that the probe was last triggered
 	volatile bool zProbeTriggered;				// Set by the step ISR when a move is aborted because the Z probe is triggered
 	size_t gridXindex, gridYindex;				// Which grid probe point is next
+	bool probingOnTheFly;						// true if G29 S3 is sweeping the probe along the rows of the grid
+	float sweepCalibrationRange;				// the height range over which G29 S3 calibrates the Z probe reading
+	float sweepEndX;							// the X coordinate of the end of the row that G29 S3 is sweeping
 	bool doingManualBedProbe;					// true if we are waiting for the user to jog the nozzle until it touches the bed
 	bool probeIsDeployed;						// true if M401 has been used to deploy the probe and M402 has not yet been used t0 retract it
 
 	float simulationTime;						// Accumulated simulation time
 	uint8_t simulationMode;						// 0 = not simulating, 1 = simulating, >1 are simulation modes for debugging
 	bool exitSimulationWhenFileComplete;		// true if simulating a file
+	bool simulateUploadedFiles;					// true if we simulate each GCode file when it has been uploaded, to record how long it will take to print
+	char uploadedFileToSimulate[FILENAME_LENGTH];	// the uploaded file that is waiting to be simulated, or empty
+	bool simulatingUploadedFile;				// true from when we ask the daemon to simulate an uploaded file until that simulation ends or is cancelled
 
 	// Firmware retraction settings
 	float retractLength, retractExtra;			// retraction length and extra length to un-retract
@@ -176,7 +176,8 @@ bool GCodes::HandleGcode(GCodeBuffer& gb, StringRef& reply)
 			switch(sparam)
 			{
 			case 0:		// probe and save height map
-				result = ProbeGrid(gb, reply);
+			case 3:		// probe on the fly and save height map
+				result = ProbeGrid(gb, reply, sparam == 3);
 				break;
 
 			case 1:		// load height map file
@@ -456,7 +457,15 @@ bool GCodes::HandleMcode(GCodeBuffer& gb, StringRef& reply)
 
 			if (sparam == 2)
 			{
-				fileResponse = reprap.GetFilesResponse(dir.Pointer(), true);		// Send the file list in JSON format
+				// If the R parameter is given then we return one page of the listing starting at that directory entry
+				const bool paged = gb.Seen('R');
+				const unsigned int startAt = (paged) ? gb.GetUIValue() : 0;
+				fileResponse = reprap.GetFilesResponse(dir.Pointer(), startAt, (paged) ? DefaultFileListPageSize : 0, true);	// Send the file list in JSON format
+				if (fileResponse == nullptr)
+				{
+					// Cannot allocate an output buffer, try again later
+					return false;
+				}
 				fileResponse->cat('\n');
 			}
 			else
@@ -533,6 +542,12 @@ bool GCodes::HandleMcode(GCodeBuffer& gb, StringRef& reply)
 
 	case 23: // Set file to print
 	case 32: // Select file and start SD print
+		// If we are simulating an uploaded file, or about to, then the user's choice of file to print takes priority
+		if (&gb != fileGCode && !CancelUploadedFileSimulation(gb))
+		{
+			return false;
+		}
+
 		// We now allow a file that is being printed to chain to another file. This is required for the resume-after-power-fail functionality.
 		if (fileGCode->OriginalMachineState().fileState.IsLive() && (&gb) != fileGCode)
 		{
@@ -781,9 +796,21 @@ bool GCodes::HandleMcode(GCodeBuffer& gb, StringRef& reply)
 			uint32_t newSimulationMode;
 			String<FILENAME_LENGTH> simFileName;
 
+			bool seenUploads = false;
+			uint32_t simulateUploads;
+			gb.TryGetUIValue('U', simulateUploads, seenUploads);
+			if (seenUploads)
+			{
+				simulateUploadedFiles = (simulateUploads != 0);
+			}
+
 			gb.TryGetPossiblyQuotedString('P', simFileName.GetRef(), seen);
 			if (seen)
 			{
+				if (&gb == daemonGCode && gb.MachineState().previous == nullptr && !simulatingUploadedFile)
+				{
+					break;						// this was an uploaded file simulation that M23 or M32 has cancelled
+				}
 				newSimulationMode = 1;			// default to simulation mode 1 when a filename is given
 			}
 			else
@@ -840,15 +867,17 @@ bool GCodes::HandleMcode(GCodeBuffer& gb, StringRef& reply)
 					else
 					{
 						simulationMode = 0;
+						simulatingUploadedFile = false;
 						reprap.GetMove().Simulate(0);
 						result = GCodeResult::error;
 					}
 				}
 			}
-			else
+			else if (!seenUploads)
 			{
-				reply.printf("Simulation mode: %s, move time: %.1f sec, other time: %.1f sec",
-						(simulationMode != 0) ? "on" : "off", (double)reprap.GetMove().GetSimulationTime(), (double)simulationTime);
+				reply.printf("Simulation mode: %s, move time: %.1f sec, other time: %.1f sec, simulate uploaded files: %s",
+						(simulationMode != 0) ? "on" : "off", (double)reprap.GetMove().GetSimulationTime(), (double)simulationTime,
+						(simulateUploadedFiles) ? "yes" : "no");
 			}
 		}
 		break;
@@ -1981,6 +2010,18 @@ bool GCodes::HandleMcode(GCodeBuffer& gb, StringRef& reply)
 		break;
 
 	case 303: // Run PID tuning
+		if (gb.Seen('B'))
+		{
+			// Set the total PWM of the heaters that we heat at the same time when auto tuning. This may be combined with H to start tuning.
+			const float budget = gb.GetFValue();
+			if (budget < 0.1)
+			{
+				reply.copy("Invalid power budget in M303 command");
+				break;
+			}
+			reprap.GetHeat().SetTuningPowerBudget(budget);
+		}
+
 		if (gb.Seen('H'))
 		{
 			const int heater = gb.GetIValue();
@@ -2006,7 +2047,7 @@ bool GCodes::HandleMcode(GCodeBuffer& gb, StringRef& reply)
 				reprap.GetHeat().StartAutoTune(heater, temperature, maxPwm, reply);
 			}
 		}
-		else
+		else if (!gb.Seen('B'))
 		{
 			reprap.GetHeat().GetAutoTuneStatus(reply);
 		}
@@ -2383,6 +2424,20 @@ bool GCodes::HandleMcode(GCodeBuffer& gb, StringRef& reply)
 		}
 		break;
 
+	case 508: // Save or delete the snapshot of config.g that is used to speed up startup
+		if (gb.Seen('S') && gb.GetIValue() == 0)
+		{
+			if (platform.GetMassStorage()->FileExists(platform.GetSysDir(), CONFIG_SNAPSHOT_G))
+			{
+				result = GetGCodeResultFromError(!platform.GetMassStorage()->Delete(platform.GetSysDir(), CONFIG_SNAPSHOT_G));
+			}
+		}
+		else
+		{
+			result = GetGCodeResultFromError(WriteConfigSnapshotFile(reply));
+		}
+		break;
+
 	case 540: // Set/report MAC address
 		if (gb.Seen('P'))
 		{
@@ -2932,20 +2987,57 @@ bool GCodes::HandleMcode(GCodeBuffer& gb, StringRef& reply)
 		if (gb.Seen('S'))
 		{
 			const float advance = gb.GetFValue();
+
+			// Optionally the pressure advance may depend on the extrusion rate. R gives the rates in mm/sec of filament and T the pressure advance at each one.
+			float rates[MaxPressureAdvancePoints], advances[MaxPressureAdvancePoints];
+			size_t numRates = 0, numAdvances = 0;
+			if (gb.Seen('R'))
+			{
+				numRates = MaxPressureAdvancePoints;
+				gb.GetFloatArray(rates, numRates, false);
+				if (gb.Seen('T'))
+				{
+					numAdvances = MaxPressureAdvancePoints;
+					gb.GetFloatArray(advances, numAdvances, false);
+				}
+				if (numAdvances != numRates)
+				{
+					reply.copy("R and T parameters must have the same number of values");
+					result = GCodeResult::error;
+					break;
+				}
+				if (Platform::CheckPressureAdvanceTable(rates, advances, numRates))
+				{
+					reply.copy("Pressure advance rates must be positive and increasing");
+					result = GCodeResult::error;
+					break;
+				}
+			}
+
 			if (gb.Seen('D'))
 			{
 				long int eDrive[MaxExtruders];
 				size_t eCount = MaxExtruders;
 				gb.GetLongArray(eDrive, eCount);
-				for (size_t i = 0; i < eCount; i++)
+
+				// Check all the parameters before we change anything, so that a bad command leaves the settings as they were
+				bool ok = true;
+				for (size_t i = 0; ok && i < eCount; i++)
 				{
 					if (eDrive[i] < 0 || (size_t)eDrive[i] >= numExtruders)
 					{
 						reply.printf("Invalid extruder number '%ld'", eDrive[i]);
 						result = GCodeResult::error;
-						break;
+						ok = false;
 					}
+				}
+				for (size_t i = 0; ok && i < eCount; i++)
+				{
 					platform.SetPressureAdvance(eDrive[i], advance);
+					if (numRates != 0)
+					{
+						(void)platform.SetPressureAdvanceTable(eDrive[i], rates, advances, numRates);		// we have already checked the table
+					}
 				}
 			}
 		}
@@ -2956,6 +3048,12 @@ bool GCodes::HandleMcode(GCodeBuffer& gb, StringRef& reply)
 			for (size_t i = 0; i < numExtruders; ++i)
 			{
 				reply.catf("%c %.3f", c, (double)platform.GetPressureAdvance(i));
+				const float *rates, *advances;
+				const size_t numPoints = platform.GetPressureAdvanceTable(i, rates, advances);
+				for (size_t j = 0; j < numPoints; ++j)
+				{
+					reply.catf(" %.3f@%.1fmm/s", (double)advances[j], (double)rates[j]);
+				}
 				c = ',';
 			}
 		}
@@ -3038,6 +3136,7 @@ bool GCodes::HandleMcode(GCodeBuffer& gb, StringRef& reply)
 					switch (chan)
 					{
 					case 0:
+						FlushStreamingAcks();			// in case we are leaving streaming mode
 						serialGCode->SetCommsProperties(val);
 						break;
 					case 1:
@@ -3051,7 +3150,11 @@ bool GCodes::HandleMcode(GCodeBuffer& gb, StringRef& reply)
 				if (!seen)
 				{
 					uint32_t cp = platform.GetCommsProperties(chan);
-					reply.printf("Channel %d: baud rate %" PRIu32 ", %s checksum", chan, platform.GetBaudRate(chan), (cp & 1) ? "requires" : "does not require");
+					reply.printf("Channel %d: baud rate %" PRIu32 ", %s checksum", chan, platform.GetBaudRate(chan), (cp & 5) ? "requires" : "does not require");
+					if (chan == 0 && (cp & 4) != 0)
+					{
+						reply.catf(", streaming with %u line credits", StreamingLineCredits);
+					}
 				}
 			}
 		}
@@ -3755,6 +3858,44 @@ bool GCodes::HandleMcode(GCodeBuffer& gb, StringRef& reply)
 		// TODO: We may need this code later to restrict specific filaments to certain tools or to reset filament counters.
 		break;
 
+	case 594: // Configure dynamic acceleration adjustment and S-curve acceleration to reduce ringing
+		{
+			bool seen = false;
+			if (gb.Seen('F'))
+			{
+				seen = true;
+				const float freq = gb.GetFValue();
+				if (freq == 0.0)
+				{
+					reprap.GetMove().SetShapingFrequency(0.0);
+				}
+				else if (freq >= MinimumShapingFrequency && freq <= MaximumShapingFrequency)
+				{
+					reprap.GetMove().SetShapingFrequency(freq);
+				}
+				else
+				{
+					reply.printf("Ringing frequency must be 0 (disabled) or between %.1f and %.1fHz", (double)MinimumShapingFrequency, (double)MaximumShapingFrequency);
+					result = GCodeResult::error;
+				}
+			}
+			if (gb.Seen('J'))
+			{
+				seen = true;
+#if SUPPORT_SCURVE
+				reprap.GetMove().SetMaxJerk(gb.GetFValue());
+#else
+				reply.copy("S-curve acceleration is not supported on this hardware");
+				result = GCodeResult::error;
+#endif
+			}
+			if (!seen)
+			{
+				reprap.GetMove().ReportShaping(reply);
+			}
+		}
+		break;
+
 	case 665: // Set delta configuration
 		if (!LockMovementAndWaitForStandstill(gb))
 		{
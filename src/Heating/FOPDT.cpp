@@ -127,4 +127,121 @@ void FopDt::CalcPidConstants()
 	pidParametersOverridden = false;
 }
 
+//*************************************************************************************************
+// FopDtIdentifier class implementation
+
+const float InitialCovariance = 1000.0;		// initial covariance of the estimators, large because we know nothing about the parameters to begin with
+const float ModelSettledTolerance = 0.005;	// the fractional change in G and tc between updates below which we consider the model to be settling
+
+void FopDtIdentifier::Start(float pStartTemp, float pInterval)
+{
+	startTemp = lastTemp = pStartTemp;
+	interval = pInterval;
+	lastGain = lastTc = 0.0;
+	numUpdates = stableUpdates = 0;
+	for (size_t i = 0; i < NumDeadTimeCandidates; ++i)
+	{
+		Estimator& e = estimators[i];
+		e.a = e.b = 0.0;
+		e.p11 = e.p22 = InitialCovariance;
+		e.p12 = 0.0;
+		e.sumSquaredErrors = 0.0;
+		pwmHistory[i] = 0.0;
+	}
+}
+
+void FopDtIdentifier::Update(float pwm, float temperature)
+{
+	for (size_t i = NumDeadTimeCandidates - 1; i != 0; --i)
+	{
+		pwmHistory[i] = pwmHistory[i - 1];
+	}
+	pwmHistory[0] = pwm;
+	++numUpdates;
+
+	const float x2 = -(lastTemp - startTemp);
+	const float y = temperature - lastTemp;
+	lastTemp = temperature;
+
+	// Candidate d only has the PWM history it needs once we have had d + 1 updates.
+	// We only count the prediction errors once all the candidates are running, so that they are all judged over the same readings.
+	for (size_t d = 0; d < NumDeadTimeCandidates && d < numUpdates; ++d)
+	{
+		Estimator& e = estimators[d];
+		const float x1 = pwmHistory[d];
+		const float error = y - (e.a * x1 + e.b * x2);
+		if (numUpdates > NumDeadTimeCandidates)
+		{
+			e.sumSquaredErrors += fsquare(error);
+		}
+
+		// Standard recursive least squares update with no forgetting, because the process doesn't change while we are tuning
+		const float px1 = e.p11 * x1 + e.p12 * x2;
+		const float px2 = e.p12 * x1 + e.p22 * x2;
+		const float denom = 1.0 + x1 * px1 + x2 * px2;
+		const float k1 = px1/denom, k2 = px2/denom;
+		e.a += k1 * error;
+		e.b += k2 * error;
+		e.p11 -= k1 * px1;
+		e.p12 -= k1 * px2;
+		e.p22 -= k2 * px2;
+	}
+
+	// See whether the best model has settled
+	float gain, tc, td;
+	if (GetModel(gain, tc, td)
+		&& fabsf(gain - lastGain) <= ModelSettledTolerance * gain
+		&& fabsf(tc - lastTc) <= ModelSettledTolerance * tc
+	   )
+	{
+		++stableUpdates;
+	}
+	else
+	{
+		stableUpdates = 0;
+	}
+	lastGain = gain;
+	lastTc = tc;
+}
+
+// Return the index of the candidate dead time with the smallest prediction errors, or -1 if we haven't judged them yet
+int FopDtIdentifier::BestCandidate() const
+{
+	if (numUpdates <= NumDeadTimeCandidates)
+	{
+		return -1;
+	}
+
+	int best = 0;
+	for (size_t d = 1; d < NumDeadTimeCandidates; ++d)
+	{
+		if (estimators[d].sumSquaredErrors < estimators[best].sumSquaredErrors)
+		{
+			best = (int)d;
+		}
+	}
+	return best;
+}
+
+// Get the best model so far, returning false if we don't have a sensible one yet
+bool FopDtIdentifier::GetModel(float& pGain, float& pTc, float& pTd) const
+{
+	pGain = pTc = pTd = 0.0;
+	const int best = BestCandidate();
+	if (best < 0)
+	{
+		return false;
+	}
+
+	const Estimator& e = estimators[best];
+	if (e.a <= 0.0 || e.b <= 0.0)
+	{
+		return false;
+	}
+	pGain = e.a/e.b;
+	pTc = interval/e.b;
+	pTd = ((float)best + 0.5) * interval;		// the PWM is held for a whole interval, so on average it takes effect half an interval after it was set
+	return true;
+}
+
 // End
@@ -71,4 +71,38 @@ private:
 	PidParameters loadChangeParams;			// parameters for handling changes in the load
 };
 
+const size_t NumDeadTimeCandidates = 16;		// the number of dead times that FopDtIdentifier tries, one per identification interval
+
+// Class to identify the parameters of a first order process with dead time from heater PWM and temperature readings while it is running.
+// At a fixed interval h we fit T[k] - T[k-1] = a * u[k-1-d] - b * (T[k-1] - T0) using recursive least squares, where u is the PWM and T0 the
+// starting temperature. Then tc = h/b and G = a/b. We run one estimator for each candidate dead time of d whole intervals and use the one
+// whose predictions have been the best.
+class FopDtIdentifier
+{
+public:
+	void Start(float pStartTemp, float pInterval);					// start identifying, with the interval between updates in seconds
+	void Update(float pwm, float temperature);						// add the PWM we used during the last interval and the temperature at the end of it
+	bool GetModel(float& pGain, float& pTc, float& pTd) const;		// get the best model so far, returning false if we don't have a sensible one yet
+	unsigned int GetStableUpdates() const { return stableUpdates; }	// how many consecutive updates the model has hardly changed for
+
+private:
+	struct Estimator
+	{
+		float a, b;													// the parameters, as above
+		float p11, p12, p22;										// the covariance matrix, which is symmetric
+		float sumSquaredErrors;										// sum of the squared prediction errors
+	};
+
+	int BestCandidate() const;
+
+	Estimator estimators[NumDeadTimeCandidates];
+	float pwmHistory[NumDeadTimeCandidates];						// the PWM used during each of the last few intervals, most recent first
+	float startTemp;
+	float lastTemp;
+	float interval;
+	float lastGain, lastTc;											// the model from the previous update, to see if it has settled
+	unsigned int numUpdates;
+	unsigned int stableUpdates;
+};
+
 #endif /* SRC_HEATING_FOPDT_H_ */
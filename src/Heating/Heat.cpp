@@ -28,7 +28,8 @@ Licence: GPL
 #endif
 
 Heat::Heat(Platform& p)
-	: platform(p), active(false), coldExtrude(false), bedHeater(DefaultBedHeater), chamberHeater(DefaultChamberHeater), heaterBeingTuned(-1), lastHeaterTuned(-1)
+	: platform(p), active(false), coldExtrude(false), bedHeater(DefaultBedHeater), chamberHeater(DefaultChamberHeater), lastHeaterTuned(-1),
+	  tuningPowerBudget(DefaultTuningPowerBudget)
 {
 	for (size_t heater : ARRAY_INDICES(pids))
 	{
@@ -140,14 +141,14 @@ void Heat::Spin()
 			lastTime = now;
 			for (size_t heater=0; heater < Heaters; heater++)
 			{
+				const bool wasTuning = pids[heater]->IsTuning();
 				pids[heater]->Spin();
-			}
 
-			// See if we have finished tuning a PID
-			if (heaterBeingTuned != -1 && !pids[heaterBeingTuned]->IsTuning())
-			{
-				lastHeaterTuned = heaterBeingTuned;
-				heaterBeingTuned = -1;
+				// See if we have finished tuning this PID
+				if (wasTuning && !pids[heater]->IsTuning())
+				{
+					lastHeaterTuned = (int8_t)heater;
+				}
 			}
 		}
 
@@ -328,17 +329,16 @@ bool Heat::IsBedOrChamberHeater(int8_t heater) const
 }
 
 // Auto tune a PID
+// Several heaters may be tuned at the same time. Each one waits to start heating until the power budget allows it.
 void Heat::StartAutoTune(size_t heater, float temperature, float maxPwm, StringRef& reply)
 {
-	if (heaterBeingTuned == -1)
+	if (pids[heater]->IsTuning())
 	{
-		heaterBeingTuned = (int8_t)heater;
-		pids[heater]->StartAutoTune(temperature, maxPwm, reply);
+		reply.printf("Error: heater %u is already being tuned", heater);
 	}
 	else
 	{
-		// Trying to start a new auto tune, but we are already tuning a heater
-		reply.printf("Error: cannot start auto tuning heater %u because heater %d is being tuned", heater, heaterBeingTuned);
+		pids[heater]->StartAutoTune(temperature, maxPwm, reply);
 	}
 }
 
@@ -347,17 +347,44 @@ bool Heat::IsTuning(size_t heater) const
 	return pids[heater]->IsTuning();
 }
 
+// Report the status of all the heaters being tuned, or of the last one tuned if none are
 void Heat::GetAutoTuneStatus(StringRef& reply) const
 {
-	int8_t whichPid = (heaterBeingTuned == -1) ? lastHeaterTuned : heaterBeingTuned;
-	if (whichPid != -1)
+	reply.Clear();
+	for (size_t heater = 0; heater < Heaters; ++heater)
 	{
-		pids[whichPid]->GetAutoTuneStatus(reply);
+		if (pids[heater]->IsTuning())
+		{
+			if (reply.strlen() != 0)
+			{
+				reply.cat("\n");
+			}
+			pids[heater]->GetAutoTuneStatus(reply);
+		}
 	}
-	else
+
+	if (reply.strlen() == 0)
+	{
+		if (lastHeaterTuned != -1)
+		{
+			pids[lastHeaterTuned]->GetAutoTuneStatus(reply);
+		}
+		else
+		{
+			reply.copy("No heater has been tuned yet");
+		}
+	}
+}
+
+// Get the total PWM of the heaters that are being heated for auto tuning
+float Heat::GetTuningPowerInUse() const
+{
+	float power = 0.0;
+	for (const PID *pid : pids)
 	{
-		reply.copy("No heater has been tuned yet");
+		power += pid->GetTuningPower();
 	}
+	return power;
 }
 
 // Get the highest temperature limit of any heater
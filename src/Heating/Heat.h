@@ -32,6 +32,8 @@ Licence: GPL
 class TemperatureSensor;
 class GCodeBuffer;
 
+const float DefaultTuningPowerBudget = 1.0;						// by default we only heat one heater at a time at full power when auto tuning
+
 class Heat
 {
 public:
@@ -92,6 +94,9 @@ public:
 	pre(heater < Heaters);
 
 	void GetAutoTuneStatus(StringRef& reply) const;				// Get the status of the current or last auto tune
+	float GetTuningPowerInUse() const;							// Get the total PWM of the heaters that are being heated for auto tuning
+	float GetTuningPowerBudget() const { return tuningPowerBudget; }
+	void SetTuningPowerBudget(float budget) { tuningPowerBudget = budget; }
 
 	const FopDt& GetHeaterModel(size_t heater) const			// Get the process model for the specified heater
 	pre(heater < Heaters);
@@ -154,8 +159,8 @@ private:
 	bool coldExtrude;											// Is cold extrusion allowed?
 	int8_t bedHeater;											// Index of the hot bed heater to use or -1 if none is available
 	int8_t chamberHeater;										// Index of the chamber heater to use or -1 if none is available
-	int8_t heaterBeingTuned;									// which PID is currently being tuned
 	int8_t lastHeaterTuned;										// which PID we last finished tuning
+	float tuningPowerBudget;									// the maximum total PWM of the heaters we heat at the same time when auto tuning
 };
 
 //***********************************************************************************************************
@@ -15,30 +15,14 @@
 const uint32_t InitialTuningReadingInterval = 250;	// the initial reading interval in milliseconds
 const uint32_t TempSettleTimeout = 20000;	// how long we allow the initial temperature to settle
 
-// Static class variables
-
-float *PID::tuningTempReadings = nullptr;	// the readings from the heater being tuned
-float PID::tuningStartTemp;					// the temperature when we turned on the heater
-float PID::tuningPwm;						// the PWM to use
-float PID::tuningTargetTemp;				// the maximum temperature we are allowed to reach
-uint32_t PID::tuningBeginTime;				// when we started the tuning process
-uint32_t PID::tuningPhaseStartTime;			// when we started the current tuning phase
-uint32_t PID::tuningReadingInterval;		// how often we are sampling
-size_t PID::tuningReadingsTaken;			// how many samples we have taken
-
-float PID::tuningHeaterOffTemp;				// the temperature when we turned the heater off
-float PID::tuningPeakTemperature;			// the peak temperature reached, averaged over 3 readings (so slightly less than the true peak)
-uint32_t PID::tuningHeatingTime;			// how long we had the heating on for
-uint32_t PID::tuningPeakDelay;				// how many milliseconds the temperature continues to rise after turning the heater off
-
-#if HAS_VOLTAGE_MONITOR
-unsigned int voltageSamplesTaken;			// how many readings we accumulated
-float tuningVoltageAccumulator;				// sum of the voltage readings we take during the heating phase
-#endif
+const uint32_t HotEndIdentificationInterval = 500;	// how often we update the model identifier when tuning a hot end heater, in milliseconds
+const uint32_t BedIdentificationInterval = 2000;	// how often we update the model identifier when tuning a bed or chamber heater, in milliseconds
+const unsigned int ModelSettledUpdates = 20;		// how many consecutive identifier updates the model must hardly change for before we accept it
+const float MinCoolingProportion = 0.15;			// how far the heater must cool back towards the starting temperature before we accept the model
 
 // Member functions and constructors
 
-PID::PID(Platform& p, int8_t h) : platform(p), heater(h), mode(HeaterMode::off)
+PID::PID(Platform& p, int8_t h) : platform(p), heater(h), mode(HeaterMode::off), tuning(nullptr)
 {
 }
 
@@ -67,6 +51,7 @@ void PID::Init(float pGain, float pTc, float pTd, float tempLimit, bool usePid)
 
 void PID::Reset()
 {
+	StopTuning();
 	mode = HeaterMode::off;
 	previousTemperaturesGood = 0;
 	previousTemperatureIndex = 0;
@@ -165,18 +150,14 @@ void PID::SwitchOn()
 	}
 }
 
-// Switch off the specified heater. If in tuning mode, delete the array used to store tuning temperature readings.
+// Switch off the specified heater. If in tuning mode, delete the tuning data.
 void PID::SwitchOff()
 {
 	lastPwm = 0.0;
 	if (model.IsEnabled())
 	{
 		SetHeater(0.0);
-		if (IsTuning())
-		{
-			delete tuningTempReadings;
-			tuningTempReadings = nullptr;
-		}
+		StopTuning();
 		if (mode > HeaterMode::off)
 		{
 			mode = HeaterMode::off;
@@ -215,11 +196,7 @@ void PID::Spin()
 				{
 					lastPwm = 0.0;
 					SetHeater(0.0);						// do this here just to be sure, in case the call to platform.Message causes a delay
-					if (IsTuning())
-					{
-						delete tuningTempReadings;
-						tuningTempReadings = nullptr;
-					}
+					StopTuning();
 					mode = HeaterMode::fault;
 					reprap.GetGCodes().HandleHeaterFault(heater);
 					platform.MessageF(ErrorMessage, "Temperature reading fault on heater %d: %s\n", heater, TemperatureErrorString(err));
@@ -516,41 +493,50 @@ void PID::StartAutoTune(float targetTemp, float maxPwm, StringRef& reply)
 		}
 		else
 		{
+			// We don't normally allow dynamic memory allocation when running. However, auto tuning is rarely done and it
+			// would be wasteful to allocate permanent tuning data for every heater just in case we are going to run it, so we make an exception here.
+			tuning = new TuningData;
 			mode = HeaterMode::tuning0;
-			tuningReadingsTaken = 0;
+			tuning->readingsTaken = 0;
 			tuned = false;					// assume failure
 
-			// We don't normally allow dynamic memory allocation when running. However, auto tuning is rarely done and it
-			// would be wasteful to allocate a permanent array just in case we are going to run it, so we make an exception here.
-			tuningTempReadings = new float[MaxTuningTempReadings];
-			tuningTempReadings[0] = temperature;
-			tuningReadingInterval = platform.HeatSampleInterval();
-			tuningPwm = maxPwm;
-			tuningTargetTemp = targetTemp;
+			tuning->tempReadings[0] = temperature;
+			tuning->readingInterval = platform.HeatSampleInterval();
+			tuning->pwm = maxPwm;
+			tuning->targetTemp = targetTemp;
+			tuning->waitingForPower = false;
 			reply.printf("Auto tuning heater %d using target temperature %.1f" DEGREE_SYMBOL "C and PWM %.2f - do not leave printer unattended", heater, (double)targetTemp, (double)maxPwm);
 		}
 	}
 }
 
-void PID::GetAutoTuneStatus(StringRef& reply)	// Get the auto tune status or last result
+void PID::GetAutoTuneStatus(StringRef& reply)	// Append the auto tune status or last result
 {
 	if (mode >= HeaterMode::tuning0)
 	{
-		reply.printf("Heater %d is being tuned, phase %u of %u",
+		reply.catf("Heater %d is being tuned, phase %u of %u%s",
 						heater,
 						(unsigned int)mode - (unsigned int)HeaterMode::tuning0 + 1,
-						(unsigned int)HeaterMode::lastTuningMode - (unsigned int)HeaterMode::tuning0 + 1);
+						(unsigned int)HeaterMode::lastTuningMode - (unsigned int)HeaterMode::tuning0 + 1,
+						(tuning->waitingForPower) ? ", waiting for power" : "");
 	}
 	else if (tuned)
 	{
-		reply.printf("Heater %d tuning succeeded, use M307 H%d to see result", heater, heater);
+		reply.catf("Heater %d tuning succeeded, use M307 H%d to see result", heater, heater);
 	}
 	else
 	{
-		reply.printf("Heater %d tuning failed", heater);
+		reply.catf("Heater %d tuning failed", heater);
 	}
 }
 
+// Release the auto tuning data
+void PID::StopTuning()
+{
+	delete tuning;
+	tuning = nullptr;
+}
+
 /* Notes on the auto tune algorithm
  *
  * Most 3D printer firmwares use the strm-Hgglund relay tuning method (sometimes called Ziegler-Nichols + relay).
@@ -576,11 +562,12 @@ void PID::GetAutoTuneStatus(StringRef& reply)	// Get the auto tune status or las
  *    when it sees that a heater is being auto tuned.
  * 2. Accumulate temperature readings and wait for the starting temperature to stabilise. Abandon auto tuning if the starting temperature
  *    is not stable.
- * 3. Apply a known power to the heater and take temperature readings.
- * 4. Wait until the temperature vs time curve has flattened off, such that the temperature rise over the last 1/3 of the readings is less than the
- *    total temperature rise - which means we have been heating for about 3 time constants. Abandon auto tuning if we don't see a temperature rise
- *    after 30 seconds, or we exceed the target temperature plus 10C.
- * 5. Calculate the G, td and tc values that best fit the model to the temperature readings.
+ * 3. Wait until heating this heater as well as any others being tuned would not exceed the tuning power budget set by M303 B.
+ * 4. Apply a known power to the heater until it reaches the target temperature, then turn it off. Abandon auto tuning if we don't see a temperature
+ *    rise after 30 seconds, or we don't reach the target temperature in time.
+ * 5. Throughout heating and cooling, identify G, tc and td online from the PWM and temperature readings, using the recursive least squares
+ *    identifier in class FopDtIdentifier. Stop as soon as the identified model has settled and the heater has cooled a little past its peak,
+ *    which is usually long before it has cooled back most of the way to the starting temperature.
  * 6. Calculate the P, I and D parameters from G, td and tc using the modified Cohen-Coon tuning rules, or the Ho et al tuning rules.
  *    Cohen-Coon (modified to use half the original Kc value):
  *     Kc = (0.67/G) * (tc/td + 0.185)
@@ -600,34 +587,46 @@ void PID::GetAutoTuneStatus(StringRef& reply)	// Get the auto tune status or las
 // It must set lastPWM to the required PWM, unless it is the same as last time.
 void PID::DoTuningStep()
 {
+	// Feed the model identifier once per identification interval while we are heating or cooling
+	if (mode != HeaterMode::tuning0)
+	{
+		++tuning->samplesSinceUpdate;
+		if (tuning->samplesSinceUpdate == tuning->samplesPerUpdate)
+		{
+			tuning->identifier.Update(tuning->identifierPwm, temperature);
+			tuning->identifierPwm = lastPwm;
+			tuning->samplesSinceUpdate = 0;
+		}
+	}
+
 	// See if another sample is due
-	if (tuningReadingsTaken == 0)
+	if (tuning->readingsTaken == 0)
 	{
-		tuningPhaseStartTime = millis();
+		tuning->phaseStartTime = millis();
 		if (mode == HeaterMode::tuning0)
 		{
-			tuningBeginTime = tuningPhaseStartTime;
+			tuning->beginTime = tuning->phaseStartTime;
 		}
 	}
-	else if (millis() - tuningPhaseStartTime < tuningReadingsTaken * tuningReadingInterval)
+	else if (millis() - tuning->phaseStartTime < tuning->readingsTaken * tuning->readingInterval)
 	{
 		return;		// not due yet
 	}
 
 	// See if we have room to store the new reading, and if not, double the sample interval
-	if (tuningReadingsTaken == MaxTuningTempReadings)
+	if (tuning->readingsTaken == MaxTuningTempReadings)
 	{
 		// Double the sample interval
-		tuningReadingsTaken /= 2;
-		for (size_t i = 1; i < tuningReadingsTaken; ++i)
+		tuning->readingsTaken /= 2;
+		for (size_t i = 1; i < tuning->readingsTaken; ++i)
 		{
-			tuningTempReadings[i] = tuningTempReadings[i * 2];
+			tuning->tempReadings[i] = tuning->tempReadings[i * 2];
 		}
-		tuningReadingInterval *= 2;
+		tuning->readingInterval *= 2;
 	}
 
-	tuningTempReadings[tuningReadingsTaken] = temperature;
-	++tuningReadingsTaken;
+	tuning->tempReadings[tuning->readingsTaken] = temperature;
+	++tuning->readingsTaken;
 
 	switch(mode)
 	{
@@ -635,116 +634,113 @@ void PID::DoTuningStep()
 		// Waiting for initial temperature to settle after any thermostatic fans have turned on
 		if (ReadingsStable(6000/platform.HeatSampleInterval(), 2.0))	// expect temperature to be stable within a 2C band for 6 seconds
 		{
-			// Starting temperature is stable, so move on
-			tuningReadingsTaken = 1;
+			// Starting temperature is stable. If other heaters are being heated for tuning, wait until we can heat this one without exceeding the power budget.
+			const float powerInUse = reprap.GetHeat().GetTuningPowerInUse();
+			if (powerInUse != 0.0 && powerInUse + tuning->pwm > reprap.GetHeat().GetTuningPowerBudget())
+			{
+				if (!tuning->waitingForPower)
+				{
+					tuning->waitingForPower = true;
+					platform.MessageF(GenericMessage, "Auto tune heater %d waiting for other heaters to finish heating\n", heater);
+				}
+				return;
+			}
+
+			// Move on
+			const bool isBedOrChamberHeater = reprap.GetHeat().IsBedOrChamberHeater(heater);
+			const uint32_t identificationInterval = (isBedOrChamberHeater) ? BedIdentificationInterval : HotEndIdentificationInterval;
+			tuning->samplesPerUpdate = max<unsigned int>(identificationInterval/platform.HeatSampleInterval(), 1);
+			tuning->samplesSinceUpdate = 0;
+			tuning->identifier.Start(temperature, (float)(tuning->samplesPerUpdate * platform.HeatSampleInterval()) * MillisToSeconds);
+
+			tuning->readingsTaken = 1;
 #if HAS_VOLTAGE_MONITOR
-			tuningVoltageAccumulator = 0.0;
-			voltageSamplesTaken = 0;
+			tuning->voltageAccumulator = 0.0;
+			tuning->voltageSamplesTaken = 0;
 #endif
-			tuningTempReadings[0] = tuningStartTemp = temperature;
-			timeSetHeating = tuningPhaseStartTime = millis();
-			lastPwm = tuningPwm;										// turn on heater at specified power
-			tuningReadingInterval = platform.HeatSampleInterval();		// reset sampling interval
+			tuning->tempReadings[0] = tuning->startTemp = temperature;
+			timeSetHeating = tuning->phaseStartTime = millis();
+			lastPwm = tuning->identifierPwm = tuning->pwm;					// turn on heater at specified power
+			tuning->readingInterval = platform.HeatSampleInterval();		// reset sampling interval
 			mode = HeaterMode::tuning1;
-			platform.Message(GenericMessage, "Auto tune phase 1, heater on\n");
+			platform.MessageF(GenericMessage, "Auto tune heater %d phase 1, heater on\n", heater);
 			return;
 		}
-		if (millis() - tuningPhaseStartTime < 20000)
+		if (tuning->waitingForPower || millis() - tuning->phaseStartTime < 20000)
 		{
 			// Allow up to 20 seconds for starting temperature to settle
 			return;
 		}
-		platform.Message(GenericMessage, "Auto tune cancelled because starting temperature is not stable\n");
+		platform.MessageF(GenericMessage, "Auto tune of heater %d cancelled because starting temperature is not stable\n", heater);
 		break;
 
 	case HeaterMode::tuning1:
 		// Heating up
 		{
 			const bool isBedOrChamberHeater = reprap.GetHeat().IsBedOrChamberHeater(heater);
-			const uint32_t heatingTime = millis() - tuningPhaseStartTime;
+			const uint32_t heatingTime = millis() - tuning->phaseStartTime;
 			const float extraTimeAllowed = (isBedOrChamberHeater) ? 60.0 : 30.0;
-			if (heatingTime > (uint32_t)((model.GetDeadTime() + extraTimeAllowed) * SecondsToMillis) && (temperature - tuningStartTemp) < 3.0)
+			if (heatingTime > (uint32_t)((model.GetDeadTime() + extraTimeAllowed) * SecondsToMillis) && (temperature - tuning->startTemp) < 3.0)
 			{
-				platform.Message(GenericMessage, "Auto tune cancelled because temperature is not increasing\n");
+				platform.MessageF(GenericMessage, "Auto tune of heater %d cancelled because temperature is not increasing\n", heater);
 				break;
 			}
 
 			const uint32_t timeoutMinutes = (isBedOrChamberHeater) ? 20 : 5;
 			if (heatingTime >= timeoutMinutes * 60 * (uint32_t)SecondsToMillis)
 			{
-				platform.Message(GenericMessage, "Auto tune cancelled because target temperature was not reached\n");
+				platform.MessageF(GenericMessage, "Auto tune of heater %d cancelled because target temperature was not reached\n", heater);
 				break;
 			}
 
 #if HAS_VOLTAGE_MONITOR
-			tuningVoltageAccumulator += platform.GetCurrentPowerVoltage();
-			++voltageSamplesTaken;
+			tuning->voltageAccumulator += platform.GetCurrentPowerVoltage();
+			++tuning->voltageSamplesTaken;
 #endif
-			if (temperature >= tuningTargetTemp)							// if reached target
+			if (temperature >= tuning->targetTemp)							// if reached target
 			{
-				tuningHeatingTime = heatingTime;
-
 				// Move on to next phase
-				tuningReadingsTaken = 1;
-				tuningHeaterOffTemp = tuningTempReadings[0] = temperature;
-				tuningPhaseStartTime = millis();
-				tuningReadingInterval = platform.HeatSampleInterval();		// reset sampling interval
+				tuning->readingsTaken = 1;
+				tuning->heaterOffTemp = tuning->peakTemperature = tuning->tempReadings[0] = temperature;
+				tuning->phaseStartTime = millis();
+				tuning->readingInterval = platform.HeatSampleInterval();	// reset sampling interval
 				mode = HeaterMode::tuning2;
 				lastPwm = 0.0;
 				SetHeater(0.0);
-				platform.Message(GenericMessage, "Auto tune phase 2, heater off\n");
+				platform.MessageF(GenericMessage, "Auto tune heater %d phase 2, heater off\n", heater);
 			}
 		}
 		return;
 
 	case HeaterMode::tuning2:
-		// Heater turned off, looking for peak temperature
+		// Heater turned off. We keep identifying the model until it has settled and the heater has cooled a little past its peak temperature,
+		// which gives the identifier the response to turning the heater off as well as to turning it on.
 		{
-			const int peakIndex = GetPeakTempIndex();
-			if (peakIndex < 0)
+			if (temperature > tuning->peakTemperature)
 			{
-				if (millis() - tuningPhaseStartTime < 60 * 1000)			// allow 1 minute for the bed temperature reach peal temperature
-				{
-					return;			// still waiting for peak temperature
-				}
-				platform.Message(GenericMessage, "Auto tune cancelled because temperature is not falling\n");
+				tuning->peakTemperature = temperature;
 			}
-			else if (peakIndex == 0)
+
+			const float rise = tuning->peakTemperature - tuning->startTemp;
+			if (tuning->identifier.GetStableUpdates() >= ModelSettledUpdates && temperature <= tuning->peakTemperature - MinCoolingProportion * rise)
 			{
-				if (reprap.Debug(moduleHeat))
-				{
-					DisplayBuffer("At no peak found");
-				}
-				platform.Message(GenericMessage, "Auto tune cancelled because temperature peak was not identified\n");
+				CalculateModel();
+				break;
 			}
-			else
-			{
-				tuningPeakTemperature = tuningTempReadings[peakIndex];
-				tuningPeakDelay = peakIndex * tuningReadingInterval;
 
-				// Move on to next phase
-				tuningReadingsTaken = 1;
-				tuningTempReadings[0] = temperature;
-				tuningPhaseStartTime = millis();
-				tuningReadingInterval = platform.HeatSampleInterval();		// reset sampling interval
-				mode = HeaterMode::tuning3;
-				platform.MessageF(GenericMessage, "Auto tune phase 3, peak temperature was %.1f\n", (double)tuningPeakTemperature);
-				return;
+			// If the model hasn't settled by the time we are well on the way back to the starting temperature, accept what we have
+			const float coolDownProportion = 0.6;
+			if (temperature <= tuning->peakTemperature - coolDownProportion * rise)
+			{
+				CalculateModel();
+				break;
 			}
-		}
-		break;
 
-	case HeaterMode::tuning3:
-		{
-			// Heater is past the peak temperature and cooling down. Wait until it is part way back to the starting temperature so we can measure the cooling rate.
-			// In the case of a bed that shows a reservoir effect, the choice of how far we wait for it to cool down will effect the result.
-			// If we wait for it to cool down by 50% then we get a short time constant and a low gain, which causes overshoot. So try a bit more.
-			const float coolDownProportion = 0.6;
-			if (temperature > (tuningTempReadings[0] * (1.0 - coolDownProportion)) + (tuningStartTemp * coolDownProportion))
+			if (millis() - tuning->phaseStartTime < 60 * 1000 || temperature < tuning->heaterOffTemp)	// allow 1 minute for the bed temperature to start falling
 			{
 				return;
 			}
-			CalculateModel();
+			platform.MessageF(GenericMessage, "Auto tune of heater %d cancelled because temperature is not falling\n", heater);
 		}
 		break;
 
@@ -754,22 +750,22 @@ void PID::DoTuningStep()
 	}
 
 	// If we get here, we have finished
-	SwitchOff();								// sets mode and lastPWM, also deletes tuningTempReadings
+	SwitchOff();								// sets mode and lastPWM, also deletes the tuning data
 }
 
 // Return true if the last 'numReadings' readings are stable
-/*static*/ bool PID::ReadingsStable(size_t numReadings, float maxDiff)
+bool PID::ReadingsStable(size_t numReadings, float maxDiff) const
 {
-	if (tuningTempReadings == nullptr || tuningReadingsTaken < numReadings)
+	if (tuning == nullptr || tuning->readingsTaken < numReadings)
 	{
 		return false;
 	}
 
-	float minReading = tuningTempReadings[tuningReadingsTaken - numReadings];
+	float minReading = tuning->tempReadings[tuning->readingsTaken - numReadings];
 	float maxReading = minReading;
-	for (size_t i = tuningReadingsTaken - numReadings + 1; i < tuningReadingsTaken; ++i)
+	for (size_t i = tuning->readingsTaken - numReadings + 1; i < tuning->readingsTaken; ++i)
 	{
-		const float t = tuningTempReadings[i];
+		const float t = tuning->tempReadings[i];
 		if (t < minReading) { minReading = t; }
 		if (t > maxReading) { maxReading = t; }
 	}
@@ -777,95 +773,27 @@ void PID::DoTuningStep()
 	return maxReading - minReading <= maxDiff;
 }
 
-// Calculate which reading gave us the peak temperature.
-// Return -1 if peak not identified yet, 0 if we are never going to find a peak, else the index of the peak
-// If the readings show a continuous decrease then we return 1, because zero dead time would lead to infinities
-/*static*/ int PID::GetPeakTempIndex()
-{
-	// Check we have enough readings to look for the peak
-	if (tuningReadingsTaken < 15)
-	{
-		return -1;							// too few readings
-	}
-
-	// Look for the peak
-	int peakIndex = IdentifyPeak(1);
-	if (peakIndex < 0)
-	{
-		peakIndex = IdentifyPeak(3);
-		if (peakIndex < 0)
-		{
-			peakIndex = IdentifyPeak(5);
-			if (peakIndex < 0)
-			{
-				peakIndex = IdentifyPeak(7);
-				if (peakIndex < 0)
-				{
-					return 0;					// more than one peak
-				}
-			}
-		}
-	}
-
-	// If we have found one peak and it's not too near the end of the readings, return it
-	return ((size_t)peakIndex + 3 < tuningReadingsTaken) ? max<int>(peakIndex, 1) : -1;
-}
-
-// See if there is exactly one peak in the readings.
-// Return -1 if more than one peak, else the index of the peak. The so-called peak may be right at the end, in which case it isn't really a peak.
-// With a well-insulated bed heater the temperature may not start dropping appreciably within the 120 second time limit allowed.
-/*static*/ int PID::IdentifyPeak(size_t numToAverage)
-{
-	int firstPeakIndex = -1, lastSameIndex = -1;
-	float peakTempTimesN = -999.0;
-	for (size_t i = 0; i + numToAverage <= tuningReadingsTaken; ++i)
-	{
-		float peak = 0.0;
-		for (size_t j = 0; j < numToAverage; ++j)
-		{
-			peak += tuningTempReadings[i + j];
-		}
-		if (peak > peakTempTimesN)
-		{
-			if ((int)i == lastSameIndex + 1)
-			{
-				firstPeakIndex = lastSameIndex = (int)i;	// readings still going up or staying the same, so advance the first peak index
-				peakTempTimesN = peak;
-			}
-			else
-			{
-				return -1;						// error, more than one peak
-			}
-		}
-		else if (peak == peakTempTimesN)		// exact equality can occur because the floating point value is computed from an integral value
-		{
-			lastSameIndex = (int)i;
-		}
-	}
-	return firstPeakIndex + (numToAverage - 1)/2;
-}
-
-// Calculate the heater model from the accumulated heater parameters
+// Calculate the heater model from the identified parameters
 void PID::CalculateModel()
 {
 	if (reprap.Debug(moduleHeat))
 	{
 		DisplayBuffer("At completion");
 	}
-	const float tc = (float)((tuningReadingsTaken - 1) * tuningReadingInterval)/(1000.0 * logf((tuningTempReadings[0] - tuningStartTemp)/(tuningTempReadings[tuningReadingsTaken - 1] - tuningStartTemp)));
-	const float heatingTime = (tuningHeatingTime - tuningPeakDelay) * 0.001;
-	const float gain = (tuningHeaterOffTemp - tuningStartTemp)/(1.0 - expf(-heatingTime/tc));
 
-	// There are two ways of calculating the dead time:
-	// 1. Based on the delay to peak temperature after we turned the heater off. Adding 0.5sec and then taking 65% of the result is about right.
-	// 2. Based on the peak temperature compared to the temperature at which we turned the heater off.
-	// Try #2 because it is easier to identify the peak temperature than the delay to peak temperature. It can be slightly to aggressive, so add 30%.
-	//const float td = (float)(tuningPeakDelay + 500) * 0.00065;		// take the dead time as 65% of the delay to peak rounded up to a half second
-	const float td = tc * logf((gain + tuningStartTemp - tuningHeaterOffTemp)/(gain + tuningStartTemp - tuningPeakTemperature)) * 1.3;
+	float gain, tc, td;
+	if (!tuning->identifier.GetModel(gain, tc, td))
+	{
+		platform.MessageF(WarningMessage, "Auto tune of heater %d failed because the heater model could not be identified\n", heater);
+		return;
+	}
+
+	// The identified dead time tends to give slightly too aggressive PID parameters, so add 30% as we did with the previous tuning method
+	td *= 1.3;
 
-	tuned = SetModel(gain, tc, td, tuningPwm,
+	tuned = SetModel(gain, tc, td, tuning->pwm,
 #if HAS_VOLTAGE_MONITOR
-						tuningVoltageAccumulator/voltageSamplesTaken,
+						(tuning->voltageSamplesTaken == 0) ? 0.0 : tuning->voltageAccumulator/tuning->voltageSamplesTaken,
 #else
 						0.0,
 #endif
@@ -875,7 +803,7 @@ void PID::CalculateModel()
 		platform.MessageF(LoggedGenericMessage,
 				"Auto tune heater %d completed in %" PRIu32 " sec\n"
 				"Use M307 H%d to see the result, or M500 to save the result in config-override.g\n",
-				heater, (millis() - tuningBeginTime)/(uint32_t)SecondsToMillis, heater);
+				heater, (millis() - tuning->beginTime)/(uint32_t)SecondsToMillis, heater);
 	}
 	else
 	{
@@ -888,10 +816,10 @@ void PID::DisplayBuffer(const char *intro)
 	OutputBuffer *buf;
 	if (OutputBuffer::Allocate(buf))
 	{
-		buf->catf("%s: interval %.1f sec, readings", intro, (double)(tuningReadingInterval * MillisToSeconds));
-		for (size_t i = 0; i < tuningReadingsTaken; ++i)
+		buf->catf("%s: interval %.1f sec, readings", intro, (double)(tuning->readingInterval * MillisToSeconds));
+		for (size_t i = 0; i < tuning->readingsTaken; ++i)
 		{
-			buf->catf(" %.1f", (double)tuningTempReadings[i]);
+			buf->catf(" %.1f", (double)tuning->tempReadings[i]);
 		}
 		buf->cat("\n");
 		platform.Message(UsbMessage, buf);
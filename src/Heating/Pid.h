@@ -30,11 +30,11 @@ class PID
 		tuning0,
 		tuning1,
 		tuning2,
-		tuning3,
-		lastTuningMode = tuning3
+		lastTuningMode = tuning2
 	};
 
 	static const size_t NumPreviousTemperatures = 4; // How many samples we average the temperature derivative over
+	static const size_t MaxTuningTempReadings = 128; // The maximum number of readings we keep when tuning. Must be an even number.
 
 public:
 
@@ -61,6 +61,7 @@ public:
 	float GetAccumulator() const;					// Return the integral accumulator
 	void StartAutoTune(float targetTemp, float maxPwm, StringRef& reply);	// Start an auto tune cycle for this PID
 	bool IsTuning() const;
+	float GetTuningPower() const;					// Get the PWM we are using to heat this heater during auto tuning, or 0 if we are not heating it
 	void GetAutoTuneStatus(StringRef& reply);		// Get the auto tune status or last result
 
 	const FopDt& GetModel() const					// Get the process model
@@ -90,11 +91,10 @@ private:
 	void SetHeater(float power) const;				// Power is a fraction in [0,1]
 	TemperatureError ReadTemperature();				// Read and store the temperature of this heater
 	void DoTuningStep();							// Called on each temperature sample when auto tuning
-	static bool ReadingsStable(size_t numReadings, float maxDiff)
+	void StopTuning();								// Release the auto tuning data
+	bool ReadingsStable(size_t numReadings, float maxDiff) const
 		pre(numReadings >= 2; numReadings <= MaxTuningTempReadings);
-	static int GetPeakTempIndex();					// Auto tune helper function
-	static int IdentifyPeak(size_t numToAverage);	// Auto tune helper function
-	void CalculateModel();							// Calculate G, td and tc from the accumulated readings
+	void CalculateModel();							// Calculate G, td and tc from the identified model
 	void DisplayBuffer(const char *intro);			// Debug helper
 	float GetExpectedHeatingRate() const;			// Get the minimum heating rate we expect
 
@@ -128,21 +128,32 @@ private:
 
 	static_assert(sizeof(previousTemperaturesGood) * 8 >= NumPreviousTemperatures, "too few bits in previousTemperaturesGood");
 
-	// Variables used during heater tuning
-	static const size_t MaxTuningTempReadings = 128; // The maximum number of readings we keep. Must be an even number.
-
-	static float *tuningTempReadings;				// the readings from the heater being tuned
-	static float tuningStartTemp;					// the temperature when we turned on the heater
-	static float tuningPwm;							// the PWM to use, 0..1
-	static float tuningTargetTemp;						// the maximum temperature we are allowed to reach
-	static uint32_t tuningBeginTime;				// when we started the tuning process
-	static uint32_t tuningPhaseStartTime;			// when we started the current tuning phase
-	static uint32_t tuningReadingInterval;			// how often we are sampling, in milliseconds
-	static size_t tuningReadingsTaken;				// how many temperature samples we have taken
-	static float tuningHeaterOffTemp;				// the temperature when we turned the heater off
-	static float tuningPeakTemperature;				// the peak temperature reached, averaged over 3 readings (so slightly less than the true peak)
-	static uint32_t tuningHeatingTime;				// how long we had the heating on for
-	static uint32_t tuningPeakDelay;				// how many milliseconds the temperature continues to rise after turning the heater off
+	// Variables used during heater tuning. We allocate them when we start tuning a heater and free them when we finish,
+	// so heaters that are not being tuned don't use the RAM and several heaters can be tuned at the same time.
+	struct TuningData
+	{
+		float tempReadings[MaxTuningTempReadings];	// the readings from the heater being tuned
+		FopDtIdentifier identifier;					// identifies the heater model while we heat it and let it cool
+		float startTemp;							// the temperature when we turned on the heater
+		float pwm;									// the PWM to use, 0..1
+		float targetTemp;							// the maximum temperature we are allowed to reach
+		float heaterOffTemp;						// the temperature when we turned the heater off
+		float peakTemperature;						// the highest temperature reached after we turned the heater off
+		float identifierPwm;						// the PWM at the start of the current identification interval
+		uint32_t beginTime;							// when we started the tuning process
+		uint32_t phaseStartTime;					// when we started the current tuning phase
+		uint32_t readingInterval;					// how often we are sampling, in milliseconds
+		size_t readingsTaken;						// how many temperature samples we have taken
+		unsigned int samplesPerUpdate;				// how many temperature samples there are in each identification interval
+		unsigned int samplesSinceUpdate;			// how many temperature samples we have had since we last updated the identifier
+#if HAS_VOLTAGE_MONITOR
+		unsigned int voltageSamplesTaken;			// how many voltage readings we accumulated
+		float voltageAccumulator;					// sum of the voltage readings we take during the heating phase
+#endif
+		bool waitingForPower;						// true if the starting temperature is stable but we are waiting for the power budget to allow us to heat
+	};
+
+	TuningData *tuning;								// the auto tuning data, or nullptr if we are not tuning this heater
 };
 
 
@@ -201,4 +212,9 @@ inline bool PID::IsTuning() const
 	return mode >= HeaterMode::tuning0;
 }
 
+inline float PID::GetTuningPower() const
+{
+	return (mode == HeaterMode::tuning1) ? tuning->pwm : 0.0;
+}
+
 #endif /* SRC_PID_H_ */
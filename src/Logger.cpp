@@ -11,6 +11,8 @@
 #include "RepRap.h"
 #include "Platform.h"
 
+const FilePosition LogFileExtent = 65536;		// we allocate space for the log file in contiguous extents of this size
+
 // Simple lock class that sets a variable true when it is created and makes sure it gets set false when it falls out of scope
 class Lock
 {
@@ -22,7 +24,7 @@ private:
 	bool& b;
 };
 
-Logger::Logger() : logFile(), lastFlushTime(0), lastFlushFileSize(0), dirty(false), inLogger(false)
+Logger::Logger() : logFile(), lastFlushTime(0), lastFlushFileSize(0), allocatedSize(0), dirty(false), inLogger(false)
 {
 }
 
@@ -37,6 +39,7 @@ void Logger::Start(time_t time, const StringRef& filename)
 			logFile.Set(f);
 			lastFlushFileSize = logFile.Length();
 			logFile.Seek(lastFlushFileSize);
+			allocatedSize = 0;
 			InternalLogMessage(time, "Event logging started\n");
 		}
 	}
@@ -133,10 +136,23 @@ void Logger::Flush(bool forced)
 	}
 }
 
+// Make sure the log file has space allocated beyond its end, so that it grows in large contiguous extents instead of a cluster at a time
+// while other files are being written. Caller must already have checked and set inLogger.
+void Logger::AllocateSpace()
+{
+	const FilePosition length = logFile.Length();
+	if (length + LogFileExtent/2 > allocatedSize)
+	{
+		// If we can't allocate the space then the card is nearly full, so don't keep trying
+		allocatedSize = (logFile.PreAllocate(length + LogFileExtent)) ? length + LogFileExtent : 0xFFFFFFFF;
+	}
+}
+
 // Write the data and time to the file followed by a space.
 // Caller must already have checked and set inLogger.
 bool Logger::WriteDateTime(time_t time)
 {
+	AllocateSpace();
 	char bufferSpace[30];
 	StringRef buf(bufferSpace, ARRAY_SIZE(bufferSpace));
 	if (time == 0)
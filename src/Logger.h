@@ -27,11 +27,13 @@ public:
 
 private:
 	bool WriteDateTime(time_t time);
+	void AllocateSpace();
 	void InternalLogMessage(time_t time, const char *message);
 
 	FileData logFile;
 	uint32_t lastFlushTime;
 	FilePosition lastFlushFileSize;
+	FilePosition allocatedSize;
 	bool dirty;
 	bool inLogger;
 };
@@ -25,6 +25,7 @@ public:
 	uint32_t NumPoints() const { return numX * numY; }
 	float GetXCoordinate(unsigned int xIndex) const;
 	float GetYCoordinate(unsigned int yIndex) const;
+	float GetXSpacing() const { return xSpacing; }
 	bool IsInRadius(float x, float y) const;
 	bool IsValid() const { return isValid; }
 
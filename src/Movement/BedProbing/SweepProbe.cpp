@@ -0,0 +1,162 @@
+/*
+ * SweepProbe.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include "SweepProbe.h"
+
+const float MinCalibrationSpan = 20.0;		// the minimum change in the probe reading over the calibration range that we accept
+
+SweepProbe::SweepProbe() : samplesIn(0), samplesOut(0), lostSamples(0), sampling(false), triggerHeight(0.0), range(DefaultSweepCalibrationRange)
+{
+	StartRow();
+}
+
+// Start or stop sampling. When we start, discard any samples left over from a previous move.
+void SweepProbe::SetSampling(bool on)
+{
+	if (on)
+	{
+		samplesOut = samplesIn;
+	}
+	sampling = on;
+}
+
+// Store a sample. This is called by the tick ISR, which is the only producer.
+void SweepProbe::AddSample(const float coords[XYZ_AXES], uint16_t reading)
+{
+	const size_t nextIn = (samplesIn + 1) % SweepSampleBufferSize;
+	if (nextIn == samplesOut)
+	{
+		++lostSamples;
+	}
+	else
+	{
+		SweepSample& s = samples[samplesIn];
+		for (size_t axis = 0; axis < XYZ_AXES; ++axis)
+		{
+			s.coords[axis] = coords[axis];
+		}
+		s.reading = reading;
+		samplesIn = nextIn;
+	}
+}
+
+// Fetch the oldest sample, returning false if there are none
+bool SweepProbe::GetSample(SweepSample& sample)
+{
+	const size_t out = samplesOut;
+	if (out == samplesIn)
+	{
+		return false;
+	}
+	sample = samples[out];
+	samplesOut = (out + 1) % SweepSampleBufferSize;
+	return true;
+}
+
+uint32_t SweepProbe::GetAndClearLostSamples()
+{
+	const uint32_t ret = lostSamples;
+	lostSamples = 0;
+	return ret;
+}
+
+void SweepProbe::StartCalibration(float pTriggerHeight, float pRange)
+{
+	triggerHeight = pTriggerHeight;
+	range = pRange;
+	for (size_t i = 0; i < SweepCalibrationBins; ++i)
+	{
+		calibrationReadings[i] = 0.0;
+		calibrationCounts[i] = 0;
+	}
+}
+
+void SweepProbe::AddCalibrationSample(const SweepSample& sample)
+{
+	const int bin = (int)(((sample.coords[Z_AXIS] - triggerHeight) * SweepCalibrationBins)/range);
+	if (bin >= 0 && bin < (int)SweepCalibrationBins)
+	{
+		calibrationReadings[bin] += (float)sample.reading;
+		++calibrationCounts[bin];
+	}
+}
+
+// Convert the calibration sums to mean readings, returning true with an error message if the probe can't be used for probing on the fly.
+// The reading increases as the probe gets closer to the bed. We make the table non-increasing with height so that we can invert it.
+bool SweepProbe::FinishCalibration(StringRef& reply)
+{
+	for (size_t i = 0; i < SweepCalibrationBins; ++i)
+	{
+		if (calibrationCounts[i] == 0)
+		{
+			reply.copy("Z probe calibration failed: too few readings, try a lower probing speed");
+			return true;
+		}
+		calibrationReadings[i] /= calibrationCounts[i];
+		if (i != 0 && calibrationReadings[i] > calibrationReadings[i - 1])
+		{
+			calibrationReadings[i] = calibrationReadings[i - 1];
+		}
+	}
+
+	if (calibrationReadings[0] - calibrationReadings[SweepCalibrationBins - 1] < MinCalibrationSpan)
+	{
+		reply.printf("Z probe calibration failed: the reading changes by less than %d over %.2fmm", (int)MinCalibrationSpan, (double)range);
+		return true;
+	}
+	return false;
+}
+
+// Return the head height at which the probe would have triggered at the position of this sample, or false if the reading is out of range
+bool SweepProbe::GetTriggerHeight(const SweepSample& sample, float& height) const
+{
+	const float reading = (float)sample.reading;
+	for (size_t i = 0; i + 1 < SweepCalibrationBins; ++i)
+	{
+		const float high = calibrationReadings[i], low = calibrationReadings[i + 1];
+		if (reading <= high && reading >= low && high > low)
+		{
+			// The reading corresponds to a height above the calibration trigger height between the centres of bins i and i + 1.
+			// The probe is that far above the point at which it would trigger.
+			const float heightAboveTrigger = ((float)i + 0.5 + (high - reading)/(high - low)) * range/SweepCalibrationBins;
+			height = sample.coords[Z_AXIS] - heightAboveTrigger;
+			return true;
+		}
+	}
+	return false;
+}
+
+void SweepProbe::StartRow()
+{
+	for (size_t i = 0; i < MaxXGridPoints; ++i)
+	{
+		rowHeightSums[i] = 0.0;
+		rowHeightCounts[i] = 0;
+	}
+}
+
+void SweepProbe::AddRowSample(size_t xIndex, float height)
+{
+	if (xIndex < MaxXGridPoints)
+	{
+		rowHeightSums[xIndex] += height;
+		++rowHeightCounts[xIndex];
+	}
+}
+
+// Get the mean height of the samples binned to a grid point, returning false if there were none
+bool SweepProbe::GetRowHeight(size_t xIndex, float& height) const
+{
+	if (xIndex >= MaxXGridPoints || rowHeightCounts[xIndex] == 0)
+	{
+		return false;
+	}
+	height = rowHeightSums[xIndex]/rowHeightCounts[xIndex];
+	return true;
+}
+
+// End
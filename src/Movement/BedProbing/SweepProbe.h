@@ -0,0 +1,73 @@
+/*
+ * SweepProbe.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SRC_MOVEMENT_BEDPROBING_SWEEPPROBE_H_
+#define SRC_MOVEMENT_BEDPROBING_SWEEPPROBE_H_
+
+#include "RepRapFirmware.h"
+#include "Libraries/General/StringRef.h"
+
+#if SAM4E || SAM4S
+const size_t SweepSampleBufferSize = 64;				// Number of Z probe samples we can buffer between the tick ISR and the G29 state machine
+#else
+const size_t SweepSampleBufferSize = 32;
+#endif
+const size_t SweepCalibrationBins = 16;					// Number of height bands we use to calibrate the probe reading against height
+const float DefaultSweepCalibrationRange = 1.0;			// Default height range over which we calibrate the probe reading, in mm
+const float SweepBinFraction = 0.25;					// We average the samples within this fraction of the grid spacing of each grid point
+
+// One Z probe reading taken while probing on the fly, with the XYZ machine position of the head when it was taken
+struct SweepSample
+{
+	float coords[XYZ_AXES];
+	uint16_t reading;
+};
+
+// Support for probing the bed on the fly with an analog Z probe.
+// We calibrate the probe reading against height at one point by lifting the head slowly after a normal probing move has triggered,
+// then sweep the probe along each row of the grid at a constant height. The tick ISR samples the probe reading during the steady speed
+// part of each sweep move and we convert the samples to trigger heights and bin them into the grid points of the row.
+class SweepProbe
+{
+public:
+	SweepProbe();
+
+	// Sampling, called from the tick ISR and the main loop
+	void SetSampling(bool on);
+	bool IsSampling() const { return sampling; }
+	void AddSample(const float coords[XYZ_AXES], uint16_t reading);	// called by the tick ISR
+	bool GetSample(SweepSample& sample);					// called by the main loop, returns false if there are no more samples
+	uint32_t GetAndClearLostSamples();
+
+	// Calibration
+	void StartCalibration(float pTriggerHeight, float pRange);
+	void AddCalibrationSample(const SweepSample& sample);
+	bool FinishCalibration(StringRef& reply);				// build the calibration table, returning true if the probe is unsuitable
+	float GetSweepHeight() const { return triggerHeight + 0.5 * range; }
+	bool GetTriggerHeight(const SweepSample& sample, float& height) const;	// return the head height at which the probe would have triggered here
+
+	// Binning the samples taken along one row of the grid
+	void StartRow();
+	void AddRowSample(size_t xIndex, float height);
+	bool GetRowHeight(size_t xIndex, float& height) const;
+
+private:
+	SweepSample samples[SweepSampleBufferSize];
+	volatile size_t samplesIn, samplesOut;
+	volatile uint32_t lostSamples;
+	volatile bool sampling;
+
+	float triggerHeight;									// the head height at which the probe triggered at the calibration point
+	float range;											// the height range we calibrated over
+	float calibrationReadings[SweepCalibrationBins];		// mean reading in each height band, made non-increasing with height
+	uint16_t calibrationCounts[SweepCalibrationBins];
+
+	float rowHeightSums[MaxXGridPoints];
+	uint16_t rowHeightCounts[MaxXGridPoints];
+};
+
+#endif /* SRC_MOVEMENT_BEDPROBING_SWEEPPROBE_H_ */
@@ -222,6 +222,10 @@ void DDA::Init()
 	endCoordinatesValid = false;
 	virtualExtruderPosition = 0;
 	filePos = noFilePosition;
+	for (float& adv : endAdvance)
+	{
+		adv = 0.0;
+	}
 
 #if SUPPORT_IOBITS
 	ioBits = 0;
@@ -235,7 +239,26 @@ bool DDA::Init(GCodes::RawMove &nextMove, bool doMotorMapping)
 	// 1. Compute the new endpoints and the movement vector
 	const int32_t * const positionNow = prev->DriveCoordinates();
 	const Move& move = reprap.GetMove();
-	if (doMotorMapping)
+	const size_t numAxes = reprap.GetGCodes().GetTotalAxes();
+
+	// Retractions, unretractions and other extruder-only moves are frequent, so recognise them here and skip the axis transformation for them.
+	// If the axis coordinates are unchanged from the end of the previous move then so are the motor positions of the axes.
+	bool extruderOnly = doMotorMapping && prev->endCoordinatesValid;
+	for (size_t axis = 0; extruderOnly && axis < numAxes; ++axis)
+	{
+		extruderOnly = (nextMove.coords[axis] == prev->endCoordinates[axis]);
+	}
+
+	if (extruderOnly)
+	{
+		for (size_t axis = 0; axis < numAxes; ++axis)
+		{
+			endPoint[axis] = positionNow[axis];
+		}
+		isDeltaMovement = false;
+		isJointMovement = false;
+	}
+	else if (doMotorMapping)
 	{
 		if (!move.CartesianToMotorSteps(nextMove.coords, endPoint, nextMove.isCoordinated))		// transform the axis coordinates if on a delta or CoreXY printer
 		{
@@ -243,10 +266,16 @@ bool DDA::Init(GCodes::RawMove &nextMove, bool doMotorMapping)
 		}
 		isDeltaMovement = move.IsDeltaMode()
 							&& (endPoint[X_AXIS] != positionNow[X_AXIS] || endPoint[Y_AXIS] != positionNow[Y_AXIS] || endPoint[Z_AXIS] != positionNow[Z_AXIS]);
+#if SUPPORT_SEGMENT_FREE_JOINTS
+		isJointMovement = InitJointKnots(nextMove, positionNow);
+#else
+		isJointMovement = false;
+#endif
 	}
 	else
 	{
 		isDeltaMovement = false;
+		isJointMovement = false;
 	}
 
 	xyMoving = false;
@@ -254,11 +283,14 @@ bool DDA::Init(GCodes::RawMove &nextMove, bool doMotorMapping)
 	bool realMove = false;
 	float accelerations[DRIVES];
 	const float * const normalAccelerations = reprap.GetPlatform().Accelerations();
-	const size_t numAxes = reprap.GetGCodes().GetTotalAxes();
 	for (size_t drive = 0; drive < DRIVES; drive++)
 	{
 		accelerations[drive] = normalAccelerations[drive];
-		if (drive >= numAxes || !doMotorMapping)
+		if (drive >= numAxes && nextMove.coords[drive] == 0.0)
+		{
+			endPoint[drive] = 0;							// travel moves don't use this extruder, so don't spend time converting it to steps
+		}
+		else if (drive >= numAxes || !doMotorMapping)
 		{
 			endPoint[drive] = Move::MotorEndPointToMachine(drive, nextMove.coords[drive]);
 		}
@@ -299,7 +331,7 @@ bool DDA::Init(GCodes::RawMove &nextMove, bool doMotorMapping)
 														// subtract the amount of extrusion we actually did to leave the residue outstanding
 				if (xyMoving && nextMove.usePressureAdvance)
 				{
-					const float compensationTime = reprap.GetPlatform().GetPressureAdvance(drive - numAxes);
+					const float compensationTime = reprap.GetPlatform().GetMaxPressureAdvance(drive - numAxes);
 					if (compensationTime > 0.0)
 					{
 						// Compensation causes instant velocity changes equal to acceleration * k, so we may need to limit the acceleration
@@ -339,6 +371,30 @@ bool DDA::Init(GCodes::RawMove &nextMove, bool doMotorMapping)
 		}
 	}
 
+#if SUPPORT_SEGMENT_FREE_JOINTS
+	// 2b. If it's a segment-free SCARA or polar move, a motor may move part way through the move even if its net movement is zero
+	if (isJointMovement)
+	{
+		for (size_t drive = 0; drive < XYZ_AXES; ++drive)
+		{
+			DriveMovement*& pdm = pddm[drive];
+			if (pdm == nullptr)
+			{
+				for (size_t seg = 0; seg < numJointSegments; ++seg)
+				{
+					if (jointKnots[seg][drive] != 0)
+					{
+						pdm = DriveMovement::Allocate(drive, DMState::moving);
+						pdm->totalSteps = 0;					// PrepareJointAxis calculates the real number of steps
+						pdm->direction = true;
+						break;
+					}
+				}
+			}
+		}
+	}
+#endif
+
 	// 3. Store some values
 	xAxes = nextMove.xAxes;
 	yAxes = nextMove.yAxes;
@@ -369,6 +425,8 @@ bool DDA::Init(GCodes::RawMove &nextMove, bool doMotorMapping)
 	endCoordinatesValid = (endStopsToCheck == 0) && doMotorMapping;
 
 	// 4. Normalise the direction vector and compute the amount of motion.
+	// If no axes are moving then their components of the direction vector are zero, so we need only consider the extruders.
+	const size_t firstDrive = (extruderOnly) ? numAxes : 0;
 	if (xyMoving)
 	{
 		// There is some XY movement, so normalise the direction vector so that the total XYZ movement has unit length and 'totalDistance' is the XYZ distance moved.
@@ -387,14 +445,14 @@ bool DDA::Init(GCodes::RawMove &nextMove, bool doMotorMapping)
 		// 1. Normalise the largest one to unit length. This means that when retracting multiple filaments, they all get the requested retract speed.
 		// 2. Normalise the sum to unit length. This means that when we use mixing, we get the requested extrusion rate at the nozzle.
 		// 3. Normalise the sum to the sum of the mixing coefficients (which we would have to include in the move details).
-		totalDistance = Normalise(directionVector, DRIVES, DRIVES);
+		totalDistance = Normalise(directionVector + firstDrive, DRIVES - firstDrive, DRIVES - firstDrive);
 	}
 
 	// 5. Compute the maximum acceleration available
 	float normalisedDirectionVector[DRIVES];			// Used to hold a unit-length vector in the direction of motion
 	memcpy(normalisedDirectionVector, directionVector, sizeof(normalisedDirectionVector));
-	Absolute(normalisedDirectionVector, DRIVES);
-	acceleration = VectorBoxIntersection(normalisedDirectionVector, accelerations, DRIVES);
+	Absolute(normalisedDirectionVector + firstDrive, DRIVES - firstDrive);
+	acceleration = VectorBoxIntersection(normalisedDirectionVector + firstDrive, accelerations + firstDrive, DRIVES - firstDrive);
 	if (xyMoving)
 	{
 		acceleration = min<float>(acceleration, (isPrintingMove) ? reprap.GetPlatform().GetMaxPrintingAcceleration() : reprap.GetPlatform().GetMaxTravelAcceleration());
@@ -424,11 +482,13 @@ bool DDA::Init(GCodes::RawMove &nextMove, bool doMotorMapping)
 
 	// Don't use the constrain function in the following, because if we have a very small XY movement and a lot of extrusion, we may have to make the
 	// speed lower than the 0.5mm/sec minimum. We must apply the minimum speed first and then limit it if necessary after that.
-	requestedSpeed = min<float>(max<float>(reqSpeed, 0.5), VectorBoxIntersection(normalisedDirectionVector, reprap.GetPlatform().MaxFeedrates(), DRIVES));
+	requestedSpeed = min<float>(max<float>(reqSpeed, 0.5),
+								VectorBoxIntersection(normalisedDirectionVector + firstDrive, reprap.GetPlatform().MaxFeedrates() + firstDrive, DRIVES - firstDrive));
 
 	// On a Cartesian printer, it is OK to limit the X and Y speeds and accelerations independently, and in consequence to allow greater values
 	// for diagonal moves. On a delta, this is not OK and any movement in the XY plane should be limited to the X/Y axis values, which we assume to be equal.
-	if (doMotorMapping)
+	// All the kinematics only restrict the axis components of the move, so there is nothing for them to do if only extruders are moving.
+	if (doMotorMapping && !extruderOnly)
 	{
 		reprap.GetMove().GetKinematics().LimitSpeedAndAcceleration(*this, normalisedDirectionVector);	// give the kinematics the chance to further restrict the speed and acceleration
 	}
@@ -496,6 +556,7 @@ bool DDA::Init(const float_t adjustments[DRIVES])
 	// 3. Store some values
 	isLeadscrewAdjustmentMove = true;
 	isDeltaMovement = false;
+	isJointMovement = false;
 	isPrintingMove = false;
 	xyMoving = false;
 	endStopsToCheck = 0;
@@ -738,6 +799,19 @@ float DDA::AdvanceBabyStepping(float amount)
 			{
 				int32_t steps = (int32_t)(babySteppingToDo * reprap.GetPlatform().DriveStepsPerUnit(Z_AXIS));
 				DriveMovement* const pdm = cdda->pddm[Z_AXIS];			// must be non-null because we allocated one earlier if necessary
+#if SUPPORT_SEGMENT_FREE_JOINTS
+				if (cdda->isJointMovement)
+				{
+					// Spread the babystepping evenly over the joint trajectory. PrepareJointAxis works out the number of steps from the knots.
+					for (size_t seg = 0; seg < cdda->numJointSegments; ++seg)
+					{
+						cdda->jointKnots[seg][Z_AXIS] += (steps * (int32_t)(seg + 1))/(int32_t)cdda->numJointSegments;
+					}
+					pdm->state = DMState::moving;
+					steps = 0;													// the step count and direction set below are recalculated by PrepareJointAxis
+				}
+				else
+#endif
 				if (pdm->state == DMState::moving)
 				{
 					if (pdm->direction)		// if moving up
@@ -842,6 +916,175 @@ void DDA::RecalculateMove()
 	clocksNeeded = (uint32_t)(totalTime * stepClockRate);
 }
 
+// Get the Cartesian XYZ position of the head at the specified step clock, returning false if the time is not in the steady speed phase of this move.
+// This is called by the tick ISR when probing the bed on the fly. The steady speed phase is not affected by S-curve acceleration.
+bool DDA::GetSteadyPhasePosition(uint32_t clocks, float coords[XYZ_AXES]) const
+{
+	const int32_t clocksSinceStart = (int32_t)(clocks - moveStartTime);
+	if (state != executing || !endCoordinatesValid || clocksSinceStart < 0)
+	{
+		return false;
+	}
+
+	const float steadyDistance = totalDistance - accelDistance - decelDistance;
+	const float steadyDistanceDone = ((float)clocksSinceStart/stepClockRate - (topSpeed - startSpeed)/acceleration) * topSpeed;
+	if (steadyDistanceDone < 0.0 || steadyDistanceDone > steadyDistance)
+	{
+		return false;
+	}
+
+	const float distanceLeft = totalDistance - accelDistance - steadyDistanceDone;
+	for (size_t axis = 0; axis < XYZ_AXES; ++axis)
+	{
+		coords[axis] = endCoordinates[axis] - directionVector[axis] * distanceLeft;
+	}
+	return true;
+}
+
+// Dynamic acceleration adjustment. A constant acceleration that lasts for a whole number of periods of the machine's ringing frequency
+// leaves no residual vibration at that frequency, so reduce the acceleration until the longer of the acceleration and deceleration phases
+// lasts a whole number of periods. When the start and end speeds are equal, that makes both phases a whole number of periods.
+// This is called when the move is about to be frozen, so the start and end speeds are final and we must not change them.
+void DDA::AdjustAccelerationForShaping(float period)
+{
+	const float minSpeed = min<float>(startSpeed, endSpeed);
+	const float phaseTime = (topSpeed - minSpeed)/acceleration;
+	if (phaseTime <= 0.0)
+	{
+		return;
+	}
+	const float numPeriods = ceilf(phaseTime/period - 0.02);			// accept phases up to 2% longer than a whole number of periods
+	const float targetTime = numPeriods * period;
+	if (targetTime <= phaseTime * 1.02)
+	{
+		return;															// already close enough
+	}
+
+	// If the move still reaches the same top speed then the phase time is inversely proportional to the acceleration
+	float newAcceleration = acceleration * phaseTime/targetTime;
+	if (2 * fsquare(requestedSpeed) - fsquare(startSpeed) - fsquare(endSpeed) >= 2 * newAcceleration * totalDistance)
+	{
+		// The move has no steady speed phase, so the top speed depends on the acceleration.
+		// Solve (minSpeed + a * targetTime)^2 = a * totalDistance + (startSpeed^2 + endSpeed^2)/2 for a.
+		const float b = totalDistance - 2 * minSpeed * targetTime;
+		const float c = 0.5 * (fsquare(startSpeed) + fsquare(endSpeed)) - fsquare(minSpeed);
+		newAcceleration = (b + sqrtf(fsquare(b) + 4 * fsquare(targetTime) * c))/(2 * fsquare(targetTime));
+	}
+
+	const float minAcceleration = fabsf(fsquare(endSpeed) - fsquare(startSpeed))/(2 * totalDistance);	// we must still reach the end speed
+	if (newAcceleration < acceleration && newAcceleration > minAcceleration)
+	{
+		const uint32_t originalClocksNeeded = clocksNeeded;
+		acceleration = newAcceleration;
+		RecalculateMove();
+		reprap.GetMove().RecordShapedMove((float)(clocksNeeded - originalClocksNeeded)/stepClockRate);
+	}
+}
+
+#if SUPPORT_SCURVE
+
+// An S-curve phase that changes the speed by dv with peak acceleration a and jerk j lasts dv/a + a/j, or 2*sqrt(dv/j) if it never
+// reaches the peak acceleration. Reduce the acceleration of the trapezoid if necessary so that each of its phases lasts at least that long.
+// Then an S-curve with the same duration fits within the acceleration and jerk limits. Like the other adjustments made when we prepare
+// a move, this must not change the start or end speed.
+void DDA::AdjustAccelerationForJerk(float maxJerk)
+{
+	const float peakAcceleration = acceleration;
+	const float minAcceleration = fabsf(fsquare(endSpeed) - fsquare(startSpeed))/(2 * totalDistance);	// we must still reach the end speed
+
+	// Reducing the acceleration may reduce the top speed, which shortens the S-curves we need, so a few passes may be needed
+	for (unsigned int pass = 0; pass < 3; ++pass)
+	{
+		float newAcceleration = acceleration;
+		const float speedChanges[2] = { topSpeed - startSpeed, topSpeed - endSpeed };
+		for (float dv : speedChanges)
+		{
+			if (dv > 0.0)
+			{
+				const float minTime = (dv * maxJerk >= fsquare(peakAcceleration))
+										? dv/peakAcceleration + peakAcceleration/maxJerk
+										: 2 * sqrtf(dv/maxJerk);
+				newAcceleration = min<float>(newAcceleration, dv/minTime);
+			}
+		}
+
+		if (newAcceleration >= acceleration * 0.999)
+		{
+			break;
+		}
+		acceleration = max<float>(newAcceleration, minAcceleration * 1.001);
+		RecalculateMove();
+	}
+}
+
+// Return the distance moved after time t of an S-curve phase. The jerk phases at the start and end each last peakAcceleration/jerk.
+/*static*/ float TimeWarp::SCurveDistance(float t, float v0, float v1, float phaseTime, float jerk, float peakAcceleration)
+{
+	const float jerkTime = peakAcceleration/jerk;
+	if (v1 < v0)
+	{
+		jerk = -jerk;
+		peakAcceleration = -peakAcceleration;
+	}
+
+	if (t <= jerkTime)
+	{
+		return t * (v0 + jerk * fsquare(t)/6);
+	}
+	if (t >= phaseTime - jerkTime)
+	{
+		const float timeLeft = phaseTime - t;
+		return 0.5 * (v0 + v1) * phaseTime - timeLeft * (v1 - jerk * fsquare(timeLeft)/6);
+	}
+	const float t2 = t - jerkTime;
+	return jerkTime * (v0 + jerk * fsquare(jerkTime)/6) + t2 * (v0 + 0.5 * jerk * fsquare(jerkTime) + 0.5 * peakAcceleration * t2);
+}
+
+// Set up the mapping from a constant-acceleration phase to an S-curve with the same duration and start and end speeds
+void TimeWarp::Init(float phaseStartTime, float phaseTime, float startSpeed, float endSpeed, float maxJerk)
+{
+	startClocks = (uint32_t)(phaseStartTime * DDA::stepClockRate);
+	phaseClocks = (uint32_t)(phaseTime * DDA::stepClockRate);
+	if (phaseClocks < 4 * NumIntervals)
+	{
+		phaseClocks = 0;					// too short to be worth doing
+		return;
+	}
+	intervalsPerClock = (float)NumIntervals/(float)phaseClocks;
+
+	// Find the peak acceleration of the S-curve from dv/a + a/j = phaseTime. If the phase is too short for the jerk limit because
+	// AdjustAccelerationForJerk couldn't lengthen it enough, use the lowest jerk that fits.
+	const float dv = fabsf(endSpeed - startSpeed);
+	const float jerk = max<float>(maxJerk, 4 * dv/fsquare(phaseTime));
+	const float peakAcceleration = 0.5 * (jerk * phaseTime - sqrtf(max<float>(fsquare(jerk * phaseTime) - 4 * jerk * dv, 0.0)));
+
+	// For each knot, find the time at which the S-curve reaches the distance that the trapezoid reaches at the time of the knot
+	const float acceleration = (endSpeed - startSpeed)/phaseTime;
+	knots[0] = 0;
+	for (size_t i = 1; i < NumIntervals; ++i)
+	{
+		const float trapezoidTime = (phaseTime * i)/NumIntervals;
+		const float distance = trapezoidTime * (startSpeed + 0.5 * acceleration * trapezoidTime);
+		float low = 0.0, high = phaseTime;
+		for (unsigned int iteration = 0; iteration < 20; ++iteration)
+		{
+			const float mid = 0.5 * (low + high);
+			if (SCurveDistance(mid, startSpeed, endSpeed, phaseTime, jerk, peakAcceleration) < distance)
+			{
+				low = mid;
+			}
+			else
+			{
+				high = mid;
+			}
+		}
+		knots[i] = max<uint32_t>((uint32_t)(0.5 * (low + high) * DDA::stepClockRate), knots[i - 1]);
+	}
+	knots[NumIntervals] = phaseClocks;
+}
+
+#endif
+
 // Decide what speed we would really like this move to end at.
 // On entry, endSpeed is our proposed ending speed and targetNextSpeed is the proposed starting speed of the next move
 // On return, targetNextSpeed is the speed we would like the next move to start at, and endSpeed is the corresponding end speed of this move.
@@ -968,9 +1211,33 @@ pre(disableDeltaMapping || drive < MaxAxes)
 // This must not be called with interrupts disabled, because it calls Platform::EnableDrive.
 void DDA::Prepare(uint8_t simMode)
 {
+#if SUPPORT_SCURVE
+	const float maxJerk = reprap.GetMove().GetMaxJerk();
+	usingSCurve = (maxJerk > 0.0 && endStopsToCheck == 0 && !isLeadscrewAdjustmentMove);
+	if (usingSCurve)
+	{
+		AdjustAccelerationForJerk(maxJerk);
+	}
+#endif
+
+	if (xyMoving && endStopsToCheck == 0)
+	{
+		const float shapingPeriod = reprap.GetMove().GetShapingPeriod();
+		if (shapingPeriod > 0.0)
+		{
+			AdjustAccelerationForShaping(shapingPeriod);
+		}
+	}
+
 	PrepParams params;
 	params.decelStartDistance = totalDistance - decelDistance;
 
+	// Extruders that don't move in this move, or move backwards, end it with no pressure advance
+	for (float& adv : endAdvance)
+	{
+		adv = 0.0;
+	}
+
 	if (simMode == 0)
 	{
 		if (isDeltaMovement)
@@ -997,13 +1264,32 @@ void DDA::Prepare(uint8_t simMode)
 		extraAccelerationClocks = roundS32((accelStopTime - (accelDistance/topSpeed)) * stepClockRate);
 		params.compFactor = (topSpeed - startSpeed)/topSpeed;
 
+#if SUPPORT_SEGMENT_FREE_JOINTS
+		if (isJointMovement)
+		{
+			jointSegmentLength = totalDistance/numJointSegments;
+			jointDecelStartDistance = params.decelStartDistance;
+			jointTwoCsquaredDivA = (float)(stepClockRateSquared * 2)/acceleration;
+			jointCdivTopSpeed = (float)stepClockRate/topSpeed;
+			jointEndSpeedTimesCdivA = (endSpeed * stepClockRate)/acceleration;
+		}
+#endif
+
+#if SUPPORT_SCURVE
+		if (usingSCurve)
+		{
+			accelWarp.Init(0.0, accelStopTime, startSpeed, topSpeed, maxJerk);
+			decelWarp.Init(decelStartTime, (topSpeed - endSpeed)/acceleration, topSpeed, endSpeed, maxJerk);
+		}
+#endif
+
 		firstDM = nullptr;
 
 		const size_t numAxes = reprap.GetGCodes().GetTotalAxes();
 		for (size_t drive = 0; drive < DRIVES; ++drive)
 		{
 			DriveMovement* const pdm = pddm[drive];
-			if (pddm != nullptr && pdm->state == DMState::moving)
+			if (pdm != nullptr && pdm->state == DMState::moving)
 			{
 				if (isLeadscrewAdjustmentMove)
 				{
@@ -1021,7 +1307,7 @@ void DDA::Prepare(uint8_t simMode)
 					reprap.GetPlatform().EnableDrive(drive);
 					if (drive >= numAxes)
 					{
-						pdm->PrepareExtruder(*this, params, usePressureAdvance);
+						endAdvance[drive - numAxes] = pdm->PrepareExtruder(*this, params, usePressureAdvance);
 
 						// Check for sensible values, print them if they look dubious
 						if (reprap.Debug(moduleDda)
@@ -1045,6 +1331,18 @@ void DDA::Prepare(uint8_t simMode)
 							DebugPrint();
 						}
 					}
+#if SUPPORT_SEGMENT_FREE_JOINTS
+					else if (isJointMovement && drive < XYZ_AXES)
+					{
+						pdm->PrepareJointAxis(*this);
+
+						// Check for sensible values, print them if they look dubious
+						if (reprap.Debug(moduleDda) && pdm->totalSteps > 1000000)
+						{
+							DebugPrint();
+						}
+					}
+#endif
 					else
 					{
 						pdm->PrepareCartesianAxis(*this, params);
@@ -1064,6 +1362,9 @@ void DDA::Prepare(uint8_t simMode)
 				pdm->stepsTillRecalc = 0;							// so that we don't skip the calculation
 				const bool stepsToDo = (isDeltaMovement && drive < numAxes)
 										? pdm->CalcNextStepTimeDelta(*this, false)
+#if SUPPORT_SEGMENT_FREE_JOINTS
+										: (pdm->jointMotion) ? pdm->CalcNextStepTimeJoint(*this, false)
+#endif
 										: pdm->CalcNextStepTimeCartesian(*this, false);
 				if (stepsToDo)
 				{
@@ -1171,6 +1472,78 @@ float DDA::NormaliseXYZ()
 	return magnitude;
 }
 
+#if SUPPORT_SEGMENT_FREE_JOINTS
+
+static_assert(MaxJointSegments <= KinematicsBatchSize + 1, "Joint trajectory knots must fit in one kinematics batch");
+
+// Set up the joint trajectory of a SCARA or polar move, returning true if the move needs one.
+// We calculate the motor positions at evenly-spaced points along the straight line path, using the segment length that segmentation would have used.
+// Between these knots the motor positions are linear in the distance along the path, so the path error is the same as if the move had been
+// segmented, but the move is executed as a single DDA with a single speed profile. The final knot is the end point, so this must be called after
+// the end point has been calculated.
+bool DDA::InitJointKnots(const GCodes::RawMove &nextMove, const int32_t positionNow[])
+{
+	const Move& move = reprap.GetMove();
+	const Kinematics& kin = move.GetKinematics();
+	if (   kin.GetMotionType(X_AXIS) != MotionType::segmentFreeJoint
+		|| !kin.UseSegmentation()
+		|| !nextMove.isCoordinated									// uncoordinated moves may change the arm mode part way through
+		|| nextMove.endStopsToCheck != 0
+	   )
+	{
+		return false;
+	}
+
+	const size_t numAxes = reprap.GetGCodes().GetTotalAxes();
+	float startCoords[MaxAxes];
+	for (size_t axis = 0; axis < numAxes; ++axis)
+	{
+		startCoords[axis] = prev->GetEndCoordinate(axis, false);
+	}
+
+	const float xyLength = sqrtf(fsquare(nextMove.coords[X_AXIS] - startCoords[X_AXIS]) + fsquare(nextMove.coords[Y_AXIS] - startCoords[Y_AXIS]));
+	const float moveTime = xyLength/nextMove.feedRate;				// this is a best-case time, often the move will take longer
+	const int segments = min<int>((int)MaxJointSegments, min<int>(rintf(xyLength/kin.GetMinSegmentLength()), rintf(moveTime * kin.GetSegmentsPerSecond())));
+	if (segments < 2)
+	{
+		return false;												// moving the motors linearly is good enough
+	}
+
+	// Convert all the knots except the last one in a single batch. The last one is the end point, which we already have.
+	const size_t numKnots = (size_t)segments - 1;
+	float knotCoords[MaxAxes][KinematicsBatchSize];
+	int32_t knotPositions[MaxAxes][KinematicsBatchSize];
+	for (size_t axis = 0; axis < numAxes; ++axis)
+	{
+		const float startCoord = startCoords[axis];
+		const float axisDistance = nextMove.coords[axis] - startCoord;
+		for (size_t knot = 0; knot < numKnots; ++knot)
+		{
+			knotCoords[axis][knot] = startCoord + axisDistance * ((float)(knot + 1)/(float)segments);
+		}
+	}
+	if (!move.CartesianToMotorStepsBatch(knotCoords, numKnots, knotPositions, true))
+	{
+		return false;												// a knot is unreachable, so fall back to moving the motors linearly
+	}
+	for (size_t knot = 0; knot < numKnots; ++knot)
+	{
+		for (size_t drive = 0; drive < XYZ_AXES; ++drive)
+		{
+			jointKnots[knot][drive] = knotPositions[drive][knot] - positionNow[drive];
+		}
+	}
+
+	for (size_t drive = 0; drive < XYZ_AXES; ++drive)
+	{
+		jointKnots[segments - 1][drive] = endPoint[drive] - positionNow[drive];
+	}
+	numJointSegments = (uint8_t)segments;
+	return true;
+}
+
+#endif
+
 // Return the magnitude of a vector
 /*static*/ float DDA::Magnitude(const float v[], size_t dimensions)
 {
@@ -1202,11 +1575,19 @@ float DDA::NormaliseXYZ()
 
 void DDA::CheckEndstops(Platform& platform)
 {
+	// Switches that have pin change interrupts attached only need attention once they have triggered
+	if (   (endStopsToCheck & LogProbeChanges) == 0
+		&& !platform.EndstopsNeedChecking(endStopsToCheck & LowestNBits<AxesBitmap>(MaxAxes), (endStopsToCheck & ZProbeActive) != 0)
+	   )
+	{
+		return;
+	}
+
 	if ((endStopsToCheck & ZProbeActive) != 0)						// if the Z probe is enabled in this move
 	{
 		// Check whether the Z probe has been triggered. On a delta at least, this must be done separately from endstop checks,
 		// because we have both a high endstop and a Z probe, and the Z motor is not the same thing as the Z axis.
-		switch (platform.GetZProbeResult())
+		switch (platform.GetMoveZProbeResult())
 		{
 		case EndStopHit::lowHit:
 			MoveAborted();											// set the state to completed and recalculate the endpoints
@@ -1255,7 +1636,7 @@ void DDA::CheckEndstops(Platform& platform)
 	{
 		if (IsBitSet(endStopsToCheck, drive))
 		{
-			const EndStopHit esh = platform.Stopped(drive);
+			const EndStopHit esh = platform.GetMoveEndstopResult(drive);
 			switch (esh)
 			{
 			case EndStopHit::lowHit:
@@ -1310,6 +1691,11 @@ pre(state == frozen)
 	moveStartTime = tim;
 	state = executing;
 
+	if ((endStopsToCheck & (ZProbeActive | LowestNBits<AxesBitmap>(MaxAxes))) != 0)
+	{
+		reprap.GetPlatform().EnableEndstopInterrupts(endStopsToCheck & LowestNBits<AxesBitmap>(MaxAxes), (endStopsToCheck & ZProbeActive) != 0);
+	}
+
 #if DDA_LOG_PROBE_CHANGES
 	if ((endStopsToCheck & LogProbeChanges) != 0)
 	{
@@ -1445,6 +1831,9 @@ bool DDA::Step()
 		{
 			const bool hasMoreSteps = (isDeltaMovement && dmToInsert->drive < DELTA_AXES)
 					? dmToInsert->CalcNextStepTimeDelta(*this, true)
+#if SUPPORT_SEGMENT_FREE_JOINTS
+					: (dmToInsert->jointMotion) ? dmToInsert->CalcNextStepTimeJoint(*this, true)
+#endif
 					: dmToInsert->CalcNextStepTimeCartesian(*this, true);
 			DriveMovement * const nextToInsert = dmToInsert->nextDM;
 			if (hasMoreSteps)
@@ -1530,6 +1919,102 @@ void DDA::MoveAborted()
 	state = completed;
 }
 
+// Bring the currently-executing move to a stop as soon as we can using the normal deceleration, so that we can pause part way through it.
+// This is called with interrupts disabled. If we can do it, return true with the end points of the move adjusted to where we will stop
+// and proportionDone set to the proportion of extrusion for the complete multi-segment move that will have been done by then.
+// We don't do this for delta, joint or S-curve moves or for moves that check endstops, because the step times don't follow the simple trapezoid.
+bool DDA::DecelerateToStop(float& proportionDone)
+{
+	if (   state != executing || filePos == noFilePosition || endStopsToCheck != 0 || goingSlow || isDeltaMovement || isLeadscrewAdjustmentMove
+#if SUPPORT_SCURVE
+		|| usingSCurve
+#endif
+#if SUPPORT_SEGMENT_FREE_JOINTS
+		|| isJointMovement
+#endif
+	   )
+	{
+		return false;
+	}
+
+	// Work out how far into the move we are and how fast we are going
+	const int32_t clocksSoFar = max<int32_t>((int32_t)(Platform::GetInterruptClocks() - moveStartTime), 0);
+	const float timeSoFar = (float)clocksSoFar/stepClockRate;
+	const float accelStopTime = (topSpeed - startSpeed)/acceleration;
+	const float decelStartTime = accelStopTime + (totalDistance - accelDistance - decelDistance)/topSpeed;
+	if (timeSoFar >= decelStartTime)
+	{
+		return false;										// we are already decelerating, so we may as well let the move finish
+	}
+
+	float speedNow, distanceSoFar;
+	if (timeSoFar < accelStopTime)
+	{
+		speedNow = startSpeed + acceleration * timeSoFar;
+		distanceSoFar = (startSpeed + 0.5 * acceleration * timeSoFar) * timeSoFar;
+	}
+	else
+	{
+		speedNow = topSpeed;
+		distanceSoFar = accelDistance + topSpeed * (timeSoFar - accelStopTime);
+	}
+	const float stopDistance = distanceSoFar + fsquare(speedNow)/(2 * acceleration);
+	if (stopDistance >= totalDistance)
+	{
+		return false;										// we can't stop before the end of the move
+	}
+
+	// We can't change the motion of a drive that has already started reversing because of pressure advance
+	for (const DriveMovement *pdm = firstDM; pdm != nullptr; pdm = pdm->nextDM)
+	{
+		if (pdm->reverseStartStep <= pdm->totalSteps && pdm->nextStep >= pdm->reverseStartStep)
+		{
+			return false;
+		}
+	}
+
+	// Get the proportion of extrusion done, before we change the move parameters
+	const float proportionDoneAtStart = GetProportionDone(false);
+	proportionDone = proportionDoneAtStart + ((1.0 - proportionLeft) - proportionDoneAtStart) * (stopDistance/totalDistance);
+
+	// Start decelerating now. The deceleration phase has the same form as at the end of a normal move, so we only need to change its parameters.
+	const uint32_t speedNowTimesCdivA = (uint32_t)roundU32((speedNow * stepClockRate)/acceleration);
+	const uint64_t newTwoDistanceToStopTimesCsquaredDivA =
+			isquare64(speedNowTimesCdivA) + roundU64((distanceSoFar * (stepClockRateSquared * 2))/acceleration);
+	const size_t numAxes = reprap.GetGCodes().GetTotalAxes();
+	for (size_t drive = 0; drive < DRIVES; ++drive)
+	{
+		DriveMovement* const pdm = pddm[drive];
+		if (pdm != nullptr && pdm->state == DMState::moving)
+		{
+			const float stepsPerMm = (drive < numAxes)
+										? (float)pdm->totalSteps/totalDistance
+										: reprap.GetPlatform().DriveStepsPerUnit(drive) * fabsf(directionVector[drive]);
+			const int32_t netStepsLeftBefore = pdm->GetNetStepsLeft();
+			pdm->DecelerateToStop(newTwoDistanceToStopTimesCsquaredDivA, (uint32_t)(stopDistance * stepsPerMm));
+			if (drive < numAxes)
+			{
+				endPoint[drive] += pdm->GetNetStepsLeft() - netStepsLeftBefore;
+			}
+		}
+	}
+
+	topSpeedTimesCdivAPlusDecelStartClocks = clocksSoFar + speedNowTimesCdivA;
+	clocksNeeded = topSpeedTimesCdivAPlusDecelStartClocks;
+
+	// Record the shortened trapezoid so that anything else that looks at this move sees consistent values
+	if (timeSoFar < accelStopTime)
+	{
+		topSpeed = speedNow;
+		accelDistance = distanceSoFar;
+	}
+	decelDistance = stopDistance - distanceSoFar;
+	totalDistance = stopDistance;
+	endSpeed = 0.0;
+	endCoordinatesValid = false;
+	return true;
+}
+
 // Return the proportion of extrusion for the complete multi-segment move that has already been done.
 // The move was either not started or was aborted.
 float DDA::GetProportionDone(bool moveWasAborted) const
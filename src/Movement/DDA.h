@@ -18,6 +18,49 @@
 #define DDA_LOG_PROBE_CHANGES	0		// save memory on the wired Duet
 #endif
 
+#if SUPPORT_SEGMENT_FREE_JOINTS
+const size_t MaxJointSegments = 8;				// the maximum number of segments in the joint trajectory of a segment-free SCARA or polar move
+#endif
+
+#if SUPPORT_SCURVE
+
+// This maps the step times of one acceleration or deceleration phase of a trapezoidal move onto the corresponding times of an S-curve
+// (jerk-limited) profile with the same duration, start speed and end speed, and hence the same distance. Because every drive in a move
+// follows the same distance/time profile, one mapping per phase serves all drives, and the step time calculations in the ISR are unchanged
+// except that their results are passed through Apply. The mapping is tabulated at evenly-spaced knots and interpolated linearly.
+class TimeWarp
+{
+public:
+	static constexpr size_t NumIntervals = 8;
+
+	void Clear() { phaseClocks = 0; }
+	void Init(float phaseStartTime, float phaseTime, float startSpeed, float endSpeed, float maxJerk);
+	uint32_t Apply(uint32_t t) const __attribute__ ((hot));
+
+private:
+	static float SCurveDistance(float t, float v0, float v1, float phaseTime, float jerk, float peakAcceleration);
+
+	uint32_t startClocks;					// when the phase starts, in step clocks since the start of the move
+	uint32_t phaseClocks;					// how long the phase lasts, or zero if there is no mapping
+	float intervalsPerClock;				// NumIntervals/phaseClocks
+	uint32_t knots[NumIntervals + 1];		// the S-curve times corresponding to evenly spaced trapezoid times, relative to the start of the phase
+};
+
+// Map a time in the trapezoidal profile to the corresponding time in the S-curve profile
+inline uint32_t TimeWarp::Apply(uint32_t t) const
+{
+	const uint32_t offset = t - startClocks;		// if t is before the start of the phase then this wraps round to a large value
+	if (offset >= phaseClocks)
+	{
+		return t;
+	}
+	const float pos = (float)offset * intervalsPerClock;
+	const size_t index = min<size_t>((size_t)pos, NumIntervals - 1);
+	return startClocks + knots[index] + (uint32_t)((float)(knots[index + 1] - knots[index]) * (pos - (float)index));
+}
+
+#endif
+
 /**
  * This defines a single linear movement of the print head
  */
@@ -46,6 +89,7 @@ public:
 	void SetNext(DDA *n) { next = n; }
 	void SetPrevious(DDA *p) { prev = p; }
 	void Complete() { state = completed; }
+	void Detach() { state = empty; }								// Stop the step ISR starting this move, without releasing its DMs yet
 	bool Free();
 	void Prepare(uint8_t simMode) __attribute__ ((hot));			// Calculate all the values and freeze this DDA
 	bool HasStepError() const;
@@ -78,8 +122,10 @@ public:
 	float GetProportionDone(bool moveWasAborted) const;				// Return the proportion of extrusion for the complete multi-segment move already done
 
 	void MoveAborted();
+	bool DecelerateToStop(float& proportionDone);					// Bring the executing move to a controlled stop early so that we can pause part way through it
 
 	uint32_t GetClocksNeeded() const { return clocksNeeded; }
+	bool GetSteadyPhasePosition(uint32_t clocks, float coords[XYZ_AXES]) const;	// Get the head position at a time in the steady speed phase
 	bool IsGoodToPrepare() const;
 
 #if SUPPORT_IOBITS
@@ -125,15 +171,24 @@ public:
 private:
 	void RecalculateMove() __attribute__ ((hot));
 	void CalcNewSpeeds() __attribute__ ((hot));
+	void AdjustAccelerationForShaping(float period);				// Reduce the acceleration so that the acceleration phases don't excite ringing
+#if SUPPORT_SCURVE
+	void AdjustAccelerationForJerk(float maxJerk);					// Reduce the acceleration so that each phase is long enough for an S-curve
+	uint32_t WarpTime(uint32_t t) const { return decelWarp.Apply(accelWarp.Apply(t)); }	// Convert a trapezoidal step time to an S-curve one
+#endif
 	void ReduceHomingSpeed();										// called to reduce homing speed when a near-endstop is triggered
 	void StopDrive(size_t drive);									// stop movement of a drive and recalculate the endpoint
 	void InsertDM(DriveMovement *dm) __attribute__ ((hot));
 	void RemoveDM(size_t drive);
 	void ReleaseDMs();
 	bool IsDecelerationMove() const;								// return true if this move is or have been might have been intended to be a deceleration-only move
+	float GetEndAdvance(size_t extruder) const { return endAdvance[extruder]; }	// return the pressure advance distance of an extruder at the end of this move
 	void DebugPrintVector(const char *name, const float *vec, size_t len) const;
 	void CheckEndstops(Platform& platform);
 	float NormaliseXYZ();											// Make the direction vector unit-normal in XYZ
+#if SUPPORT_SEGMENT_FREE_JOINTS
+	bool InitJointKnots(const GCodes::RawMove &nextMove, const int32_t positionNow[]);	// Set up the joint trajectory of a SCARA or polar move
+#endif
 
 	static void DoLookahead(DDA *laDDA);							// Try to smooth out moves in the queue
     static float Normalise(float v[], size_t dim1, size_t dim2);  	// Normalise a vector of dim1 dimensions to unit length in the first dim1 dimensions
@@ -162,6 +217,8 @@ private:
 			uint8_t xyMoving : 1;					// True if movement along an X axis or the Y axis was requested, even it if's too small to do
 			uint8_t goingSlow : 1;					// True if we have slowed the movement because the Z probe is approaching its threshold
 			uint8_t isLeadscrewAdjustmentMove : 1;	// True if this is a leadscrews adjustment move
+			uint8_t usingSCurve : 1;				// True if the step times are mapped onto an S-curve profile
+			uint8_t isJointMovement : 1;			// True if the XYZ motors follow a joint trajectory through several knots
 		};
 		uint16_t flags;								// so that we can print all the flags at once for debugging
 	};
@@ -199,6 +256,7 @@ private:
 	uint32_t startSpeedTimesCdivA;			// the number of clocks it would have taken t reach the start speed form rest
 	uint32_t topSpeedTimesCdivAPlusDecelStartClocks;
 	int32_t extraAccelerationClocks;		// the additional number of clocks needed because we started the move at less than topSpeed. Negative after ReduceHomingSpeed has been called.
+	float endAdvance[MaxExtruders];			// how far pressure advance leaves each extruder ahead of its nominal position at the end of this move, in mm of filament
 
 	float proportionLeft;					// what proportion of the extrusion in the G1 or G0 move of which this is a part remains to be done after this segment is complete
 
@@ -206,6 +264,22 @@ private:
 	IoBits_t ioBits;						// port state required during this move
 #endif
 
+#if SUPPORT_SCURVE
+	TimeWarp accelWarp;						// maps the acceleration phase onto an S-curve
+	TimeWarp decelWarp;						// maps the deceleration phase onto an S-curve
+#endif
+
+#if SUPPORT_SEGMENT_FREE_JOINTS
+	// These are used only for segment-free SCARA and polar moves. The knots are set up by Init, the other values by Prepare.
+	int32_t jointKnots[MaxJointSegments][XYZ_AXES];	// motor positions relative to the start of the move at the end of each segment
+	float jointSegmentLength;				// the path distance covered by each segment
+	float jointDecelStartDistance;			// the path distance at which deceleration starts
+	float jointTwoCsquaredDivA;				// 2 * clock^2 / acceleration
+	float jointCdivTopSpeed;				// clock / topSpeed
+	float jointEndSpeedTimesCdivA;			// endSpeed * clock / acceleration
+	uint8_t numJointSegments;				// how many segments the joint trajectory has
+#endif
+
 #if DDA_LOG_PROBE_CHANGES
 	static bool probeTriggered;
 
@@ -43,6 +43,7 @@ DriveMovement *DriveMovement::Allocate(size_t drive, DMState st)
 		dm->nextDM = nullptr;
 		dm->drive = (uint8_t)drive;
 		dm->state = st;
+		dm->jointMotion = false;
 	}
 	return dm;
 }
@@ -62,6 +63,7 @@ void DriveMovement::PrepareCartesianAxis(const DDA& dda, const PrepParams& param
 
 	// Acceleration phase parameters
 	mp.cart.accelStopStep = (uint32_t)(dda.accelDistance * stepsPerMm) + 1;
+	mp.cart.twoStartDistanceTimesCsquaredDivA = (int64_t)isquare64(dda.startSpeedTimesCdivA);
 	mp.cart.compensationClocks = mp.cart.accelCompensationClocks = 0;
 
 	// Constant speed phase parameters
@@ -168,27 +170,64 @@ void DriveMovement::PrepareDeltaAxis(const DDA& dda, const PrepParams& params)
 	}
 }
 
-// Prepare this DM for an extruder move
-void DriveMovement::PrepareExtruder(const DDA& dda, const PrepParams& params, bool doCompensation)
+#if SUPPORT_SEGMENT_FREE_JOINTS
+
+// Prepare this DM for a segment-free SCARA or polar move. The DDA holds the motor positions at the ends of the segments of the joint trajectory.
+// The motor may change direction at any knot, so the total number of steps is the sum of the steps in each segment.
+void DriveMovement::PrepareJointAxis(const DDA& dda)
 {
+	jointMotion = true;
+	totalSteps = 0;
+	int32_t position = 0;
+	for (size_t seg = 0; seg < dda.numJointSegments; ++seg)
+	{
+		totalSteps += (uint32_t)labs(dda.jointKnots[seg][drive] - position);
+		position = dda.jointKnots[seg][drive];
+	}
+	mp.joint.totalNetSteps = position;
+	mp.joint.segmentStartStep = mp.joint.segmentEndStep = 0;
+	mp.joint.segmentStartPosition = 0;
+	mp.joint.nextSegment = 0;
+	mp.joint.mmPerStep = 0.0;
+
+	// We don't use the reverse phase
+	reverseStartStep = totalSteps + 1;
+	twoDistanceToStopTimesCsquaredDivA = 0;
+}
+
+#endif
+
+// Prepare this DM for an extruder move, returning how far ahead of its nominal position pressure advance leaves the extruder at the end of the move
+float DriveMovement::PrepareExtruder(const DDA& dda, const PrepParams& params, bool doCompensation)
+{
+	const size_t extruder = drive - reprap.GetGCodes().GetTotalAxes();
 	const float dv = dda.directionVector[drive];
 	const float stepsPerMm = reprap.GetPlatform().DriveStepsPerUnit(drive) * fabsf(dv);
 	mp.cart.twoCsquaredTimesMmPerStepDivA = roundU64((double)(DDA::stepClockRateSquared * 2)/((double)stepsPerMm * (double)dda.acceleration));
 
-	// Calculate the pressure advance parameter
-	const float compensationTime = (doCompensation && dv > 0.0) ? reprap.GetPlatform().GetPressureAdvance(drive - reprap.GetGCodes().GetTotalAxes()) : 0.0;
+	// Calculate the pressure advance parameter. It may depend on the peak extrusion rate of this move.
+	const float compensationTime = (doCompensation && dv > 0.0)
+									? reprap.GetPlatform().GetPressureAdvance(extruder, dda.topSpeed * dv)
+									: 0.0;
 	mp.cart.compensationClocks = roundU32(compensationTime * (float)DDA::stepClockRate);
-	mp.cart.accelCompensationClocks = roundU32(compensationTime * (float)DDA::stepClockRate * params.compFactor);
+
+	// If the previous move used a different pressure advance, the extruder is not as far ahead at the start of this move as we would like.
+	// Work out the shortfall as a distance along this move. We make up the shortfall during this move, so that the total extrusion is unaffected.
+	const float startAdvanceShortfall = (compensationTime * dda.startSpeed) - (dda.prev->GetEndAdvance(extruder)/dv);
+	const uint32_t adjustedStartSpeedTimesCdivA = dda.startSpeedTimesCdivA + mp.cart.compensationClocks;
+	mp.cart.twoStartDistanceTimesCsquaredDivA = (int64_t)isquare64(adjustedStartSpeedTimesCdivA)
+													- roundS64((startAdvanceShortfall * (float)(DDA::stepClockRateSquared * 2))/dda.acceleration);
+	mp.cart.accelCompensationClocks = roundS32(((compensationTime * params.compFactor) + startAdvanceShortfall/dda.topSpeed) * (float)DDA::stepClockRate);
 
 	// Calculate the net total step count to allow for compensation. It may be negative.
-	const float compensationDistance = (dda.endSpeed - dda.startSpeed) * compensationTime;
+	const float compensationDistance = ((dda.endSpeed - dda.startSpeed) * compensationTime) + startAdvanceShortfall;
 	const int32_t netSteps = (int32_t)(compensationDistance * stepsPerMm) + (int32_t)totalSteps;
 
 	// Calculate the acceleration phase parameters
-	const float accelCompensationDistance = compensationTime * (dda.topSpeed - dda.startSpeed);
+	const float accelCompensationDistance = (compensationTime * (dda.topSpeed - dda.startSpeed)) + startAdvanceShortfall;
 
 	// Acceleration phase parameters
-	mp.cart.accelStopStep = (uint32_t)((dda.accelDistance + accelCompensationDistance) * stepsPerMm) + 1;
+	mp.cart.accelStopStep = (uint32_t)max<float>((dda.accelDistance + accelCompensationDistance) * stepsPerMm + 1.0, 0.0);
 
 	// Constant speed phase parameters
 	mp.cart.mmPerStepTimesCKdivtopSpeed = (uint32_t)((float)((uint64_t)DDA::stepClockRate * K1)/(stepsPerMm * dda.topSpeed));
@@ -204,11 +243,12 @@ void DriveMovement::PrepareExtruder(const DDA& dda, const PrepParams& params, bo
 	}
 	else
 	{
-		mp.cart.decelStartStep = (uint32_t)((params.decelStartDistance + accelCompensationDistance) * stepsPerMm) + 1;
+		const float decelStartExtruderDistance = max<float>(params.decelStartDistance + accelCompensationDistance, 0.0);
+		mp.cart.decelStartStep = (uint32_t)(decelStartExtruderDistance * stepsPerMm) + 1;
 		const int32_t initialDecelSpeedTimesCdivA = (int32_t)params.topSpeedTimesCdivA - (int32_t)mp.cart.compensationClocks;	// signed because it may be negative and we square it
 		const uint64_t initialDecelSpeedTimesCdivASquared = isquare64(initialDecelSpeedTimesCdivA);
 		twoDistanceToStopTimesCsquaredDivA =
-			initialDecelSpeedTimesCdivASquared + roundU64(((params.decelStartDistance + accelCompensationDistance) * (float)(DDA::stepClockRateSquared * 2))/dda.acceleration);
+			initialDecelSpeedTimesCdivASquared + roundU64((decelStartExtruderDistance * (float)(DDA::stepClockRateSquared * 2))/dda.acceleration);
 
 		// Calculate the move distance to the point of zero speed, where reverse motion starts
 		const float initialDecelSpeed = dda.topSpeed - dda.acceleration * compensationTime;
@@ -245,6 +285,8 @@ void DriveMovement::PrepareExtruder(const DDA& dda, const PrepParams& params, bo
 			}
 		}
 	}
+
+	return compensationTime * dda.endSpeed * dv;			// compensationTime is zero if there is no pressure advance or the extruder is retracting
 }
 
 void DriveMovement::DebugPrint(char c, bool isDeltaMovement) const
@@ -256,6 +298,16 @@ void DriveMovement::DebugPrint(char c, bool isDeltaMovement) const
 					c, (state == DMState::stepError) ? " ERR:" : ":", (direction) ? 'F' : 'B', totalSteps, nextStep, reverseStartStep, stepInterval,
 					twoDistanceToStopTimesCsquaredDivA);
 
+#if SUPPORT_SEGMENT_FREE_JOINTS
+		if (jointMotion)
+		{
+			debugPrintf("segStart=%" PRIu32 " segEnd=%" PRIu32 " segStartPos=%" PRIi32 " net=%" PRIi32 " nextSeg=%u mmPerStep=%.5f\n",
+						mp.joint.segmentStartStep, mp.joint.segmentEndStep, mp.joint.segmentStartPosition, mp.joint.totalNetSteps,
+						mp.joint.nextSegment, (double)mp.joint.mmPerStep
+						);
+		}
+		else
+#endif
 		if (isDeltaMovement)
 		{
 			debugPrintf("hmz0sK=%" PRIi32 " minusAaPlusBbTimesKs=%" PRIi32 " dSquaredMinusAsquaredMinusBsquared=%" PRId64 "\n"
@@ -267,7 +319,7 @@ void DriveMovement::DebugPrint(char c, bool isDeltaMovement) const
 		else
 		{
 			debugPrintf("accelStopStep=%" PRIu32 " decelStartStep=%" PRIu32 " 2CsqtMmPerStepDivA=%" PRIu64 "\n"
-						"mmPerStepTimesCdivtopSpeed=%" PRIu32 " fmsdmtstdca2=%" PRId64 " cc=%" PRIu32 " acc=%" PRIu32 "\n",
+						"mmPerStepTimesCdivtopSpeed=%" PRIu32 " fmsdmtstdca2=%" PRId64 " cc=%" PRIu32 " acc=%" PRIi32 "\n",
 						mp.cart.accelStopStep, mp.cart.decelStartStep, mp.cart.twoCsquaredTimesMmPerStepDivA,
 						mp.cart.mmPerStepTimesCKdivtopSpeed, mp.cart.fourMaxStepDistanceMinusTwoDistanceToStopTimesCsquaredDivA, mp.cart.compensationClocks, mp.cart.accelCompensationClocks
 						);
@@ -315,16 +367,19 @@ pre(nextStep < totalSteps; stepsTillRecalc == 0)
 	if (nextCalcStep < mp.cart.accelStopStep)
 	{
 		// acceleration phase
+		// If the extruder has advance to make up from the previous move, the first few steps may be due at the start of the move
 		const uint32_t adjustedStartSpeedTimesCdivA = dda.startSpeedTimesCdivA + mp.cart.compensationClocks;
-		nextStepTime = isqrt64(isquare64(adjustedStartSpeedTimesCdivA) + (mp.cart.twoCsquaredTimesMmPerStepDivA * nextCalcStep)) - adjustedStartSpeedTimesCdivA;
+		const int64_t temp = mp.cart.twoStartDistanceTimesCsquaredDivA + (int64_t)(mp.cart.twoCsquaredTimesMmPerStepDivA * nextCalcStep);
+		const uint32_t root = (temp > 0) ? isqrt64((uint64_t)temp) : 0;
+		nextStepTime = (root > adjustedStartSpeedTimesCdivA) ? root - adjustedStartSpeedTimesCdivA : 0;
 	}
 	else if (nextCalcStep < mp.cart.decelStartStep)
 	{
 		// steady speed phase
-		nextStepTime = (uint32_t)(  (int32_t)(((uint64_t)mp.cart.mmPerStepTimesCKdivtopSpeed * nextCalcStep)/K1)
+		const int32_t stepTime = (int32_t)(((uint64_t)mp.cart.mmPerStepTimesCKdivtopSpeed * nextCalcStep)/K1)
 								  + dda.extraAccelerationClocks
-								  - (int32_t)mp.cart.accelCompensationClocks
-								 );
+								  - mp.cart.accelCompensationClocks;
+		nextStepTime = (stepTime > 0) ? (uint32_t)stepTime : 0;
 	}
 	else if (nextCalcStep < reverseStartStep)
 	{
@@ -332,9 +387,8 @@ pre(nextStep < totalSteps; stepsTillRecalc == 0)
 		const uint64_t temp = mp.cart.twoCsquaredTimesMmPerStepDivA * nextCalcStep;
 		const uint32_t adjustedTopSpeedTimesCdivAPlusDecelStartClocks = dda.topSpeedTimesCdivAPlusDecelStartClocks - mp.cart.compensationClocks;
 		// Allow for possible rounding error when the end speed is zero or very small
-		nextStepTime = (temp < twoDistanceToStopTimesCsquaredDivA)
-						? adjustedTopSpeedTimesCdivAPlusDecelStartClocks - isqrt64(twoDistanceToStopTimesCsquaredDivA - temp)
-						: adjustedTopSpeedTimesCdivAPlusDecelStartClocks;
+		const uint32_t root = (temp < twoDistanceToStopTimesCsquaredDivA) ? isqrt64(twoDistanceToStopTimesCsquaredDivA - temp) : 0;
+		nextStepTime = (root < adjustedTopSpeedTimesCdivAPlusDecelStartClocks) ? adjustedTopSpeedTimesCdivAPlusDecelStartClocks - root : 0;
 	}
 	else
 	{
@@ -352,6 +406,13 @@ pre(nextStep < totalSteps; stepsTillRecalc == 0)
 							+ isqrt64((int64_t)(mp.cart.twoCsquaredTimesMmPerStepDivA * nextCalcStep) - mp.cart.fourMaxStepDistanceMinusTwoDistanceToStopTimesCsquaredDivA);
 	}
 
+#if SUPPORT_SCURVE
+	if (dda.usingSCurve)
+	{
+		nextStepTime = dda.WarpTime(nextStepTime);
+	}
+#endif
+
 	stepInterval = (nextStepTime - lastStepTime) >> shiftFactor;	// calculate the time per step, ready for next time
 
 	if (nextStepTime > dda.clocksNeeded)
@@ -466,6 +527,13 @@ pre(nextStep < totalSteps; stepsTillRecalc == 0)
 						: dda.topSpeedTimesCdivAPlusDecelStartClocks;
 	}
 
+#if SUPPORT_SCURVE
+	if (dda.usingSCurve)
+	{
+		nextStepTime = dda.WarpTime(nextStepTime);
+	}
+#endif
+
 	stepInterval = (nextStepTime - lastStepTime) >> shiftFactor;	// calculate the time per step, ready for next time
 
 	if (nextStepTime > dda.clocksNeeded)
@@ -489,6 +557,121 @@ pre(nextStep < totalSteps; stepsTillRecalc == 0)
 	return true;
 }
 
+#if SUPPORT_SEGMENT_FREE_JOINTS
+
+// Calculate the time since the start of the move when the next step for the specified DriveMovement is due
+// Return true if there are more steps to do
+// Within each segment of the joint trajectory the motor position is linear in the distance travelled along the path, so we find the
+// path distance at which the step is due and convert it to a time using the speed profile of the move.
+bool DriveMovement::CalcNextStepTimeJointFull(const DDA &dda, bool live)
+pre(nextStep <= totalSteps; stepsTillRecalc == 0)
+{
+	if (nextStep > mp.joint.segmentEndStep)
+	{
+		// Move on to the next segment in which this drive moves, reversing the motor if necessary
+		size_t seg = mp.joint.nextSegment;
+		const int32_t startPosition = (seg == 0) ? 0 : dda.jointKnots[seg - 1][drive];
+		while (seg < dda.numJointSegments && dda.jointKnots[seg][drive] == startPosition)
+		{
+			++seg;
+		}
+		if (seg >= dda.numJointSegments)
+		{
+			state = DMState::stepError;
+			nextStep += 1000000;						// so that we can tell what happened in the debug print
+			return false;
+		}
+
+		const int32_t delta = dda.jointKnots[seg][drive] - startPosition;
+		if ((delta > 0) != (bool)direction)
+		{
+			direction = (delta > 0);
+			if (live)
+			{
+				reprap.GetPlatform().SetDirection(drive, direction);
+			}
+		}
+		const uint32_t segmentSteps = (uint32_t)labs(delta);
+		mp.joint.segmentStartStep = mp.joint.segmentEndStep;
+		mp.joint.segmentEndStep += segmentSteps;
+		mp.joint.segmentStartPosition = startPosition;
+		mp.joint.mmPerStep = dda.jointSegmentLength/(float)segmentSteps;
+		mp.joint.nextSegment = (uint8_t)(seg + 1);
+	}
+
+	// Work out how many steps to calculate at a time.
+	// We never multi-step past the end of a segment, because the direction may change there.
+	uint32_t shiftFactor = 0;		// assume single stepping
+	if (stepInterval < DDA::MinCalcIntervalCartesian)
+	{
+		const uint32_t stepsToLimit = mp.joint.segmentEndStep - nextStep;
+		if (stepInterval < DDA::MinCalcIntervalCartesian/4 && stepsToLimit > 8)
+		{
+			shiftFactor = 3;		// octal stepping
+		}
+		else if (stepInterval < DDA::MinCalcIntervalCartesian/2 && stepsToLimit > 4)
+		{
+			shiftFactor = 2;		// quad stepping
+		}
+		else if (stepsToLimit > 2)
+		{
+			shiftFactor = 1;		// double stepping
+		}
+	}
+
+	stepsTillRecalc = (1u << shiftFactor) - 1u;					// store number of additional steps to generate
+
+	const uint32_t nextCalcStep = nextStep + stepsTillRecalc;
+	const float distance = (float)(mp.joint.nextSegment - 1) * dda.jointSegmentLength + (float)(nextCalcStep - mp.joint.segmentStartStep) * mp.joint.mmPerStep;
+	float stepTime;
+	if (distance < dda.accelDistance)
+	{
+		// Acceleration phase
+		stepTime = sqrtf(fsquare((float)dda.startSpeedTimesCdivA) + dda.jointTwoCsquaredDivA * distance) - (float)dda.startSpeedTimesCdivA;
+	}
+	else if (distance < dda.jointDecelStartDistance)
+	{
+		// Steady speed phase
+		stepTime = distance * dda.jointCdivTopSpeed + (float)dda.extraAccelerationClocks;
+	}
+	else
+	{
+		// Deceleration phase. Work from the end of the move so that we don't lose precision when the end speed is low.
+		const float distanceToEnd = max<float>(dda.totalDistance - distance, 0.0);
+		stepTime = (float)dda.topSpeedTimesCdivAPlusDecelStartClocks - sqrtf(fsquare(dda.jointEndSpeedTimesCdivA) + dda.jointTwoCsquaredDivA * distanceToEnd);
+	}
+
+	const uint32_t lastStepTime = nextStepTime;					// pick up the time of the last step
+	nextStepTime = (stepTime > 0.0) ? (uint32_t)stepTime : 0;
+
+#if SUPPORT_SCURVE
+	if (dda.usingSCurve)
+	{
+		nextStepTime = dda.WarpTime(nextStepTime);
+	}
+#endif
+
+	stepInterval = (nextStepTime - lastStepTime) >> shiftFactor;	// calculate the time per step, ready for next time
+
+	if (nextStepTime > dda.clocksNeeded)
+	{
+		// The calculation makes this step late. If this is the last step or the penultimate one, bring it forward to the expected finish time.
+		if (nextStep + 1 >= totalSteps)
+		{
+			nextStepTime = dda.clocksNeeded;
+		}
+		else
+		{
+			state = DMState::stepError;
+			stepInterval = 10000000 + nextStepTime;				// so we can tell what happened in the debug print
+			return false;
+		}
+	}
+	return true;
+}
+
+#endif
+
 // Reduce the speed of this movement. Called to reduce the homing speed when we detect we are near the endstop for a drive.
 void DriveMovement::ReduceSpeed(const DDA& dda, uint32_t inverseSpeedFactor)
 {
@@ -512,4 +695,21 @@ void DriveMovement::ReduceSpeed(const DDA& dda, uint32_t inverseSpeedFactor)
 	}
 }
 
+// Make this drive decelerate from now on and stop at the specified step, because we are pausing part way through the move.
+// The caller has checked that this is a Cartesian or extruder drive that has not started its reverse phase.
+// We drop any pressure advance for the rest of the move, because the extruder is about to come to rest.
+void DriveMovement::DecelerateToStop(uint64_t newTwoDistanceToStopTimesCsquaredDivA, uint32_t stopStep)
+{
+	// Force the deceleration phase
+	mp.cart.accelStopStep = 0;
+	mp.cart.decelStartStep = 0;
+	mp.cart.compensationClocks = mp.cart.accelCompensationClocks = 0;
+	twoDistanceToStopTimesCsquaredDivA = newTwoDistanceToStopTimesCsquaredDivA;
+
+	// We can't take back steps that we have already committed to, and we must not go beyond the original end of the forward phase
+	const uint32_t forwardSteps = (reverseStartStep <= totalSteps) ? reverseStartStep - 1 : totalSteps;
+	totalSteps = max<uint32_t>(nextStep + stepsTillRecalc, min<uint32_t>(forwardSteps, stopStep));
+	reverseStartStep = totalSteps + 1;						// no reverse phase
+}
+
 // End
@@ -123,10 +123,15 @@ public:
 
 	bool CalcNextStepTimeCartesian(const DDA &dda, bool live) __attribute__ ((hot));
 	bool CalcNextStepTimeDelta(const DDA &dda, bool live) __attribute__ ((hot));
+#if SUPPORT_SEGMENT_FREE_JOINTS
+	bool CalcNextStepTimeJoint(const DDA &dda, bool live) __attribute__ ((hot));
+	void PrepareJointAxis(const DDA& dda) __attribute__ ((hot));
+#endif
 	void PrepareCartesianAxis(const DDA& dda, const PrepParams& params) __attribute__ ((hot));
 	void PrepareDeltaAxis(const DDA& dda, const PrepParams& params) __attribute__ ((hot));
-	void PrepareExtruder(const DDA& dda, const PrepParams& params, bool doCompensation) __attribute__ ((hot));
+	float PrepareExtruder(const DDA& dda, const PrepParams& params, bool doCompensation) __attribute__ ((hot));
 	void ReduceSpeed(const DDA& dda, uint32_t inverseSpeedFactor);
+	void DecelerateToStop(uint64_t newTwoDistanceToStopTimesCsquaredDivA, uint32_t stopStep);
 	void DebugPrint(char c, bool withDelta) const;
 	int32_t GetNetStepsLeft() const;
 	int32_t GetNetStepsTaken() const;
@@ -145,6 +150,9 @@ public:
 private:
 	bool CalcNextStepTimeCartesianFull(const DDA &dda, bool live) __attribute__ ((hot));
 	bool CalcNextStepTimeDeltaFull(const DDA &dda, bool live) __attribute__ ((hot));
+#if SUPPORT_SEGMENT_FREE_JOINTS
+	bool CalcNextStepTimeJointFull(const DDA &dda, bool live) __attribute__ ((hot));
+#endif
 
 	static DriveMovement *freeList;
 	static int numFree;
@@ -158,14 +166,15 @@ private:
 	uint8_t drive;										// the drive that this DM controls
 	uint8_t microstepShift : 4,							// log2 of the microstepping factor
 			direction : 1,								// true=forwards, false=backwards
-			fullCurrent : 1;							// true if the drivers are set to the full current, false if they are set to the standstill current
+			fullCurrent : 1,							// true if the drivers are set to the full current, false if they are set to the standstill current
+			jointMotion : 1;							// true if this drive follows the joint trajectory of a segment-free SCARA or polar move
 	uint8_t stepsTillRecalc;							// how soon we need to recalculate
 
 	uint32_t totalSteps;								// total number of steps for this move
 
 	// These values change as the step is executed
 	uint32_t nextStep;									// number of steps already done
-	uint32_t reverseStartStep;							// the step number for which we need to reverse direction due to pressure advance or delta movement
+	uint32_t reverseStartStep;							// the step number for which we need to reverse direction due to pressure advance or delta movement (not used for joint motion)
 	uint32_t nextStepTime;								// how many clocks after the start of this move the next step is due
 	uint32_t stepInterval;								// how many clocks between steps
 
@@ -179,6 +188,7 @@ private:
 		{
 			// The following don't depend on how the move is executed, so they could be set up in Init()
 			uint64_t twoCsquaredTimesMmPerStepDivA;		// 2 * clock^2 * mmPerStepInHyperCuboidSpace / acceleration
+			int64_t twoStartDistanceTimesCsquaredDivA;	// (startSpeed * clock/acceleration + compensationClocks)^2 less any advance carried over from the previous move, can be negative
 
 			// The following depend on how the move is executed, so they must be set up in Prepare()
 			int64_t fourMaxStepDistanceMinusTwoDistanceToStopTimesCsquaredDivA;		// this one can be negative
@@ -186,7 +196,7 @@ private:
 			uint32_t decelStartStep;					// the first step number at which we are decelerating
 			uint32_t mmPerStepTimesCKdivtopSpeed;		// mmPerStepInHyperCuboidSpace * clock / topSpeed
 			uint32_t compensationClocks;				// the pressure advance time in clocks
-			uint32_t accelCompensationClocks;			// compensationClocks * (1 - startSpeed/topSpeed)
+			int32_t accelCompensationClocks;			// compensationClocks * (1 - startSpeed/topSpeed) plus any carried over advance, can be negative
 		} cart;
 
 		struct DeltaParameters							// Parameters for delta movement
@@ -202,6 +212,16 @@ private:
 			uint32_t decelStartDsK;
 			uint32_t mmPerStepTimesCKdivtopSpeed;
 		} delta;
+
+		struct JointParameters							// Parameters for the piecewise-linear joint trajectory of a segment-free SCARA or polar move
+		{
+			float mmPerStep;							// the path distance per step in the current segment
+			uint32_t segmentStartStep;					// the number of steps taken before the current segment
+			uint32_t segmentEndStep;					// the number of the last step in the current segment
+			int32_t segmentStartPosition;				// the motor position at the start of the current segment, relative to the start of the move
+			int32_t totalNetSteps;						// the motor position at the end of the move, relative to the start of the move
+			uint8_t nextSegment;						// the index of the segment after the current one
+		} joint;
 	} mp;
 
 	static constexpr uint32_t NoStepTime = 0xFFFFFFFF;	// value to indicate that no further steps are needed when calculating the next step time
@@ -254,10 +274,40 @@ inline bool DriveMovement::CalcNextStepTimeDelta(const DDA &dda, bool live)
 	return false;
 }
 
+#if SUPPORT_SEGMENT_FREE_JOINTS
+
+// Calculate the time since the start of the move when the next step for the specified DriveMovement is due
+// Return true if there are more steps to do. When finished, leave nextStep == totalSteps + 1.
+inline bool DriveMovement::CalcNextStepTimeJoint(const DDA &dda, bool live)
+{
+	++nextStep;
+	if (nextStep <= totalSteps)
+	{
+		if (stepsTillRecalc != 0)
+		{
+			--stepsTillRecalc;			// we are doing double/quad/octal stepping
+			return true;
+		}
+		return CalcNextStepTimeJointFull(dda, live);
+	}
+
+	state = DMState::idle;
+	return false;
+}
+
+#endif
+
 // Return the number of net steps left for the move in the forwards direction.
 // We have already taken nextSteps - 1 steps, unless nextStep is zero.
 inline int32_t DriveMovement::GetNetStepsLeft() const
 {
+#if SUPPORT_SEGMENT_FREE_JOINTS
+	if (jointMotion)
+	{
+		return mp.joint.totalNetSteps - GetNetStepsTaken();
+	}
+#endif
+
 	int32_t netStepsLeft;
 	if (reverseStartStep > totalSteps)		// if no reverse phase
 	{
@@ -279,6 +329,19 @@ inline int32_t DriveMovement::GetNetStepsLeft() const
 // We have already taken nextSteps - 1 steps, unless nextStep is zero.
 inline int32_t DriveMovement::GetNetStepsTaken() const
 {
+#if SUPPORT_SEGMENT_FREE_JOINTS
+	if (jointMotion)
+	{
+		// The direction may have changed several times, but only at segment boundaries
+		if (nextStep == 0)
+		{
+			return 0;
+		}
+		const int32_t stepsInSegment = (int32_t)(nextStep - 1 - mp.joint.segmentStartStep);
+		return mp.joint.segmentStartPosition + ((direction) ? stepsInSegment : -stepsInSegment);
+	}
+#endif
+
 	int32_t netStepsTaken;
 	if (nextStep < reverseStartStep || reverseStartStep > totalSteps)				// if no reverse phase, or not started it yet
 	{
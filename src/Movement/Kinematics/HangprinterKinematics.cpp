@@ -47,36 +47,40 @@ void HangprinterKinematics::Init()
 void HangprinterKinematics::Recalc()
 {
 	printRadiusSquared = fsquare(printRadius);
-	Da2 = fsquare(anchorA[0]) + fsquare(anchorA[1]) + fsquare(anchorA[2]);
-	Db2 = fsquare(anchorB[0]) + fsquare(anchorB[1]) + fsquare(anchorB[2]);
-	Dc2 = fsquare(anchorC[0]) + fsquare(anchorC[1]) + fsquare(anchorC[2]);
-	Xab = anchorA[0] - anchorB[0];
-	Xbc = anchorB[0] - anchorC[0];
-	Xca = anchorC[0] - anchorA[0];
-	Yab = anchorA[1] - anchorB[1];
-	Ybc = anchorB[1] - anchorC[1];
-	Yca = anchorC[1] - anchorA[1];
-	Zab = anchorB[2] - anchorC[2];
-	Zbc = anchorB[2] - anchorC[2];
-	Zca = anchorC[2] - anchorA[2];
-	P = (  anchorB[0] * Yca
-		 - anchorA[0] * anchorC[1]
-		 + anchorA[1] * anchorC[0]
-		 - anchorB[1] * Xca
-		) * 2;
-	P2 = fsquare(P);
-	Q = (  anchorB[1] * Zca
-		 - anchorA[1] * anchorC[2]
-		 + anchorA[2] * anchorC[1]
-		 - anchorB[2] * Yca
-		) * 2;
-	R = - (  anchorB[0] * Zca
-		   + anchorA[0] * anchorC[2]
-		   + anchorA[2] * anchorC[0]
-		   - anchorB[2] * Xca
-		  ) * 2;
-	U = (anchorA[2] * P2) + (anchorA[0] * Q * P) + (anchorA[1] * R * P);
-	A = (P2 + fsquare(Q) + fsquare(R)) * 2;
+
+	// Set up a coordinate frame for the inverse transform, with its origin at anchor A, its X axis towards anchor B and anchor C in its XY plane.
+	// Make its Z axis point upwards, so that the print head is on the positive Z side of the plane of the A, B and C anchors.
+	float ac[3];
+	for (size_t axis = 0; axis < 3; ++axis)
+	{
+		unitX[axis] = anchorB[axis] - anchorA[axis];
+		ac[axis] = anchorC[axis] - anchorA[axis];
+	}
+	anchorABDistance = sqrtf(fsquare(unitX[0]) + fsquare(unitX[1]) + fsquare(unitX[2]));
+	for (size_t axis = 0; axis < 3; ++axis)
+	{
+		unitX[axis] /= anchorABDistance;
+	}
+	anchorCX = unitX[0] * ac[0] + unitX[1] * ac[1] + unitX[2] * ac[2];
+	for (size_t axis = 0; axis < 3; ++axis)
+	{
+		unitY[axis] = ac[axis] - anchorCX * unitX[axis];
+	}
+	anchorCY = sqrtf(fsquare(unitY[0]) + fsquare(unitY[1]) + fsquare(unitY[2]));
+	for (size_t axis = 0; axis < 3; ++axis)
+	{
+		unitY[axis] /= anchorCY;
+	}
+	unitZ[0] = unitX[1] * unitY[2] - unitX[2] * unitY[1];
+	unitZ[1] = unitX[2] * unitY[0] - unitX[0] * unitY[2];
+	unitZ[2] = unitX[0] * unitY[1] - unitX[1] * unitY[0];
+	if (unitZ[2] < 0.0)
+	{
+		for (float& f : unitZ)
+		{
+			f = -f;
+		}
+	}
 }
 
 // Return the name of the current kinematics
@@ -156,7 +160,7 @@ bool HangprinterKinematics::CartesianToMotorSteps(const float machinePos[], cons
 	const float dSquared =    fsquare(machinePos[X_AXIS])
 							+ fsquare(machinePos[Y_AXIS])
 							+ fsquare(anchorDz - machinePos[Z_AXIS]);
-	if (aSquared < 0.0 && bSquared < 0.0 && cSquared < 0.0 && dSquared < 0.0)
+	if (aSquared >= 0.0 && bSquared >= 0.0 && cSquared >= 0.0 && dSquared >= 0.0)
 	{
 		motorPos[A_AXIS] = lrintf(sqrtf(aSquared) * stepsPerMm[A_AXIS]);
 		motorPos[B_AXIS] = lrintf(sqrtf(bSquared) * stepsPerMm[B_AXIS]);
@@ -297,28 +301,23 @@ bool HangprinterKinematics::WriteResumeSettings(FileStore *f) const
 }
 
 // Calculate the Cartesian coordinates from the motor coordinates
+// The print head is where the spheres of radius La, Lb and Lc centred on the A, B and C anchors meet. They meet at two points, one either side
+// of the plane of the anchors, and we want the one above it. If the line lengths are inconsistent and the spheres don't meet, we use the point
+// in the plane of the anchors that is closest to meeting them.
 void HangprinterKinematics::InverseTransform(float La, float Lb, float Lc, float machinePos[3]) const
 {
-	// Calculate PQRST such that x = (Qz + S)/P, y = (Rz + T)/P
-	const float S = - Yab * (fsquare(Lc) - Dc2)
-					- Yca * (fsquare(Lb) - Db2)
-					- Ybc * (fsquare(La) - Da2);
-	const float T = - Xab * (fsquare(Lc) - Dc2)
-					+ Xca * (fsquare(Lb) - Db2)
-					+ Xbc * (fsquare(La) - Da2);
-
-	// Calculate quadratic equation coefficients
-	const float halfB = (S * Q) - (R * T) - U;
-	const float C = fsquare(S) + fsquare(T) + (anchorA[1] * T - anchorA[0] * S) * P * 2 + (Da2 - fsquare(La)) * P2;
-
-	// Solve the quadratic equation for z
-	machinePos[2] = (- halfB - sqrtf(fsquare(halfB) - A * C))/A;
-
-	// Substitute back for X and Y
-	machinePos[0] = (Q * machinePos[2] + S)/P;
-	machinePos[1] = (R * machinePos[2] + T)/P;
-
-	debugPrintf("Motor %.2f,%.2f,%.2f to Cartesian %.2f,%.2f,%.2f\n", (double)La, (double)Lb, (double)Lc, (double)machinePos[0], (double)machinePos[1], (double)machinePos[2]);
+	// Find the point in the anchor coordinate frame set up by Recalc()
+	const float La2 = fsquare(La);
+	const float x = (La2 - fsquare(Lb) + fsquare(anchorABDistance))/(2 * anchorABDistance);
+	const float y = (La2 - fsquare(Lc) + fsquare(anchorCX) + fsquare(anchorCY))/(2 * anchorCY) - (anchorCX/anchorCY) * x;
+	const float z2 = La2 - fsquare(x) - fsquare(y);
+	const float z = (z2 > 0.0) ? sqrtf(z2) : 0.0;
+
+	// Convert it to machine coordinates
+	for (size_t axis = 0; axis < 3; ++axis)
+	{
+		machinePos[axis] = anchorA[axis] + x * unitX[axis] + y * unitY[axis] + z * unitZ[axis];
+	}
 }
 
 // Auto calibrate from a set of probe points returning true if it failed
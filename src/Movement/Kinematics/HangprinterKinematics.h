@@ -57,11 +57,9 @@ private:
 
 	// Derived parameters
 	float printRadiusSquared;
-	float Da2, Db2, Dc2;
-	float Xab, Xbc, Xca;
-	float Yab, Ybc, Yca;
-	float Zab, Zbc, Zca;
-	float P, Q, R, P2, U, A;
+	float unitX[3], unitY[3], unitZ[3];					// unit vectors of the coordinate frame that InverseTransform works in
+	float anchorABDistance;								// distance from anchor A to anchor B, which is on the X axis of that frame
+	float anchorCX, anchorCY;							// X and Y coordinates of anchor C in that frame
 
 	bool doneAutoCalibration;							// True if we have done auto calibration
 };
@@ -47,6 +47,44 @@ bool Kinematics::Configure(unsigned int mCode, GCodeBuffer& gb, StringRef& reply
 	return false;
 }
 
+// Convert a batch of Cartesian coordinates to motor positions. This is the fallback for kinematics that don't have a batched implementation.
+bool Kinematics::CartesianToMotorStepsBatch(const float machinePos[][KinematicsBatchSize], const float stepsPerMm[], size_t numVisibleAxes, size_t numTotalAxes,
+												size_t numPoints, int32_t motorPos[][KinematicsBatchSize], bool isCoordinated) const
+{
+	for (size_t point = 0; point < numPoints; ++point)
+	{
+		float pointCoords[MaxAxes];
+		int32_t pointMotorPos[MaxAxes];
+		for (size_t axis = 0; axis < numVisibleAxes; ++axis)
+		{
+			pointCoords[axis] = machinePos[axis][point];
+		}
+		if (!CartesianToMotorSteps(pointCoords, stepsPerMm, numVisibleAxes, numTotalAxes, pointMotorPos, isCoordinated))
+		{
+			return false;
+		}
+		for (size_t axis = 0; axis < numVisibleAxes; ++axis)
+		{
+			motorPos[axis][point] = pointMotorPos[axis];
+		}
+	}
+	return true;
+}
+
+// Convert the linearly-transformed axes of a batch of points from the specified one upwards
+/*static*/ void Kinematics::LinearAxesToMotorStepsBatch(const float machinePos[][KinematicsBatchSize], const float stepsPerMm[], size_t firstAxis, size_t numVisibleAxes,
+															size_t numPoints, int32_t motorPos[][KinematicsBatchSize])
+{
+	for (size_t axis = firstAxis; axis < numVisibleAxes; ++axis)
+	{
+		const float axisStepsPerMm = stepsPerMm[axis];
+		for (size_t point = 0; point < numPoints; ++point)
+		{
+			motorPos[axis][point] = lrintf(machinePos[axis][point] * axisStepsPerMm);
+		}
+	}
+}
+
 // Return true if the specified XY position is reachable by the print head reference point.
 // This default implementation assumes a rectangular reachable area, so it just uses the bed dimensions give in the M208 command.
 bool Kinematics::IsReachable(float x, float y, bool isCoordinated) const
@@ -37,9 +37,13 @@ enum class KinematicsType : uint8_t
 enum class MotionType : uint8_t
 {
 	linear,
-	segmentFreeDelta
+	segmentFreeDelta,
+	segmentFreeJoint	// the motor follows a piecewise-linear joint trajectory through several knots in each move
 };
 
+// The maximum number of points that CartesianToMotorStepsBatch converts in one call
+constexpr size_t KinematicsBatchSize = 8;
+
 class Kinematics
 {
 public:
@@ -76,6 +80,14 @@ public:
 	// Return true if successful, false if we were unable to convert
 	virtual bool CartesianToMotorSteps(const float machinePos[], const float stepsPerMm[], size_t numVisibleAxes, size_t numTotalAxes, int32_t motorPos[], bool isCoordinated) const = 0;
 
+	// Convert a batch of Cartesian coordinates to motor positions, for example the knots of a segment-free move
+	// 'machinePos' holds the coordinates of 'numPoints' points (at most KinematicsBatchSize) arranged as one row per axis, so that an implementation
+	// can work through each axis of all the points in one loop. That avoids repeating the per-call overhead and lets the compiler pipeline the
+	// floating point operations. 'motorPos' is the output, arranged in the same way. Only the visible axes are converted.
+	// Return true if all the points could be converted. The default implementation converts the points one at a time.
+	virtual bool CartesianToMotorStepsBatch(const float machinePos[][KinematicsBatchSize], const float stepsPerMm[], size_t numVisibleAxes, size_t numTotalAxes,
+												size_t numPoints, int32_t motorPos[][KinematicsBatchSize], bool isCoordinated) const;
+
 	// Convert motor positions (measured in steps from reference position) to Cartesian coordinates
 	// 'motorPos' is the input vector of motor positions
 	// 'stepsPerMm' is as configured in M92. On a Scara or polar machine this would actually be steps per degree.
@@ -179,6 +191,10 @@ protected:
 	// Return true if any coordinates were changed
 	bool LimitPositionFromAxis(float coords[], size_t firstAxis, size_t numVisibleAxes, AxesBitmap axesHomed) const;
 
+	// Convert the linearly-transformed axes of a batch of points from the specified one upwards
+	static void LinearAxesToMotorStepsBatch(const float machinePos[][KinematicsBatchSize], const float stepsPerMm[], size_t firstAxis, size_t numVisibleAxes,
+												size_t numPoints, int32_t motorPos[][KinematicsBatchSize]);
+
 	// Debugging functions
 	static void PrintMatrix(const char* s, const MathMatrix<floatc_t>& m, size_t numRows = 0, size_t maxCols = 0);
 	static void PrintVector(const char *s, const floatc_t *v, size_t numElems);
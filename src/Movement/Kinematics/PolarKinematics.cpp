@@ -107,6 +107,23 @@ bool PolarKinematics::CartesianToMotorSteps(const float machinePos[], const floa
 	return true;
 }
 
+// Convert a batch of Cartesian coordinates to motor positions
+bool PolarKinematics::CartesianToMotorStepsBatch(const float machinePos[][KinematicsBatchSize], const float stepsPerMm[], size_t numVisibleAxes, size_t numTotalAxes,
+													size_t numPoints, int32_t motorPos[][KinematicsBatchSize], bool isCoordinated) const
+{
+	const float radiusStepsPerMm = stepsPerMm[0], angleStepsPerDegree = stepsPerMm[1];
+	for (size_t point = 0; point < numPoints; ++point)
+	{
+		const float x = machinePos[0][point], y = machinePos[1][point];
+		motorPos[0][point] = lrintf(sqrtf(fsquare(x) + fsquare(y)) * radiusStepsPerMm);
+		motorPos[1][point] = (motorPos[0][point] == 0) ? 0 : lrintf(atan2f(y, x) * RadiansToDegrees * angleStepsPerDegree);	// same expression as CartesianToMotorSteps, so we get the same result
+	}
+
+	// Transform remaining axes linearly
+	LinearAxesToMotorStepsBatch(machinePos, stepsPerMm, Z_AXIS, numVisibleAxes, numPoints, motorPos);
+	return true;
+}
+
 // Convert motor positions (measured in steps from reference position) to Cartesian coordinates
 // 'motorPos' is the input vector of motor positions
 // 'stepsPerMm' is as configured in M92. On a Scara or polar machine this would actually be steps per degree.
@@ -19,6 +19,8 @@ public:
 	const char *GetName(bool forStatusReport) const override;
 	bool Configure(unsigned int mCode, GCodeBuffer& gb, StringRef& reply, bool& error) override;
 	bool CartesianToMotorSteps(const float machinePos[], const float stepsPerMm[], size_t numVisibleAxes, size_t numTotalAxes, int32_t motorPos[], bool isCoordinated) const override;
+	bool CartesianToMotorStepsBatch(const float machinePos[][KinematicsBatchSize], const float stepsPerMm[], size_t numVisibleAxes, size_t numTotalAxes,
+										size_t numPoints, int32_t motorPos[][KinematicsBatchSize], bool isCoordinated) const override;
 	void MotorStepsToCartesian(const int32_t motorPos[], const float stepsPerMm[], size_t numVisibleAxes, size_t numTotalAxes, float machinePos[]) const override;
 	bool IsReachable(float x, float y, bool isCoordinated) const override;
 	bool LimitPosition(float position[], size_t numAxes, AxesBitmap axesHomed, bool isCoordinated) const override;
@@ -30,6 +32,9 @@ public:
 	bool QueryTerminateHomingMove(size_t axis) const override;
 	void OnHomingSwitchTriggered(size_t axis, bool highEnd, const float stepsPerMm[], DDA& dda) const override;
 	void LimitSpeedAndAcceleration(DDA& dda, const float *normalisedDirectionVector) const override;
+#if SUPPORT_SEGMENT_FREE_JOINTS
+	MotionType GetMotionType(size_t axis) const override { return (axis < XYZ_AXES) ? MotionType::segmentFreeJoint : MotionType::linear; }
+#endif
 
 private:
 	static constexpr float DefaultSegmentsPerSecond = 100.0;
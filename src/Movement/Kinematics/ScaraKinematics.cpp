@@ -135,6 +135,33 @@ bool ScaraKinematics::CartesianToMotorSteps(const float machinePos[], const floa
 	return true;
 }
 
+// Convert a batch of Cartesian coordinates to motor coordinates, returning true if all of them are reachable
+// The arm mode may change from one point to the next, so we convert the points in order. We only update the arm mode if all the points are reachable.
+bool ScaraKinematics::CartesianToMotorStepsBatch(const float machinePos[][KinematicsBatchSize], const float stepsPerMm[], size_t numVisibleAxes, size_t numTotalAxes,
+													size_t numPoints, int32_t motorPos[][KinematicsBatchSize], bool isCoordinated) const
+{
+	const float thetaStepsPerDegree = stepsPerMm[X_AXIS], psiStepsPerDegree = stepsPerMm[Y_AXIS], zStepsPerMm = stepsPerMm[Z_AXIS];
+	bool armMode = currentArmMode;
+	for (size_t point = 0; point < numPoints; ++point)
+	{
+		const float pointCoords[2] = { machinePos[X_AXIS][point], machinePos[Y_AXIS][point] };
+		float theta, psi;
+		if (!CalculateThetaAndPsi(pointCoords, isCoordinated, theta, psi, armMode))
+		{
+			return false;
+		}
+		// Use the same expressions as CartesianToMotorSteps so that we get exactly the same results
+		motorPos[X_AXIS][point] = lrintf(theta * RadiansToDegrees * thetaStepsPerDegree);
+		motorPos[Y_AXIS][point] = lrintf((psi - (crosstalk[0] * theta)) * RadiansToDegrees * psiStepsPerDegree);
+		motorPos[Z_AXIS][point] = lrintf((machinePos[Z_AXIS][point] - (crosstalk[1] * theta) - (crosstalk[2] * psi)) * zStepsPerMm);
+	}
+	currentArmMode = armMode;
+
+	// Transform any additional axes linearly
+	LinearAxesToMotorStepsBatch(machinePos, stepsPerMm, XYZ_AXES, numVisibleAxes, numPoints, motorPos);
+	return true;
+}
+
 // Convert motor coordinates to machine coordinates. Used after homing and after individual motor moves.
 // For Scara, the X and Y components of stepsPerMm are actually steps per degree angle.
 void ScaraKinematics::MotorStepsToCartesian(const int32_t motorPos[], const float stepsPerMm[], size_t numVisibleAxes, size_t numTotalAxes, float machinePos[]) const
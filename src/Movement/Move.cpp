@@ -71,6 +71,15 @@ void Move::Init()
 	usingMesh = false;
 	useTaper = false;
 
+	shapingPeriod = 0.0;
+	shapingExtraTime = 0.0;
+	shapedMoves = 0;
+	worstPauseLatency = totalPauseLatency = numPauses = 0;
+	timingPause = false;
+#if SUPPORT_SCURVE
+	maxJerk = 0.0;
+#endif
+
 	longWait = millis();
 	idleTimeout = DefaultIdleTimeout;
 	moveState = MoveState::idle;
@@ -118,6 +127,19 @@ void Move::Spin()
 		++idleCount;
 	}
 
+	// If we have been asked to pause, record how long it took to come to rest
+	if (timingPause && NoLiveMovement())
+	{
+		timingPause = false;
+		const uint32_t latency = millis() - pauseRequestedTime;
+		if (latency > worstPauseLatency)
+		{
+			worstPauseLatency = latency;
+		}
+		totalPauseLatency += latency;
+		++numPauses;
+	}
+
 	// Recycle the DDAs for completed moves, checking for DDA errors to print if Move debug is enabled
 	while (ddaRingCheckPointer->GetState() == DDA::completed)
 	{
@@ -338,6 +360,22 @@ void Move::Spin()
 	reprap.GetPlatform().ClassReport(longWait);
 }
 
+// Record a Z probe reading taken while probing the bed on the fly. This is called by the tick ISR.
+// The filtered reading lags the probe, so we use the position of the head at the time the reading corresponds to.
+void Move::RecordSweepSample(uint16_t reading)
+{
+	const DDA * const cdda = currentDda;						// capture volatile variable
+	if (cdda != nullptr)
+	{
+		const uint32_t lagClocks = (reprap.GetPlatform().GetZProbeLagMicros() * (DDA::stepClockRate/1000))/1000;
+		float coords[XYZ_AXES];
+		if (cdda->GetSteadyPhasePosition(Platform::GetInterruptClocks() - lagClocks, coords))
+		{
+			sweepProbe.AddSample(coords, reading);
+		}
+	}
+}
+
 // Try to push some babystepping through the lookahead queue
 float Move::PushBabyStepping(float amount)
 {
@@ -380,7 +418,7 @@ bool Move::IsAccessibleProbePoint(float x, float y) const
 bool Move::PausePrint(RestorePoint& rp)
 {
 	// Find a move we can pause after.
-	// Ideally, we would adjust a move if necessary and possible so that we can pause after it, but for now we don't do that.
+	// If we can, we make the currently-executing move stop early, see below. Otherwise we look for a move boundary that we can pause at.
 	// There are a few possibilities:
 	// 1. There is no currently executing move and no moves in the queue, and GCodes does not have a move for us.
 	//    Pause immediately. Resume from the current file position.
@@ -404,8 +442,16 @@ bool Move::PausePrint(RestorePoint& rp)
 	// In general, we can pause after a move if it is the last segment and its end speed is slow enough.
 	// We can pause before a move if it is the first segment in that move.
 
+	//
+	// If the currently-executing move is part of a file print and we would otherwise have to complete it and perhaps more moves before pausing,
+	// we bring it to a stop part way through using the normal deceleration and resume from that point, in the same way as for a low power pause.
+
 	const DDA * const savedDdaRingAddPointer = ddaRingAddPointer;
 	bool pauseOkHere;
+	float proportionDoneAtStop;
+
+	pauseRequestedTime = millis();
+	timingPause = true;
 
 	cpu_irq_disable();
 	DDA *dda = currentDda;
@@ -414,6 +460,15 @@ bool Move::PausePrint(RestorePoint& rp)
 		pauseOkHere = true;								// no move was executing, so we have already paused here whether it was a good idea or not.
 		dda = ddaRingGetPointer;
 	}
+	else if (dda->DecelerateToStop(proportionDoneAtStop))
+	{
+		// The current move will stop part way through, so we will skip all the moves after it.
+		// Detach them before we enable interrupts, so that the step ISR can't start one of them when the current move finishes.
+		ddaRingAddPointer = dda->GetNext();
+		DetachMoves(ddaRingAddPointer, savedDdaRingAddPointer);
+		cpu_irq_enable();
+		return PauseAfterStoppedMove(dda, savedDdaRingAddPointer, proportionDoneAtStop, rp);
+	}
 	else
 	{
 		pauseOkHere = dda->CanPauseAfter();
@@ -426,6 +481,7 @@ bool Move::PausePrint(RestorePoint& rp)
 		{
 			// We can pause before executing this move
 			ddaRingAddPointer = dda;
+			DetachMoves(dda, savedDdaRingAddPointer);
 			break;
 		}
 		pauseOkHere = dda->CanPauseAfter();
@@ -472,6 +528,45 @@ bool Move::PausePrint(RestorePoint& rp)
 	return true;
 }
 
+// Mark the moves from firstDda up to but not including endDda as not startable, so that the step ISR stops when it reaches them.
+// This must be called with interrupts disabled, after ddaRingAddPointer has been moved back to firstDda. The caller frees the DDAs later.
+void Move::DetachMoves(DDA *firstDda, const DDA *endDda)
+{
+	for (DDA *dda = firstDda; dda != endDda; dda = dda->GetNext())
+	{
+		dda->Detach();
+	}
+}
+
+// Set up the restore point after we have made the currently-executing move stop part way through, and discard the moves after it.
+// On return the move is still executing, but its end point has been adjusted to where it will stop.
+bool Move::PauseAfterStoppedMove(DDA *stoppedDda, const DDA *savedDdaRingAddPointer, float proportionDone, RestorePoint& rp)
+{
+	rp.feedRate = stoppedDda->GetRequestedSpeed();
+	rp.virtualExtruderPosition = stoppedDda->GetVirtualExtruderPosition();
+	rp.filePos = stoppedDda->GetFilePosition();
+	rp.proportionDone = proportionDone;
+#if SUPPORT_IOBITS
+	rp.ioBits = stoppedDda->GetIoBits();
+#endif
+
+	const size_t numVisibleAxes = reprap.GetGCodes().GetVisibleAxes();
+	for (size_t axis = 0; axis < numVisibleAxes; ++axis)
+	{
+		rp.moveCoords[axis] = stoppedDda->GetEndCoordinate(axis, false);
+	}
+	InverseAxisAndBedTransform(rp.moveCoords, stoppedDda->GetXAxes(), stoppedDda->GetYAxes());
+
+	// Free the DDAs for the moves we are going to skip. The caller has already detached them from the ring.
+	for (DDA *dda = ddaRingAddPointer; dda != savedDdaRingAddPointer; dda = dda->GetNext())
+	{
+		(void)dda->Free();
+		scheduledMoves--;
+	}
+
+	return true;
+}
+
 #if HAS_VOLTAGE_MONITOR
 
 // Pause the print immediately, returning true if we were able to skip or abort any moves and setting up to the move we aborted
@@ -568,6 +663,15 @@ void Move::Diagnostics(MessageType mtype)
 	DriveMovement::ResetMinFree();
 
 	reprap.GetPlatform().MessageF(mtype, "Scheduled moves: %" PRIu32 ", completed moves: %" PRIu32 "\n", scheduledMoves, completedMoves);
+	if (numPauses != 0)
+	{
+		p.MessageF(mtype, "Pause latency: worst %" PRIu32 "ms, mean %" PRIu32 "ms over %" PRIu32 " pauses\n", worstPauseLatency, totalPauseLatency/numPauses, numPauses);
+		worstPauseLatency = totalPauseLatency = numPauses = 0;
+	}
+
+	String<100> shapingReport;
+	ReportShaping(shapingReport.GetRef());
+	p.MessageF(mtype, "%s\n", shapingReport.Pointer());
 
 #if defined(__ALLIGATOR__)
 	// Motor Fault Diagnostic
@@ -622,6 +726,29 @@ void Move::Diagnostics(MessageType mtype)
 #endif
 }
 
+// Report the dynamic acceleration adjustment configuration and how much time it has added to moves
+void Move::ReportShaping(const StringRef& reply) const
+{
+	if (shapingPeriod > 0.0)
+	{
+		reply.printf("Dynamic acceleration adjustment for %.1fHz, %" PRIu32 " moves adjusted adding %.2fsec", (double)(1.0/shapingPeriod), shapedMoves, (double)shapingExtraTime);
+	}
+	else
+	{
+		reply.copy("Dynamic acceleration adjustment disabled");
+	}
+#if SUPPORT_SCURVE
+	if (maxJerk > 0.0)
+	{
+		reply.catf(", S-curve acceleration with maximum jerk %.0fmm/sec^3", (double)maxJerk);
+	}
+	else
+	{
+		reply.cat(", constant acceleration");
+	}
+#endif
+}
+
 // Set the current position to be this
 void Move::SetNewPosition(const float positionNow[DRIVES], bool doBedCompensation)
 {
@@ -690,6 +817,13 @@ bool Move::CartesianToMotorSteps(const float machinePos[MaxAxes], int32_t motorP
 	return b;
 }
 
+// Convert a batch of Cartesian coordinates to motor steps, axes only, returning true if all of them could be converted
+bool Move::CartesianToMotorStepsBatch(const float machinePos[MaxAxes][KinematicsBatchSize], size_t numPoints, int32_t motorPos[MaxAxes][KinematicsBatchSize], bool isCoordinated) const
+{
+	return kinematics->CartesianToMotorStepsBatch(machinePos, reprap.GetPlatform().GetDriveStepsPerUnit(),
+													reprap.GetGCodes().GetVisibleAxes(), reprap.GetGCodes().GetTotalAxes(), numPoints, motorPos, isCoordinated);
+}
+
 void Move::AxisAndBedTransform(float xyzPoint[MaxAxes], AxesBitmap xAxes, AxesBitmap yAxes, bool useBedCompensation) const
 {
 	AxisTransform(xyzPoint, xAxes, yAxes);
@@ -970,6 +1104,7 @@ void Move::CurrentMoveCompleted()
 		extrusionAccumulators[drive - numAxes] += currentDda->GetStepsTaken(drive);
 	}
 	currentDda = nullptr;
+	reprap.GetPlatform().DisableEndstopInterrupts();
 
 	ddaRingGetPointer = ddaRingGetPointer->GetNext();
 	completedMoves++;
@@ -13,6 +13,7 @@
 #include "DDA.h"								// needed because of our inline functions
 #include "BedProbing/RandomProbePointSet.h"
 #include "BedProbing/Grid.h"
+#include "BedProbing/SweepProbe.h"
 #include "Kinematics/Kinematics.h"
 #include "GCodes/RestorePoint.h"
 
@@ -30,6 +31,9 @@ const unsigned int DdaRingLength = 20;
 const unsigned int NumDms = DdaRingLength * 5;						// suitable for e.g. a delta + 2-input hot end
 #endif
 
+const float MinimumShapingFrequency = 4.0;							// Lowest ringing frequency that M594 accepts, in Hz
+const float MaximumShapingFrequency = 300.0;						// Highest ringing frequency that M594 accepts, in Hz
+
 /**
  * This is the master movement class.  It controls all movement in the machine.
  */
@@ -75,6 +79,7 @@ public:
 	Kinematics& GetKinematics() const { return *kinematics; }
 	bool SetKinematics(KinematicsType k);											// Set kinematics, return true if successful
 	bool CartesianToMotorSteps(const float machinePos[MaxAxes], int32_t motorPos[MaxAxes], bool isCoordinated) const;
+	bool CartesianToMotorStepsBatch(const float machinePos[MaxAxes][KinematicsBatchSize], size_t numPoints, int32_t motorPos[MaxAxes][KinematicsBatchSize], bool isCoordinated) const;
 																					// Convert Cartesian coordinates to delta motor coordinates, return true if successful
 	void MotorStepsToCartesian(const int32_t motorPos[], size_t numVisibleAxes, size_t numTotalAxes, float machinePos[]) const;
 																					// Convert motor coordinates to machine coordinates
@@ -94,6 +99,15 @@ public:
 	float IdleTimeout() const;														// Returns the idle timeout in seconds
 	void SetIdleTimeout(float timeout);												// Set the idle timeout in seconds
 
+	void SetShapingFrequency(float f) { shapingPeriod = (f > 0.0) ? 1.0/f : 0.0; }	// Set the ringing frequency to cancel, or 0 to disable
+	float GetShapingPeriod() const { return shapingPeriod; }						// Get the ringing period in seconds, or 0 if not shaping
+	void RecordShapedMove(float extraTime) { ++shapedMoves; shapingExtraTime += extraTime; }	// Called by DDA::Prepare when it adjusts a move
+#if SUPPORT_SCURVE
+	void SetMaxJerk(float j) { maxJerk = max<float>(j, 0.0); }						// Set the jerk limit for S-curve acceleration, or 0 to disable it
+	float GetMaxJerk() const { return maxJerk; }									// Get the jerk limit in mm/sec^3, or 0 if we are not using S-curves
+#endif
+	void ReportShaping(const StringRef& reply) const;										// Report the shaping configuration and what it has cost
+
 	void Simulate(uint8_t simMode);													// Enter or leave simulation mode
 	float GetSimulationTime() const { return simulationTime; }						// Get the accumulated simulation time
 	void PrintCurrentDda() const;													// For debugging
@@ -112,6 +126,8 @@ public:
 	void ResetMoveCounters() { scheduledMoves = completedMoves = 0; }
 
 	HeightMap& AccessHeightMap() { return heightMap; }								// Access the bed probing grid
+	SweepProbe& AccessSweepProbe() { return sweepProbe; }							// Access the data used when probing the grid on the fly
+	void RecordSweepSample(uint16_t reading);										// Record a Z probe reading when probing on the fly, called by the tick ISR
 
 	const DDA *GetCurrentDDA() const { return currentDda; }							// Return the DDA of the currently-executing move
 
@@ -144,6 +160,8 @@ private:
 	void InverseAxisTransform(float move[MaxAxes], AxesBitmap xAxes, AxesBitmap yAxes) const;	// Go from an axis transformed point back to user coordinates
 	void SetPositions(const float move[DRIVES]);												// Force the machine coordinates to be these
 
+	void DetachMoves(DDA *firstDda, const DDA *endDda);									// Stop the step ISR starting the moves we are about to skip
+	bool PauseAfterStoppedMove(DDA *stoppedDda, const DDA *savedDdaRingAddPointer, float proportionDone, RestorePoint& rp);	// Finish pausing after stopping part way through a move
 	bool DDARingAdd();									// Add a processed look-ahead entry to the DDA ring
 	DDA* DDARingGet();									// Get the next DDA ring entry to be run
 	bool DDARingEmpty() const;							// Anything there?
@@ -178,6 +196,7 @@ private:
 	bool useTaper;										// True to taper off the compensation
 
 	HeightMap heightMap;    							// The grid definition in use and height map for G29 bed probing
+	SweepProbe sweepProbe;								// Calibration and samples for G29 probing on the fly
 	RandomProbePointSet probePoints;					// G30 bed probe points
 	bool usingMesh;										// true if we are using the height map, false if we are using the random probe point set
 	float taperHeight;									// Height over which we taper
@@ -192,6 +211,19 @@ private:
 	uint32_t scheduledMoves;							// Move counters for the code queue
 	volatile uint32_t completedMoves;					// This one is modified by an ISR, hence volatile
 
+	float shapingPeriod;								// The ringing period that we adjust accelerations to cancel, or zero if disabled
+	float shapingExtraTime;								// The total time that shaping has added to moves, in seconds
+	uint32_t shapedMoves;								// The number of moves whose acceleration we have adjusted
+#if SUPPORT_SCURVE
+	float maxJerk;										// The jerk limit for S-curve acceleration in mm/sec^3, or zero to use constant acceleration
+#endif
+
+	uint32_t pauseRequestedTime;						// The time at which we were last asked to pause, in milliseconds
+	uint32_t worstPauseLatency;							// The longest time we have taken to come to rest after being asked to pause, in milliseconds
+	uint32_t totalPauseLatency;							// The sum of the pause latencies, so that we can report the mean
+	uint32_t numPauses;									// The number of pauses we have timed
+	bool timingPause;									// True if we are waiting for the machine to come to rest after being asked to pause
+
 	float specialMoveCoords[DRIVES];					// Amounts by which to move individual motors (leadscrew adjustment move)
 	bool specialMoveAvailable;							// True if a leadscrew adjustment move is pending
 };
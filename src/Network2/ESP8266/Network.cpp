@@ -104,7 +104,7 @@ static inline void DisableEspInterrupt()
 
 Network::Network(Platform& p) : platform(p), nextResponderToPoll(nullptr), uploader(nullptr), currentSocket(0), ftpDataPort(0),
 		state(NetworkState::disabled), requestedMode(WiFiState::disabled), currentMode(WiFiState::disabled), activated(false),
-		espStatusChanged(false), spiTxUnderruns(0), spiRxOverruns(0), serialRunning(false)
+		espStatusChanged(false), spiTxUnderruns(0), spiRxOverruns(0), transferCount(0), statusPollCount(0), payloadBytesOut(0), payloadBytesIn(0), serialRunning(false)
 {
 	for (size_t i = 0; i < NumProtocols; ++i)
 	{
@@ -377,6 +377,7 @@ void Network::Start()
 	spiTxUnderruns = spiRxOverruns = 0;
 	reconnectCount = 0;
 	transferAlreadyPendingCount = readyTimeoutCount = responseTimeoutCount = 0;
+	transferCount = statusPollCount = payloadBytesOut = payloadBytesIn = 0;
 
 	lastTickMillis = millis();
 	state = NetworkState::starting1;
@@ -676,6 +677,10 @@ void Network::Diagnostics(MessageType mtype)
 	platform.MessageF(mtype, "Network state is %s\n", TranslateNetworkState());
 	platform.MessageF(mtype, "WiFi module is %s\n", TranslateWiFiState(currentMode));
 	platform.MessageF(mtype, "Failed messages: pending %u, notready %u, noresp %u\n", transferAlreadyPendingCount, readyTimeoutCount, responseTimeoutCount);
+	platform.MessageF(mtype, "SPI transfers %" PRIu32 " (%" PRIu32 " status polls), payload out %" PRIu32 " in %" PRIu32 " bytes, %" PRIu32 " bytes/transfer\n",
+						transferCount, statusPollCount, payloadBytesOut, payloadBytesIn,
+						(transferCount == 0) ? 0 : (payloadBytesOut + payloadBytesIn)/transferCount);
+	transferCount = statusPollCount = payloadBytesOut = payloadBytesIn = 0;
 
 #if 0
 	// The underrun/overrun counters don't work at present
@@ -946,6 +951,15 @@ bool Network::FindResponder(Socket *skt, Port localPort)
 			return true;
 		}
 	}
+
+	// They are all busy, so see if one of them is holding an idle persistent connection that it can give up
+	for (NetworkResponder *r = responders; r != nullptr; r = r->GetNext())
+	{
+		if (r->EvictIdleConnection(protocol) && r->Accept(skt, protocol))
+		{
+			return true;
+		}
+	}
 	return false;
 }
 
@@ -1255,6 +1269,13 @@ int32_t Network::SendCommand(NetworkCommand cmd, SocketNumber socketNum, uint8_t
 	bufferIn.hdr.formatVersion = InvalidFormatVersion;
 	transferPending = true;
 
+	++transferCount;
+	if (cmd == NetworkCommand::connGetStatus)
+	{
+		++statusPollCount;
+	}
+	payloadBytesOut += dataOutLength;
+
 	// DMA may have transferred an extra word to the SPI transmit data register. We need to clear this.
 	// The only way I can find to do this is to issue a software reset to the SPI system.
 	// Fortunately, this leaves the SPI system in slave mode.
@@ -1309,7 +1330,9 @@ int32_t Network::SendCommand(NetworkCommand cmd, SocketNumber socketNum, uint8_t
 		response = bufferIn.hdr.response;
 		if (response > 0 && dataIn != nullptr)
 		{
-			memcpy(dataIn, bufferIn.data, min<size_t>(dataInLength, (size_t)response));
+			const size_t bytesIn = min<size_t>(dataInLength, (size_t)response);
+			memcpy(dataIn, bufferIn.data, bytesIn);
+			payloadBytesIn += bytesIn;
 		}
 	}
 
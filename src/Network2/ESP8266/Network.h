@@ -163,6 +163,11 @@ private:
 	unsigned int readyTimeoutCount;
 	unsigned int responseTimeoutCount;
 
+	// Link efficiency counters, cleared when we report them
+	uint32_t transferCount;							// number of SPI transactions
+	uint32_t statusPollCount;						// how many of those were socket status polls
+	uint32_t payloadBytesOut, payloadBytesIn;		// data carried, not counting the message headers
+
 	char wiFiServerVersion[16];
 
 	// For processing debug messages from the WiFi module
@@ -13,7 +13,7 @@
 const uint32_t FindResponderTimeout = 2000;			// how long we wait for a responder to become available
 const unsigned int MaxBuffersPerSocket = 4;
 
-Socket::Socket() : localPort(0), receivedData(nullptr), state(SocketState::inactive), needsPolling(false)
+Socket::Socket() : localPort(0), receivedData(nullptr), sendData(nullptr), state(SocketState::inactive), needsPolling(false), pushPending(false)
 {
 }
 
@@ -22,6 +22,7 @@ void Socket::Init(SocketNumber n)
 	socketNum = n;
 	state = SocketState::inactive;
 	txBufferSpace = 0;
+	pushPending = false;
 }
 
 // Close a connection when the last packet has been sent
@@ -29,6 +30,13 @@ void Socket::Close()
 {
 	if (state == SocketState::connected || state == SocketState::clientDisconnecting)
 	{
+		// Pass on any data we are still holding first, otherwise the module won't send it.
+		// If the module has less room than it told us then there is nothing more we can do with the remainder.
+		if (sendData != nullptr || pushPending)
+		{
+			(void)FlushSendData(true);
+			DiscardSendData();
+		}
 		const int32_t reply = reprap.GetNetwork().SendCommand(NetworkCommand::connClose, socketNum, 0, nullptr, 0, nullptr, 0);
 		if (reply == ResponseEmpty)
 		{
@@ -54,6 +62,8 @@ void Socket::Terminate()
 		state = (reply != 0) ? SocketState::broken : SocketState::inactive;
 	}
 	DiscardReceivedData();
+	DiscardSendData();
+	pushPending = false;
 	txBufferSpace = 0;
 }
 
@@ -182,6 +192,8 @@ void Socket::Poll(bool full)
 			remotePort = resp.Value().remotePort;
 			remoteIp = resp.Value().remoteIp;
 			DiscardReceivedData();
+			DiscardSendData();
+			pushPending = false;
 			if (state != SocketState::waitingForResponder)
 			{
 				whenConnected = millis();
@@ -207,6 +219,10 @@ void Socket::Poll(bool full)
 		if (state == SocketState::connected)
 		{
 			txBufferSpace = resp.Value().writeBufferSpace;
+			if (sendData != nullptr || pushPending)
+			{
+				(void)FlushSendData(pushPending);		// the module may have room for data that we held back
+			}
 			ReceiveData(resp.Value().bytesAvailable);
 		}
 		break;
@@ -233,50 +249,56 @@ void Socket::Poll(bool full)
 }
 
 // Try to receive more incoming data from the socket.
+// We read as much of the available data as we have buffers for, so that we don't need another status poll before fetching the rest.
 void Socket::ReceiveData(uint16_t bytesAvailable)
 {
-	if (bytesAvailable != 0)
+	while (bytesAvailable != 0)
 	{
 //		debugPrintf("%u available\n", bytesAvailable);
 		// First see if we already have a buffer with enough room
-		NetworkBuffer *const lastBuffer = NetworkBuffer::FindLast(receivedData);
-		if (lastBuffer != nullptr && (bytesAvailable <= lastBuffer->SpaceLeft() || (lastBuffer->SpaceLeft() != 0 && NetworkBuffer::Count(receivedData) >= MaxBuffersPerSocket)))
+		NetworkBuffer *buf = NetworkBuffer::FindLast(receivedData);
+		const unsigned int buffersUsed = NetworkBuffer::Count(receivedData);
+		bool newBuffer = false;
+		if (buf == nullptr || !(bytesAvailable <= buf->SpaceLeft() || (buf->SpaceLeft() != 0 && buffersUsed >= MaxBuffersPerSocket)))
 		{
-			// Read data into the existing buffer
-			const size_t maxToRead = min<size_t>(lastBuffer->SpaceLeft(), MaxDataLength);
-			const int32_t ret = reprap.GetNetwork().SendCommand(NetworkCommand::connRead, socketNum, 0, nullptr, 0, lastBuffer->UnwrittenData(), maxToRead);
-			if (ret > 0 && (size_t)ret <= maxToRead)
+			if (buffersUsed >= MaxBuffersPerSocket)
 			{
-				lastBuffer->dataLength += (size_t)ret;
-				if (reprap.Debug(moduleNetwork))
-				{
-					debugPrintf("Received %u bytes\n", (unsigned int)ret);
-				}
+				break;
+			}
+			buf = NetworkBuffer::Allocate();
+			if (buf == nullptr)
+			{
+//				debugPrintf("no buffer\n");
+				break;
 			}
+			newBuffer = true;
 		}
-		else if (NetworkBuffer::Count(receivedData) < MaxBuffersPerSocket)
+
+		const size_t maxToRead = min<size_t>(buf->SpaceLeft(), MaxDataLength);
+		const int32_t ret = reprap.GetNetwork().SendCommand(NetworkCommand::connRead, socketNum, 0, nullptr, 0, buf->UnwrittenData(), maxToRead);
+		if (ret <= 0 || (size_t)ret > maxToRead)
 		{
-			NetworkBuffer * const buf = NetworkBuffer::Allocate();
-			if (buf != nullptr)
+			if (newBuffer)
 			{
-				const size_t maxToRead = min<size_t>(NetworkBuffer::bufferSize, MaxDataLength);
-				const int32_t ret = reprap.GetNetwork().SendCommand(NetworkCommand::connRead, socketNum, 0, nullptr, 0, buf->Data(), maxToRead);
-				if (ret > 0 && (size_t)ret <= maxToRead)
-				{
-					buf->dataLength = (size_t)ret;
-					NetworkBuffer::AppendToList(&receivedData, buf);
-					if (reprap.Debug(moduleNetwork))
-					{
-						debugPrintf("Received %u bytes\n", (unsigned int)ret);
-					}
-				}
-				else
-				{
-					buf->Release();
-				}
+				buf->Release();
 			}
-//			else debugPrintf("no buffer\n");
+			break;
+		}
+
+		buf->dataLength += (size_t)ret;
+		if (newBuffer)
+		{
+			NetworkBuffer::AppendToList(&receivedData, buf);
 		}
+		if (reprap.Debug(moduleNetwork))
+		{
+			debugPrintf("Received %u bytes\n", (unsigned int)ret);
+		}
+		if ((size_t)ret < maxToRead)
+		{
+			break;								// the module has no more data for us
+		}
+		bytesAvailable -= min<size_t>((size_t)ret, bytesAvailable);
 	}
 }
 
@@ -289,11 +311,19 @@ void Socket::DiscardReceivedData()
 	}
 }
 
-// Send the data, returning the length buffered
+// Send the data, returning the length buffered.
+// Responders often write a few hundred bytes at a time, so we collect small writes and pass them to the module in as few transactions as we can.
 size_t Socket::Send(const uint8_t *data, size_t length)
 {
-	if (state == SocketState::connected && txBufferSpace != 0)
+	if (state != SocketState::connected || txBufferSpace == 0)
+	{
+		return 0;
+	}
+
+	const size_t maxMessageLength = min<size_t>(NetworkBuffer::bufferSize, MaxDataLength);
+	if (sendData == nullptr && (length >= maxMessageLength || (sendData = NetworkBuffer::Allocate()) == nullptr))
 	{
+		// Nothing is being held back and either this is a full message or we have no buffer to collect it in, so send it directly
 		const size_t lengthToSend = min<size_t>(length, min<size_t>(txBufferSpace, MaxDataLength));
 		const int32_t reply = reprap.GetNetwork().SendCommand(NetworkCommand::connWrite, socketNum, 0, data, lengthToSend, nullptr, 0);
 		if (reply >= 0 && (size_t)reply <= lengthToSend)
@@ -306,8 +336,41 @@ size_t Socket::Send(const uint8_t *data, size_t length)
 			debugPrintf("Send failed, terminating\n");
 		}
 		state = SocketState::broken;							// something is not right, terminate the socket soon
+		return 0;
+	}
+
+	size_t accepted = 0;
+	for (;;)
+	{
+		// Collect as much as will fit in one message and in the space the module has
+		const size_t held = sendData->Remaining();
+		const size_t limit = min<size_t>(maxMessageLength, txBufferSpace);
+		if (held < limit)
+		{
+			accepted += sendData->AppendData(data + accepted, min<size_t>(length - accepted, limit - held));
+		}
+		if (accepted == length || sendData->Remaining() == 0)
+		{
+			break;
+		}
+
+		// We have a full message, or as much as the module can take. Pass it on and see if there is room for more.
+		if (!FlushSendData(false) || txBufferSpace == 0)
+		{
+			break;
+		}
+		sendData = NetworkBuffer::Allocate();
+		if (sendData == nullptr)
+		{
+			break;
+		}
 	}
-	return 0;
+
+	if (sendData != nullptr && sendData->Remaining() == 0)
+	{
+		DiscardSendData();
+	}
+	return accepted;
 }
 
 // Tell the interface to send the outstanding data
@@ -315,15 +378,54 @@ void Socket::Send()
 {
 	if (state == SocketState::connected)
 	{
-		const int32_t reply = reprap.GetNetwork().SendCommand(NetworkCommand::connWrite, socketNum, MessageHeaderSamToEsp::FlagPush, nullptr, 0, nullptr, 0);
-		if (reply < 0)
+		(void)FlushSendData(true);
+	}
+}
+
+// Pass the data we have collected to the module, setting the push flag if requested or if a previous push is still outstanding.
+// Return true if the module accepted all of it. If the module takes only some of it, we keep the rest and try again when we next poll the socket.
+bool Socket::FlushSendData(bool push)
+{
+	push = push || pushPending;
+	const size_t length = (sendData == nullptr) ? 0 : sendData->Remaining();
+	if (length == 0 && !push)
+	{
+		DiscardSendData();
+		return true;
+	}
+
+	const int32_t reply = reprap.GetNetwork().SendCommand(NetworkCommand::connWrite, socketNum, (push) ? MessageHeaderSamToEsp::FlagPush : 0,
+															(length == 0) ? nullptr : sendData->UnreadData(), length, nullptr, 0);
+	if (reply < 0 || (size_t)reply > length)
+	{
+		if (reprap.Debug(moduleNetwork))
 		{
-			if (reprap.Debug(moduleNetwork))
-			{
-				debugPrintf("Send failed, terminating\n");
-			}
-			state = SocketState::broken;						// something is not right, terminate the socket soon
+			debugPrintf("Send failed, terminating\n");
 		}
+		state = SocketState::broken;							// something is not right, terminate the socket soon
+		return false;
+	}
+
+	txBufferSpace -= min<size_t>((size_t)reply, txBufferSpace);
+	if ((size_t)reply < length)
+	{
+		sendData->Taken((size_t)reply);
+		pushPending = push;
+		return false;
+	}
+
+	DiscardSendData();
+	pushPending = false;
+	return true;
+}
+
+// Release the buffer holding data we have not passed to the module yet
+void Socket::DiscardSendData()
+{
+	if (sendData != nullptr)
+	{
+		sendData->Release();
+		sendData = nullptr;
 	}
 }
 
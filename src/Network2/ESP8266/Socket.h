@@ -48,16 +48,20 @@ private:
 	void ReInit();
 	void ReceiveData(uint16_t bytesAvailable);
 	void DiscardReceivedData();
+	bool FlushSendData(bool push);
+	void DiscardSendData();
 
 	Port localPort, remotePort;							// The local and remote ports
 	Protocol protocol;									// What protocol this socket is for
 	uint32_t remoteIp;									// The remote IP address
 	NetworkBuffer *receivedData;						// List of buffers holding received data
+	NetworkBuffer *sendData;							// Small writes that we have collected but not yet passed to the WiFi module
 	uint32_t whenConnected;
 	uint16_t txBufferSpace;								// How much free transmit buffer space the WiFi mofule reported
 	SocketNumber socketNum;								// The WiFi socket number we are using
 	SocketState state;
 	bool needsPolling;
+	bool pushPending;									// the responder asked us to push the data but some of it is still in sendData
 };
 
 #endif /* SRC_DUETNG_DUETWIFI_SOCKET_H_ */
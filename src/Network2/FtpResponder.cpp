@@ -10,7 +10,7 @@
 #include "Platform.h"
 
 FtpResponder::FtpResponder(NetworkResponder *n) : NetworkResponder(n), dataSocket(nullptr),
-	passivePort(0),	passivePortOpenTime(0), dataBuf(nullptr)
+	passivePort(0),	passivePortOpenTime(0), dataBuf(nullptr), listIndex(0), listingDirectory(false), restartOffset(0)
 {
 	strcpy(fileToMove, "");
 }
@@ -24,6 +24,7 @@ bool FtpResponder::Accept(Socket *s, Protocol protocol)
 		if (outBuf != nullptr || OutputBuffer::Allocate(outBuf))
 		{
 			clientPointer = 0;
+			restartOffset = 0;
 			skt = s;
 			if (reprap.Debug(moduleWebserver))
 			{
@@ -217,12 +218,25 @@ void FtpResponder::SendData()
 }
 
 // Send our data over the passive FTP data port.
-// We send dataBuf first and then fileBeingSent.
+// We send dataBuf first and then fileBeingSent. If we are listing a directory, we build the listing one buffer at a time as the data port takes it.
 void FtpResponder::SendPassiveData()
 {
 	// Send our output buffers
-	while (dataBuf != nullptr)
+	for (;;)
 	{
+		if (dataBuf == nullptr)
+		{
+			if (!listingDirectory)
+			{
+				break;
+			}
+			if (!OutputBuffer::Allocate(dataBuf))
+			{
+				return;				// no buffer available, try again later
+			}
+			ContinueListing();
+		}
+
 		const size_t bytesLeft = dataBuf->BytesLeft();
 		if (bytesLeft == 0)
 		{
@@ -240,16 +254,7 @@ void FtpResponder::SendPassiveData()
 					{
 						debugPrintf("Can't send anymore over the data port\n");
 					}
-
-					sendError = true;
-					dataSocket = nullptr;
-					if (fileBeingSent != nullptr)
-					{
-						fileBeingSent->Close();
-						fileBeingSent = nullptr;
-					}
-
-					responderState = ResponderState::pasvTransferComplete;
+					DataConnectionLost();
 				}
 				return;
 			}
@@ -266,70 +271,18 @@ void FtpResponder::SendPassiveData()
 
 	// If we get here then there are no output buffers left to send
 	// If we have a file to send, send it
-	if (fileBeingSent != nullptr && fileBuffer == nullptr)
+	if (!SendFileData(dataSocket))
 	{
-		fileBuffer = NetworkBuffer::Allocate();
-		if (fileBuffer == nullptr)
+		if (reprap.Debug(moduleWebserver))
 		{
-			return;					// no buffer available, try again later
+			debugPrintf("Can't send anymore\n");
 		}
+		DataConnectionLost();
+		return;
 	}
-
-	// If we have a file buffer here, we must be in the process of sending a file
-	while (fileBuffer != nullptr)
+	if (fileBeingSent != nullptr || fileBuffer != nullptr)
 	{
-		if (fileBuffer->IsEmpty() && fileBeingSent != nullptr)
-		{
-			const int bytesRead = fileBuffer->ReadFromFile(fileBeingSent);
-			if (bytesRead != (int)NetworkBuffer::bufferSize)
-			{
-				// We had a read error or we reached the end of the file
-				fileBeingSent->Close();
-				fileBeingSent = nullptr;
-			}
-		}
-
-		if (fileBuffer->IsEmpty())
-		{
-			// Must have sent the whole file
-			fileBuffer->Release();
-			fileBuffer = nullptr;
-		}
-		else
-		{
-			const size_t remaining = fileBuffer->Remaining();
-			const size_t sent = dataSocket->Send(fileBuffer->UnreadData(), remaining);
-			if (sent == 0)
-			{
-				// Check whether the connection has been closed
-				if (!dataSocket->CanSend())
-				{
-					if (reprap.Debug(moduleWebserver))
-					{
-						debugPrintf("Can't send anymore\n");
-					}
-
-					sendError = true;
-					dataSocket = nullptr;
-					if (fileBeingSent != nullptr)
-					{
-						fileBeingSent->Close();
-						fileBeingSent = nullptr;
-					}
-					fileBuffer->Release();
-					fileBuffer = nullptr;
-
-					responderState = ResponderState::pasvTransferComplete;
-				}
-				return;
-			}
-
-			fileBuffer->Taken(sent);
-			if (sent < remaining)
-			{
-				return;
-			}
-		}
+		return;						// there is more of the file to send
 	}
 
 	// If we get here then there is nothing left to send. Close it as well
@@ -340,13 +293,57 @@ void FtpResponder::SendPassiveData()
 	responderState = ResponderState::pasvTransferComplete;
 }
 
+// The data connection has gone away while we were sending on it
+void FtpResponder::DataConnectionLost()
+{
+	sendError = true;
+	dataSocket = nullptr;
+	listingDirectory = false;
+	if (fileBeingSent != nullptr)
+	{
+		fileBeingSent->Close();
+		fileBeingSent = nullptr;
+	}
+	ReleaseFileBuffers();
+
+	responderState = ResponderState::pasvTransferComplete;
+}
+
+// Add as many lines of the directory listing to dataBuf as will fit, starting at entry listIndex.
+// We look the entry up by index each time, so it doesn't matter if something else has used the file finder since the last call.
+void FtpResponder::ContinueListing()
+{
+	MassStorage * const massStorage = GetPlatform().GetMassStorage();
+	FileInfo fileInfo;
+	bool found = massStorage->FindAt(currentDirectory, listIndex, fileInfo);
+	while (found)
+	{
+		// Example for a typical UNIX-like file list:
+		// "drwxr-xr-x    2 ftp      ftp             0 Apr 11 2013 bin\r\n"
+		char line[FILENAME_LENGTH + 64];
+		const char dirChar = (fileInfo.isDirectory) ? 'd' : '-';
+		const struct tm * const timeInfo = gmtime(&fileInfo.lastModified);
+		const int len = snprintf(line, ARRAY_SIZE(line), "%crw-rw-rw- 1 ftp ftp %13lu %s %02d %04d %s\r\n",
+								dirChar, fileInfo.size, massStorage->GetMonthName(timeInfo->tm_mon + 1),
+								timeInfo->tm_mday, timeInfo->tm_year + 1900, fileInfo.fileName);
+		if (dataBuf->DataLength() != 0 && (size_t)len > dataBuf->Capacity() - dataBuf->DataLength())
+		{
+			return;					// no room for this line, we will list it again next time
+		}
+		dataBuf->cat(line);
+		++listIndex;
+		found = massStorage->FindNext(fileInfo);
+	}
+	listingDirectory = false;
+}
+
 // Write some more upload data
 void FtpResponder::DoUpload()
 {
-	// Write incoming data to the file
+	// Write incoming data to the file, unless all the file write buffers are waiting to be written to the card
 	const uint8_t *buffer;
 	size_t len;
-	if (dataSocket->ReadBuffer(buffer, len))
+	if (!fileBeingUploaded.IsWriteBacklogged() && dataSocket->ReadBuffer(buffer, len))
 	{
 		if (reprap.Debug(moduleWebserver))
 		{
@@ -495,6 +492,7 @@ void FtpResponder::ProcessLine()
 		{
 			outBuf->copy(	"211-Features:\r\n"
 							"PASV\r\n"			// support PASV mode
+							"REST STREAM\r\n"	// support restarting transfers
 							"211 End\r\n"
 						);
 			Commit(ResponderState::reading);
@@ -647,6 +645,12 @@ void FtpResponder::ProcessLine()
 			}
 			Commit(ResponderState::reading);
 		}
+		// set the offset for the next RETR or STOR
+		else if (StringStartsWith(clientMessage, "REST"))
+		{
+			SetRestartOffset(GetParameter("REST"));
+			Commit(ResponderState::reading);
+		}
 		// no op
 		else if (StringEquals(clientMessage, "NOOP"))
 		{
@@ -675,21 +679,15 @@ void FtpResponder::ProcessLine()
 			outBuf->copy("150 Here comes the directory listing.\r\n");
 			Commit(ResponderState::sendingPasvData);
 
-			// build directory listing, dataBuf is sent later in the Spin loop
-			MassStorage * const massStorage = GetPlatform().GetMassStorage();
-			FileInfo fileInfo;
-			if (massStorage->FindFirst(currentDirectory, fileInfo))
-			{
-				do {
-					// Example for a typical UNIX-like file list:
-					// "drwxr-xr-x    2 ftp      ftp             0 Apr 11 2013 bin\r\n"
-					const char dirChar = (fileInfo.isDirectory) ? 'd' : '-';
-					const struct tm * const timeInfo = gmtime(&fileInfo.lastModified);
-					dataBuf->catf("%crw-rw-rw- 1 ftp ftp %13lu %s %02d %04d %s\r\n",
-							dirChar, fileInfo.size, massStorage->GetMonthName(timeInfo->tm_mon + 1),
-							timeInfo->tm_mday, timeInfo->tm_year + 1900, fileInfo.fileName);
-				} while (massStorage->FindNext(fileInfo));
-			}
+			// the directory listing is built as it is sent in the Spin loop
+			listIndex = 0;
+			listingDirectory = true;
+		}
+		// set the offset for the next RETR or STOR
+		else if (StringStartsWith(clientMessage, "REST"))
+		{
+			SetRestartOffset(GetParameter("REST"));
+			Commit(ResponderState::pasvPortOpened);
 		}
 		// switch transfer mode (sends response, but doesn't have any effects)
 		else if (StringStartsWith(clientMessage, "TYPE"))
@@ -713,8 +711,19 @@ void FtpResponder::ProcessLine()
 		else if (StringStartsWith(clientMessage, "STOR"))
 		{
 			const char *filename = GetParameter("STOR");
-			FileStore *file = GetPlatform().GetFileStore(currentDirectory, filename, OpenMode::write);
-			if (file != nullptr)
+			const FilePosition offset = restartOffset;
+			restartOffset = 0;
+
+			// If we are restarting an upload, we append to the partial file, which must be exactly as long as the offset.
+			// Opening a file to append leaves it positioned at the start, so seek to the end before writing.
+			FileStore *file = GetPlatform().GetFileStore(currentDirectory, filename, (offset == 0) ? OpenMode::write : OpenMode::append);
+			if (file != nullptr && offset != 0 && (file->Length() != offset || !file->Seek(offset)))
+			{
+				file->Close();
+				outBuf->printf("554 Restart offset %lu does not match the file length.\r\n", offset);
+				Commit(ResponderState::reading);
+			}
+			else if (file != nullptr)
 			{
 				StartUpload(file, filename);
 
@@ -731,10 +740,20 @@ void FtpResponder::ProcessLine()
 		else if (StringStartsWith(clientMessage, "RETR"))
 		{
 			const char *filename = GetParameter("RETR");
+			const FilePosition offset = restartOffset;
+			restartOffset = 0;
+
 			fileBeingSent = GetPlatform().GetFileStore(currentDirectory, filename, OpenMode::read);
-			if (fileBeingSent != nullptr)
+			if (fileBeingSent != nullptr && offset != 0 && (offset > fileBeingSent->Length() || !fileBeingSent->Seek(offset)))
+			{
+				fileBeingSent->Close();
+				fileBeingSent = nullptr;
+				outBuf->printf("554 Restart offset %lu is beyond the end of the file.\r\n", offset);
+				Commit(ResponderState::reading);
+			}
+			else if (fileBeingSent != nullptr)
 			{
-				outBuf->printf("150 Opening data connection for %s (%lu bytes).\r\n", filename, fileBeingSent->Length());
+				outBuf->printf("150 Opening data connection for %s (%lu bytes).\r\n", filename, fileBeingSent->Length() - offset);
 				Commit(ResponderState::sendingPasvData);
 			}
 			else
@@ -746,6 +765,7 @@ void FtpResponder::ProcessLine()
 		// abort current operation
 		else if (StringEquals(clientMessage, "ABOR"))
 		{
+			restartOffset = 0;
 			CloseDataPort();
 
 			outBuf->copy("226 ABOR successful.\r\n");
@@ -899,12 +919,31 @@ void FtpResponder::CloseDataPort()
 
 	OutputBuffer::ReleaseAll(dataBuf);
 	dataBuf = nullptr;
+	listingDirectory = false;
 
 	if (fileBeingSent != nullptr)
 	{
 		fileBeingSent->Close();
 		fileBeingSent = nullptr;
 	}
+	ReleaseFileBuffers();
+}
+
+// Process a REST command, which sets the offset at which the next RETR or STOR starts
+void FtpResponder::SetRestartOffset(const char *param)
+{
+	char *endPtr;
+	const unsigned long offset = strtoul(param, &endPtr, 10);
+	if (endPtr == param)
+	{
+		restartOffset = 0;
+		outBuf->copy("501 Invalid restart offset.\r\n");
+	}
+	else
+	{
+		restartOffset = offset;
+		outBuf->printf("350 Restarting at %lu. Send STORE or RETRIEVE.\r\n", offset);
+	}
 }
 
 // End
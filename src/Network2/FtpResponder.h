@@ -34,6 +34,14 @@ protected:
 
 	bool sendError;
 	void SendPassiveData();
+	void DataConnectionLost();
+
+	unsigned int listIndex;								// index of the next directory entry to list
+	bool listingDirectory;								// true if we have more of the directory listing to send
+	void ContinueListing();
+
+	FilePosition restartOffset;							// where the next RETR or STOR starts, set by the REST command
+	void SetRestartOffset(const char *param);
 
 	void DoUpload();
 
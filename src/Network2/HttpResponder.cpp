@@ -17,6 +17,7 @@ const char* overflowResponse = "overflow";
 const char* badEscapeResponse = "bad escape";
 
 const uint32_t HttpReceiveTimeout = 2000;
+const uint32_t HttpKeepAliveTimeout = 5000;			// how long we keep an idle persistent connection open
 
 HttpResponder::HttpResponder(NetworkResponder *n) : NetworkResponder(n)
 {
@@ -33,14 +34,8 @@ bool HttpResponder::Accept(Socket *s, Protocol protocol)
 			responderState = ResponderState::reading;
 			skt = s;
 			timer = millis();
-
-			// Reset the parse state variables
-			clientPointer = 0;
-			parseState = HttpParseState::doingCommandWord;
-			numCommandWords = 0;
-			numQualKeys = 0;
-			numHeaderKeys = 0;
-			commandWords[0] = clientMessage;
+			keepAlive = false;
+			ResetParser();
 
 			if (reprap.Debug(moduleWebserver))
 			{
@@ -85,9 +80,18 @@ bool HttpResponder::Spin()
 				return true;
 			}
 
-			if (!skt->CanRead() || millis() - timer >= HttpReceiveTimeout)
+			// If we are between requests on a persistent connection then the client may close it or leave it idle, so close it politely
+			const bool idle = keepAlive && clientPointer == 0;
+			if (!skt->CanRead() || millis() - timer >= ((idle) ? HttpKeepAliveTimeout : HttpReceiveTimeout))
 			{
-				ConnectionLost();
+				if (idle)
+				{
+					CloseConnection();
+				}
+				else
+				{
+					ConnectionLost();
+				}
 				return true;
 			}
 
@@ -109,6 +113,23 @@ bool HttpResponder::Spin()
 		}
 		return true;
 
+	case ResponderState::waitingForStatusChange:
+		if (!skt->CanSend())
+		{
+			ConnectionLost();
+			return true;
+		}
+		if (!StatusChanged() && millis() - timer < statusWaitTime)
+		{
+			return false;
+		}
+		SendJsonResponse("status");						// this changes the state unless we couldn't get a buffer
+		if (responderState != ResponderState::waitingForStatusChange)
+		{
+			--numStatusWaiters;
+		}
+		return true;
+
 	case ResponderState::uploading:
 		DoUpload();
 		return true;
@@ -122,6 +143,17 @@ bool HttpResponder::Spin()
 	}
 }
 
+// Get ready to parse a new request
+void HttpResponder::ResetParser()
+{
+	clientPointer = 0;
+	parseState = HttpParseState::doingCommandWord;
+	numCommandWords = 0;
+	numQualKeys = 0;
+	numHeaderKeys = 0;
+	commandWords[0] = clientMessage;
+}
+
 // Process a character from the client
 // Rewritten as a state machine by dc42 to increase capability and speed, and reduce RAM requirement.
 // On entry:
@@ -435,7 +467,7 @@ bool HttpResponder::CharFromClient(char c)
 // Return true if we generated a json response to send, false if we didn't and changed the state instead
 bool HttpResponder::GetJsonResponse(const char* request, OutputBuffer *&response, bool& keepOpen)
 {
-	keepOpen = false;	// assume we don't want to persist the connection
+	keepOpen = true;	// all our JSON responses have a Content-Length, so the connection may persist unless the command says otherwise
 	if (StringEquals(request, "connect") && GetKeyValue("password") != nullptr)
 	{
 		if (!CheckAuthenticated())
@@ -480,10 +512,16 @@ bool HttpResponder::GetJsonResponse(const char* request, OutputBuffer *&response
 	else if (StringEquals(request, "disconnect"))
 	{
 		response->printf("{\"err\":%d}", (RemoveAuthentication()) ? 0 : 1);
+		keepOpen = false;
 		reprap.GetPlatform().MessageF(LogMessage, "HTTP client %s disconnected\n", IP4String(GetRemoteIP()).c_str());
 	}
 	else if (StringEquals(request, "status"))
 	{
+		if (responderState != ResponderState::waitingForStatusChange && StartWaitingForStatusChange())
+		{
+			return false;
+		}
+
 		int type = 0;
 		if (GetKeyValue("type") != nullptr)
 		{
@@ -521,8 +559,15 @@ bool HttpResponder::GetJsonResponse(const char* request, OutputBuffer *&response
 	}
 	else if (StringEquals(request, "filelist") && GetKeyValue("dir") != nullptr)
 	{
+		unsigned int startAt, maxItems;
+		GetListingRange(startAt, maxItems);
 		OutputBuffer::Release(response);
-		response = reprap.GetFilelistResponse(GetKeyValue("dir"));
+		response = reprap.GetFilelistResponse(GetKeyValue("dir"), startAt, maxItems);
+		if (response == nullptr)
+		{
+			RejectMessage("Service Unavailable", 503);			// not enough output buffers for even one entry, so the client should try again
+			return false;
+		}
 	}
 	else if (StringEquals(request, "files"))
 	{
@@ -533,8 +578,15 @@ bool HttpResponder::GetJsonResponse(const char* request, OutputBuffer *&response
 		}
 		const char* const flagDirsVal = GetKeyValue("flagDirs");
 		const bool flagDirs = flagDirsVal != nullptr && atoi(flagDirsVal) == 1;
+		unsigned int startAt, maxItems;
+		GetListingRange(startAt, maxItems);
 		OutputBuffer::Release(response);
-		response = reprap.GetFilesResponse(dir, flagDirs);
+		response = reprap.GetFilesResponse(dir, startAt, maxItems, flagDirs);
+		if (response == nullptr)
+		{
+			RejectMessage("Service Unavailable", 503);			// not enough output buffers for even one entry, so the client should try again
+			return false;
+		}
 	}
 	else if (StringEquals(request, "fileinfo"))
 	{
@@ -603,6 +655,19 @@ const char* HttpResponder::GetKeyValue(const char *key) const
 	return nullptr;
 }
 
+// Get the range of directory entries that the client wants in a file listing.
+// Clients that pass 'first' get the listing in pages of 'max' entries, or DefaultFileListPageSize if 'max' is missing.
+// Older clients that pass neither get as much of the listing as fits in the output buffers.
+void HttpResponder::GetListingRange(unsigned int& startAt, unsigned int& maxItems) const
+{
+	const char* const firstVal = GetKeyValue("first");
+	const char* const maxVal = GetKeyValue("max");
+	startAt = (firstVal == nullptr) ? 0 : strtoul(firstVal, nullptr, 10);
+	maxItems = (maxVal != nullptr) ? strtoul(maxVal, nullptr, 10)
+				: (firstVal != nullptr) ? DefaultFileListPageSize
+					: 0;
+}
+
 // Called to process a FileInfo request, which may take several calls
 // When we have finished, set the state back to free.
 bool HttpResponder::SendFileInfo()
@@ -620,13 +685,50 @@ bool HttpResponder::SendFileInfo()
 						"Content-Type: application/json\n"
 					);
 		outBuf->catf("Content-Length: %u\n", (jsonResponse != nullptr) ? jsonResponse->Length() : 0);
-		outBuf->cat("Connection: close\n\n");
+		FinishHeaders();
 		outBuf->Append(jsonResponse);
-		Commit();
+		Commit((keepAlive) ? ResponderState::reading : ResponderState::free);
 	}
 	return gotFileInfo;
 }
 
+// If the client asked us to hold an rr_status request until something changes and nothing has changed yet, start waiting and return true.
+// The client passes the maximum time to wait in milliseconds as 'wait' and optionally the last G-code reply sequence number it saw as 'seq'.
+// We send the status when the reply sequence number, the machine status or the notifications change, or when the wait time expires,
+// so that the client gets a heartbeat even when the machine is idle.
+bool HttpResponder::StartWaitingForStatusChange()
+{
+	const char* const waitVal = GetKeyValue("wait");
+	if (waitVal == nullptr || numStatusWaiters >= MaxStatusWaiters)
+	{
+		return false;
+	}
+
+	statusWaitTime = min<uint32_t>(strtoul(waitVal, nullptr, 10), MaxStatusWaitTime);
+	const char* const seqVal = GetKeyValue("seq");
+	statusWaitReplySeq = (seqVal != nullptr) ? strtoul(seqVal, nullptr, 10) : seq;
+	statusWaitEventSeq = reprap.GetEventSeq();
+	statusWaitStatusChar = reprap.GetStatusCharacter();
+	if (statusWaitTime == 0 || StatusChanged())
+	{
+		return false;
+	}
+
+	timer = millis();
+	responderState = ResponderState::waitingForStatusChange;
+	++numStatusWaiters;
+	return true;
+}
+
+// Return true if something has changed that a client waiting for a status change should be told about
+bool HttpResponder::StatusChanged() const
+{
+	return seq != statusWaitReplySeq
+		|| reprap.GetEventSeq() != statusWaitEventSeq
+		|| reprap.HavePendingMessage()
+		|| reprap.GetStatusCharacter() != statusWaitStatusChar;
+}
+
 // Authenticate current IP and return true on success
 bool HttpResponder::Authenticate()
 {
@@ -794,14 +896,14 @@ void HttpResponder::SendFile(const char* nameOfFileToSend, bool isWebFile)
 	}
 	outBuf->catf("Content-Type: %s\n", contentType);
 
-	if (zip && fileToSend != nullptr)
+	if (zip)
 	{
 		outBuf->cat("Content-Encoding: gzip\n");
-		outBuf->catf("Content-Length: %lu\n", fileToSend->Length());
 	}
+	outBuf->catf("Content-Length: %lu\n", fileToSend->Length());
 
-	outBuf->cat("Connection: close\n\n");
-	Commit();
+	FinishHeaders();
+	Commit((keepAlive) ? ResponderState::reading : ResponderState::free);
 }
 
 void HttpResponder::SendGCodeReply()
@@ -838,9 +940,9 @@ void HttpResponder::SendGCodeReply()
 					"Content-Type: text/plain\n"
 				);
 	outBuf->catf("Content-Length: %u\n", gcodeReply->DataLength());
-	outBuf->cat("Connection: close\n\n");
+	FinishHeaders();
 	outStack->Append(gcodeReply);
-	Commit();
+	Commit((keepAlive) ? ResponderState::reading : ResponderState::free);
 
 	// Possibly clean up the G-code reply once again
 	if (clearReply)
@@ -900,26 +1002,15 @@ void HttpResponder::SendJsonResponse(const char* command)
 	if (!gotResponse)
 	{
 		// Either this request was rejected, or it will take longer to process e.g. rr_fileinfo
-		OutputBuffer::Release(jsonResponse);
-		return;
-	}
-
-	// Send the JSON response
-	bool keepOpen = false;
-	if (mayKeepOpen)
-	{
-		// Check that the browser wants to persist the connection too
-		for (size_t i = 0; i < numHeaderKeys; ++i)
+		if (jsonResponse != nullptr)
 		{
-			if (StringEquals(headers[i].key, "Connection"))
-			{
-				// Comment out the following line to disable persistent connections
-				keepOpen = StringEquals(headers[i].value, "keep-alive");
-				break;
-			}
+			OutputBuffer::Release(jsonResponse);
 		}
+		return;
 	}
 
+	// Send the JSON response
+	keepAlive = keepAlive && mayKeepOpen;
 	outBuf->copy(	"HTTP/1.1 200 OK\n"
 					"Cache-Control: no-cache, no-store, must-revalidate\n"
 					"Pragma: no-cache\n"
@@ -928,10 +1019,58 @@ void HttpResponder::SendJsonResponse(const char* command)
 					"Content-Type: application/json\n"
 				);
 	outBuf->catf("Content-Length: %u\n", (jsonResponse != nullptr) ? jsonResponse->Length() : 0);
-	outBuf->catf("Connection: %s\n\n", keepOpen ? "keep-alive" : "close");
+	FinishHeaders();
 	outBuf->Append(jsonResponse);
 
-	Commit(keepOpen ? ResponderState::reading : ResponderState::free);
+	Commit((keepAlive) ? ResponderState::reading : ResponderState::free);
+}
+
+// Return true if the client is willing to keep the connection open after this request.
+// HTTP/1.1 clients keep it open unless they say otherwise, HTTP/1.0 clients only if they ask to.
+bool HttpResponder::ClientWantsKeepAlive() const
+{
+	for (size_t i = 0; i < numHeaderKeys; ++i)
+	{
+		if (StringEquals(headers[i].key, "Connection"))
+		{
+			return StringEquals(headers[i].value, "keep-alive");
+		}
+	}
+	return numCommandWords >= 3 && StringEquals(commandWords[2], "HTTP/1.1");
+}
+
+// Finish the response headers with the Connection header. Every response we keep the connection open for must have a Content-Length.
+void HttpResponder::FinishHeaders()
+{
+	outBuf->catf("Connection: %s\n\n", (keepAlive) ? "keep-alive" : "close");
+}
+
+// Close the connection politely and free this responder
+void HttpResponder::CloseConnection()
+{
+	skt->Close();
+	skt = nullptr;
+	responderState = ResponderState::free;
+}
+
+// If we are holding a persistent connection open between requests, close it so that we can accept a new connection
+bool HttpResponder::EvictIdleConnection(Protocol protocol)
+{
+	const uint8_t *data;
+	size_t length;
+	if (   (protocol == HttpProtocol || protocol == AnyProtocol)
+		&& responderState == ResponderState::reading && keepAlive && clientPointer == 0
+		&& !skt->ReadBuffer(data, length)								// the client hasn't started sending another request
+	   )
+	{
+		if (reprap.Debug(moduleWebserver))
+		{
+			debugPrintf("Closing idle HTTP connection\n");
+		}
+		CloseConnection();
+		return true;
+	}
+	return false;
 }
 
 // Process the message received so far. We have reached the end of the headers.
@@ -960,6 +1099,8 @@ void HttpResponder::ProcessMessage()
 		return;
 	}
 
+	keepAlive = ClientWantsKeepAlive();
+
 	if (StringEquals(commandWords[0], "GET"))
 	{
 		if (StringStartsWith(commandWords[1], KO_START))
@@ -987,9 +1128,9 @@ void HttpResponder::ProcessMessage()
 						"Access-Control-Allow-Origin: *\n"
 						"Access-Control-Allow-Headers: Content-Type\n"
 						"Content-Length: 0\n"
-						"\n"
 					);
-		Commit();
+		FinishHeaders();
+		Commit((keepAlive) ? ResponderState::reading : ResponderState::free);
 		return;
 	}
 
@@ -1030,6 +1171,22 @@ void HttpResponder::ProcessMessage()
 
 				}
 				StartUpload(file, filename);
+				(void)fileBeingUploaded.PreAllocate(postFileLength);		// so that the file is contiguous and quick to read when we print it
+
+				// If the client sent the CRC32 of the file then we check it when the upload completes, so that we don't accept a corrupted file
+				const char *crcString = GetKeyValue("crc32");
+				for (size_t i = 0; crcString == nullptr && i < numHeaderKeys; i++)
+				{
+					if (StringEquals(headers[i].key, "X-CRC32"))
+					{
+						crcString = headers[i].value;
+					}
+				}
+				if (crcString != nullptr)
+				{
+					expectedCrc = strtoul(crcString, nullptr, 16);
+					checkCrc = true;
+				}
 
 				// Try to get the last modified file date and time
 				const char* const lastModifiedString = GetKeyValue("time");
@@ -1088,6 +1245,7 @@ void HttpResponder::RejectMessage(const char* response, unsigned int code)
 		GetPlatform().MessageF(UsbMessage, "Webserver: rejecting message with: %u %s\n", code, response);
 	}
 	outBuf->printf("HTTP/1.1 %u %s\nConnection: close\n\n", code, response);
+	keepAlive = false;
 	Commit();
 }
 
@@ -1095,10 +1253,12 @@ void HttpResponder::RejectMessage(const char* response, unsigned int code)
 // It tries to process a chunk of uploaded data and changes the state if finished.
 void HttpResponder::DoUpload()
 {
+	// If all the file write buffers are waiting to be written to the card, leave the data in the socket for now so that we don't hold up the main loop
 	const uint8_t *buffer;
 	size_t len;
-	if (skt->ReadBuffer(buffer, len))
+	if (!fileBeingUploaded.IsWriteBacklogged() && skt->ReadBuffer(buffer, len))
 	{
+		len = min<size_t>(len, postFileLength - uploadedBytes);		// a pipelined request may follow the file data
 		skt->Taken(len);
 		uploadedBytes += len;
 
@@ -1107,6 +1267,7 @@ void HttpResponder::DoUpload()
 			uploadError = true;
 			GetPlatform().Message(ErrorMessage, "Could not write upload data!\n");
 			CancelUpload();
+			keepAlive = false;										// we haven't read the rest of the file data
 			SendJsonResponse("upload");
 			return;
 		}
@@ -1150,6 +1311,10 @@ void HttpResponder::Terminate(Protocol protocol)
 // This overrides the version in class NetworkResponder
 void HttpResponder::ConnectionLost()
 {
+	if (responderState == ResponderState::waitingForStatusChange)
+	{
+		--numStatusWaiters;
+	}
 	fileInfoLock.Release(this);
 	NetworkResponder::ConnectionLost();
 }
@@ -1178,6 +1343,13 @@ void HttpResponder::SendData()
 	NetworkResponder::SendData();
 	if (responderState == ResponderState::reading)
 	{
+		// We are keeping the connection open, so get ready for the next request. We need an output buffer to reply to it.
+		if (outBuf == nullptr && !OutputBuffer::Allocate(outBuf))
+		{
+			CloseConnection();
+			return;
+		}
+		ResetParser();
 		timer = millis();				// restart the timer
 	}
 }
@@ -1260,7 +1432,8 @@ void HttpResponder::Diagnostics(MessageType mt) const
 
 /*static*/ void HttpResponder::CommonDiagnostics(MessageType mtype)
 {
-	GetPlatform().MessageF(mtype, "HTTP sessions: %u of %u\n", numSessions, MaxHttpSessions);
+	GetPlatform().MessageF(mtype, "HTTP sessions: %u of %u, %u waiting for status changes\n", numSessions, MaxHttpSessions, numStatusWaiters);
+	UploadDiagnostics(mtype);
 }
 
 // Static data
@@ -1268,6 +1441,7 @@ void HttpResponder::Diagnostics(MessageType mt) const
 HttpResponder::HttpSession HttpResponder::sessions[MaxHttpSessions];
 unsigned int HttpResponder::numSessions = 0;
 unsigned int HttpResponder::clientsServed = 0;
+unsigned int HttpResponder::numStatusWaiters = 0;
 
 uint32_t HttpResponder::seq = 0;
 OutputStack *HttpResponder::gcodeReply = new OutputStack();
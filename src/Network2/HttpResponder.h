@@ -18,6 +18,7 @@ public:
 	bool Accept(Socket *s, Protocol protocol) override;	// ask the responder to accept this connection, returns true if it did
 	void Terminate(Protocol protocol) override;			// terminate the responder if it is serving the specified protocol
 	void Diagnostics(MessageType mtype) const override;
+	bool EvictIdleConnection(Protocol protocol) override;	// give up an idle persistent connection, returning true if we did
 
 	static void HandleGCodeReply(const char *reply);
 	static void HandleGCodeReply(OutputBuffer *reply);
@@ -37,6 +38,8 @@ private:
 	static const size_t MaxQualKeys = 5;				// max number of key/value pairs in the qualifier
 	static const size_t MaxHeaders = 30;				// max number of key/value pairs in the headers
 	static const uint32_t HttpSessionTimeout = 8000;	// HTTP session timeout in milliseconds
+	static const uint32_t MaxStatusWaitTime = 5000;		// the longest we hold an rr_status request, must be well below HttpSessionTimeout
+	static const unsigned int MaxStatusWaiters = 2;		// how many responders may hold rr_status requests, so that the others are free for other requests
 
 	enum class HttpParseState
 	{
@@ -73,7 +76,11 @@ private:
 	bool CheckAuthenticated();
 	bool RemoveAuthentication();
 
+	void ResetParser();
 	bool CharFromClient(char c);
+	bool ClientWantsKeepAlive() const;
+	void FinishHeaders();
+	void CloseConnection();
 	void SendFile(const char* nameOfFileToSend, bool isWebFile);
 	void SendGCodeReply();
 	void SendJsonResponse(const char* command);
@@ -81,12 +88,16 @@ private:
 	void ProcessMessage();
 	void RejectMessage(const char* s, unsigned int code = 500);
 	bool SendFileInfo();
+	bool StartWaitingForStatusChange();
+	bool StatusChanged() const;
 
 	void DoUpload();
 
 	const char* GetKeyValue(const char *key) const;	// return the value of the specified key, or nullptr if not present
+	void GetListingRange(unsigned int& startAt, unsigned int& maxItems) const;	// get the requested range of a file listing
 
 	HttpParseState parseState;
+	bool keepAlive;									// true if we will keep the connection open after sending the response
 
 	// Buffers for processing HTTP input
 	char clientMessage[WebMessageLength + 3];		// holds the command, qualifier, and headers
@@ -104,10 +115,17 @@ private:
 	// rr_fileinfo requests
 	char filenameBeingProcessed[FILENAME_LENGTH];	// The filename being processed (for rr_fileinfo)
 
+	// rr_status requests that wait for something to change
+	uint32_t statusWaitTime;						// how long we may hold the request
+	uint32_t statusWaitReplySeq;					// the G-code reply sequence number the client has already seen
+	uint32_t statusWaitEventSeq;					// the notification sequence number when the request arrived
+	char statusWaitStatusChar;						// the machine status when the request arrived
+
 	// Keeping track of HTTP sessions
 	static HttpSession sessions[MaxHttpSessions];
 	static unsigned int numSessions;
 	static unsigned int clientsServed;
+	static unsigned int numStatusWaiters;			// how many responders are holding rr_status requests
 
 	// Responses from GCodes class
 	static uint32_t seq;							// Sequence number for G-Code replies
@@ -67,6 +67,9 @@ public:
 	// Count how many buffers there are in a chain
 	static unsigned int Count(NetworkBuffer*& ptr);
 
+	// Count how many buffers are free
+	static unsigned int NumFree() { return Count(freelist); }
+
 	static const size_t bufferSize =
 #ifdef USE_3K_BUFFERS
 									 3 * 1024;
@@ -9,6 +9,7 @@
 #include "NetworkResponder.h"
 #include "Platform.h"
 #include "OutputMemory.h"
+#include "GCodes/GCodes.h"
 
 // NetworkResponderLock members
 
@@ -37,6 +38,8 @@ void NetworkResponderLock::Release(const NetworkResponder *who)
 	}
 }
 
+const unsigned int ReadAheadReserveBuffers = 2;	// we only read ahead when sending a file if this many network buffers would still be free
+
 // NetworkResponder members
 
 NetworkResponder::NetworkResponder(NetworkResponder *n)
@@ -105,26 +108,59 @@ void NetworkResponder::SendData()
 
 	// If we get here then there are no output buffers left to send
 	// If we have a file to send, send it
+	if (!SendFileData(skt))
+	{
+		if (reprap.Debug(moduleWebserver))
+		{
+			debugPrintf("Can't send anymore\n");
+		}
+		ConnectionLost();
+		return;
+	}
+	if (fileBeingSent != nullptr || fileBuffer != nullptr)
+	{
+		return;							// there is more of the file to send
+	}
+
+	// If we get here then there is nothing left to send
+	skt->Send();						// tell the socket there is no more data
+
+	// If we are going to free up this responder after sending, then we must close the connection
+	if (stateAfterSending == ResponderState::free)
+	{
+		skt->Close();
+		skt = nullptr;
+	}
+	responderState = stateAfterSending;
+}
+
+// Send as much of fileBeingSent as the socket will take, returning false if the connection has been lost.
+// When the whole file has been sent, fileBeingSent and fileBuffer are both null.
+// If the socket can't take all the data we have, we use the time to read the next chunk of the file so that it is ready when the socket is.
+bool NetworkResponder::SendFileData(Socket *s)
+{
 	if (fileBeingSent != nullptr && fileBuffer == nullptr)
 	{
 		fileBuffer = NetworkBuffer::Allocate();
 		if (fileBuffer == nullptr)
 		{
-			return;					// no buffer available, try again later
+			return true;				// no buffer available, try again later
 		}
 	}
 
 	// If we have a file buffer here, we must be in the process of sending a file
 	while (fileBuffer != nullptr)
 	{
-		if (fileBuffer->IsEmpty() && fileBeingSent != nullptr)
+		if (fileBuffer->IsEmpty())
 		{
-			const int bytesRead = fileBuffer->ReadFromFile(fileBeingSent);
-			if (bytesRead != (int)NetworkBuffer::bufferSize)
+			if (NetworkBuffer::Count(fileBuffer) > 1)
 			{
-				// We had a read error or we reached the end of the file
-				fileBeingSent->Close();
-				fileBeingSent = nullptr;
+				fileBuffer = fileBuffer->Release();		// move on to the data we read ahead
+				continue;
+			}
+			if (fileBeingSent != nullptr)
+			{
+				ReadFileChunk(fileBuffer);
 			}
 		}
 
@@ -137,39 +173,59 @@ void NetworkResponder::SendData()
 		else
 		{
 			const size_t remaining = fileBuffer->Remaining();
-			const size_t sent = skt->Send(fileBuffer->UnreadData(), remaining);
-			if (sent == 0)
+			const size_t sent = s->Send(fileBuffer->UnreadData(), remaining);
+			if (sent == 0 && !s->CanSend())
 			{
-				// Check whether the connection has been closed
-				if (!skt->CanSend())
-				{
-					if (reprap.Debug(moduleWebserver))
-					{
-						debugPrintf("Can't send anymore\n");
-					}
-					ConnectionLost();
-				}
-				return;
+				return false;			// the connection has been lost or the other end has closed it
 			}
 
 			fileBuffer->Taken(sent);
 			if (sent < remaining)
 			{
-				return;
+				ReadAhead();
+				return true;
 			}
 		}
 	}
+	return true;
+}
 
-	// If we get here then there is nothing left to send
-	skt->Send();						// tell the socket there is no more data
+// Read the next chunk of the file being sent into a buffer, closing the file if we reach the end of it or get a read error
+void NetworkResponder::ReadFileChunk(NetworkBuffer *buf)
+{
+	const int bytesRead = buf->ReadFromFile(fileBeingSent);
+	if (bytesRead != (int)NetworkBuffer::bufferSize)
+	{
+		fileBeingSent->Close();
+		fileBeingSent = nullptr;
+	}
+}
 
-	// If we are going to free up this responder after sending, then we must close the connection
-	if (stateAfterSending == ResponderState::free)
+// The socket can't take any more data yet, so read the next chunk of the file if we can spare a buffer for it
+void NetworkResponder::ReadAhead()
+{
+	if (fileBeingSent != nullptr && NetworkBuffer::Count(fileBuffer) == 1 && NetworkBuffer::NumFree() > ReadAheadReserveBuffers)
 	{
-		skt->Close();
-		skt = nullptr;
+		NetworkBuffer * const buf = NetworkBuffer::Allocate();
+		ReadFileChunk(buf);
+		if (buf->IsEmpty())
+		{
+			buf->Release();
+		}
+		else
+		{
+			NetworkBuffer::AppendToList(&fileBuffer, buf);
+		}
+	}
+}
+
+// Release the buffers holding file data that we haven't sent yet
+void NetworkResponder::ReleaseFileBuffers()
+{
+	while (fileBuffer != nullptr)
+	{
+		fileBuffer = fileBuffer->Release();
 	}
-	responderState = stateAfterSending;
 }
 
 // This is called when we lose a connection or when we are asked to terminate. Overridden in some derived classes.
@@ -186,11 +242,7 @@ void NetworkResponder::ConnectionLost()
 		fileBeingSent = nullptr;
 	}
 
-	if (fileBuffer != nullptr)
-	{
-		fileBuffer->Release();
-		fileBuffer = nullptr;
-	}
+	ReleaseFileBuffers();
 
 	if (skt != nullptr)
 	{
@@ -208,6 +260,8 @@ void NetworkResponder::StartUpload(FileStore *file, const char *fileName)
 	SafeStrncpy(filenameBeingUploaded, fileName, ARRAY_SIZE(filenameBeingUploaded));
 	responderState = ResponderState::uploading;
 	uploadError = false;
+	checkCrc = false;
+	uploadStartTime = millis();
 }
 
 // If this responder has an upload in progress, cancel it
@@ -240,10 +294,23 @@ void NetworkResponder::FinishUpload(uint32_t fileLength, time_t fileLastModified
 		GetPlatform().MessageF(ErrorMessage, "Uploaded file size is different (%lu vs. expected %lu bytes)!\n", fileBeingUploaded.Length(), fileLength);
 	}
 
+	// Check the CRC if the client sent one. If it doesn't match then we delete the file below.
+	if (!uploadError && checkCrc && fileBeingUploaded.GetCRC32() != expectedCrc)
+	{
+		uploadError = true;
+		GetPlatform().MessageF(ErrorMessage, "Uploaded file CRC32 is different (%08" PRIx32 " vs. expected %08" PRIx32 ")!\n", fileBeingUploaded.GetCRC32(), expectedCrc);
+	}
+
 	// Close the file
 	if (fileBeingUploaded.IsLive())
 	{
+		const FilePosition uploadLength = fileBeingUploaded.Length();
 		fileBeingUploaded.Close();
+		const uint32_t uploadTime = millis() - uploadStartTime;
+		if (!uploadError && uploadTime != 0)
+		{
+			lastUploadSpeed = (float)uploadLength/((float)uploadTime * 1000.0);
+		}
 	}
 
 	// Delete the file again if an error has occurred
@@ -255,9 +322,19 @@ void NetworkResponder::FinishUpload(uint32_t fileLength, time_t fileLastModified
 		}
 		else if (fileLastModified != 0)
 		{
-			// Update the file timestamp if it was specified
+			// Update the file timestamp if it was specified. This also brings any cached directory listing up to date.
 			(void)GetPlatform().GetMassStorage()->SetLastModifiedTime(nullptr, filenameBeingUploaded, fileLastModified);
 		}
+		else
+		{
+			// Make sure that directory listings show the final size
+			GetPlatform().GetMassStorage()->UpdateCachedFileInfo(FS_PREFIX, filenameBeingUploaded);
+		}
+
+		if (!uploadError)
+		{
+			reprap.GetGCodes().FileUploaded(filenameBeingUploaded);
+		}
 	}
 
 	// Clean up again
@@ -269,4 +346,13 @@ uint32_t NetworkResponder::GetRemoteIP() const
 	return (skt == nullptr) ? 0 : skt->GetRemoteIP();
 }
 
+// Report the upload speed. The longest time the main loop was held up by writing upload data is the SD card longest block write time.
+/*static*/ void NetworkResponder::UploadDiagnostics(MessageType mtype)
+{
+	GetPlatform().MessageF(mtype, "Last upload speed: %.2fMB/sec\n", (double)lastUploadSpeed);
+}
+
+// Static data
+float NetworkResponder::lastUploadSpeed = 0.0;
+
 // End
@@ -41,6 +41,7 @@ public:
 	virtual bool Accept(Socket *s, Protocol protocol) = 0;	// ask the responder to accept this connection, returns true if it did
 	virtual void Terminate(Protocol protocol) = 0;		// terminate the responder if it is serving the specified protocol
 	virtual void Diagnostics(MessageType mtype) const = 0;
+	virtual bool EvictIdleConnection(Protocol protocol) { return false; }	// give up an idle persistent connection for this protocol, returning true if we did
 
 protected:
 	// States machine control. Not all derived classes use all states.
@@ -54,6 +55,7 @@ protected:
 		// HTTP responder additional states
 		gettingFileInfoLock,							// waiting to get the file info lock
 		gettingFileInfo,								// getting file info
+		waitingForStatusChange,							// holding an rr_status request until something changes
 
 		// FTP responder additional states
 		waitingForPasvPort,
@@ -70,6 +72,10 @@ protected:
 
 	void Commit(ResponderState nextState = ResponderState::free);
 	virtual void SendData();
+	bool SendFileData(Socket *s);						// send more of fileBeingSent, returning false if the connection has been lost
+	void ReadFileChunk(NetworkBuffer *buf);
+	void ReadAhead();
+	void ReleaseFileBuffers();
 	virtual void ConnectionLost();
 
 	void StartUpload(FileStore *file, const char *fileName);
@@ -78,6 +84,8 @@ protected:
 
 	uint32_t GetRemoteIP() const;
 
+	static void UploadDiagnostics(MessageType mtype);
+
 	static Platform& GetPlatform() { return reprap.GetPlatform(); }
 	static Network& GetNetwork() { return reprap.GetNetwork(); }
 
@@ -99,7 +107,12 @@ protected:
 	char filenameBeingUploaded[FILENAME_LENGTH];
 	uint32_t postFileLength, uploadedBytes;				// How many POST bytes do we expect and how many have already been written?
 	time_t fileLastModified;
+	uint32_t uploadStartTime;							// when the upload started, so that we can report the upload speed
+	uint32_t expectedCrc;								// the CRC32 the client says the file should have
+	bool checkCrc;										// true if the client sent the CRC32 of the file
 	bool uploadError;
+
+	static float lastUploadSpeed;						// the speed of the most recent successful upload in MB/sec
 };
 
 #endif /* SRC_DUETNG_DUETETHERNET_NETWORKRESPONDER_H_ */
@@ -518,6 +518,15 @@ bool Network::FindResponder(Socket *skt, Protocol protocol)
 			return true;
 		}
 	}
+
+	// They are all busy, so see if one of them is holding an idle persistent connection that it can give up
+	for (NetworkResponder *r = responders; r != nullptr; r = r->GetNext())
+	{
+		if (r->EvictIdleConnection(protocol) && r->Accept(skt, protocol))
+		{
+			return true;
+		}
+	}
 	return false;
 }
 
@@ -47,6 +47,8 @@ void Socket::ReInit()
 	persistConnection = true;
 	isTerminated = false;
 	isSending = false;
+	sendOutstanding = false;
+	closeAfterSending = false;
 	state = SocketState::inactive;
 
 	// Re-initialise the socket on the W5500
@@ -58,16 +60,30 @@ void Socket::Close()
 {
 	if (state != SocketState::disabled && state != SocketState::inactive)
 	{
-		ExecCommand(socketNum, Sn_CR_DISCON);
-		state = SocketState::closing;
-		DiscardReceivedData();
-		if (protocol == FtpDataProtocol)
+		Send();
+		if (sendOutstanding && state == SocketState::connected)
+		{
+			closeAfterSending = true;				// Poll will close the connection when it has sent the remaining data
+		}
+		else
 		{
-			localPort = 0;					// don't re-listen automatically
+			DoClose();
 		}
 	}
 }
 
+void Socket::DoClose()
+{
+	closeAfterSending = false;
+	ExecCommand(socketNum, Sn_CR_DISCON);
+	state = SocketState::closing;
+	DiscardReceivedData();
+	if (protocol == FtpDataProtocol)
+	{
+		localPort = 0;						// don't re-listen automatically
+	}
+}
+
 // Terminate a connection immediately
 void Socket::Terminate()
 {
@@ -182,8 +198,20 @@ void Socket::Poll(bool full)
 
 			if (state == SocketState::connected)
 			{
-				// See if the socket has received any data
-				ReceiveData();
+				// If we buffered data while the last send was in progress, send it now if we can
+				if (sendOutstanding && isSending)
+				{
+					Send();
+				}
+				if (closeAfterSending && !sendOutstanding)
+				{
+					DoClose();
+				}
+				else
+				{
+					// See if the socket has received any data
+					ReceiveData();
+				}
 			}
 			break;
 
@@ -205,40 +233,51 @@ void Socket::Poll(bool full)
 	}
 }
 
-// Try to receive more incoming data from the socket
+// Try to receive more incoming data from the socket.
+// We take as much of the pending data as we have buffer space for, filling each buffer with a single SPI burst.
+// Then we update the W5500 read pointer and issue the RECV command once, so that the W5500 can reopen the TCP window as early as possible.
 void Socket::ReceiveData()
 {
-	const uint16_t len = getSn_RX_RSR(socketNum);
+	uint16_t len = getSn_RX_RSR(socketNum);
 	if (len != 0)
 	{
 //		debugPrintf("%u available\n", len);
-		NetworkBuffer * const lastBuffer = NetworkBuffer::FindLast(receivedData);
-		if (lastBuffer != nullptr && (lastBuffer->SpaceLeft() >= len || (lastBuffer->SpaceLeft() != 0 && NetworkBuffer::Count(receivedData) >= MaxBuffersPerSocket)))
+		const uint16_t startPtr = getSn_RX_RD(socketNum);
+		uint16_t ptr = startPtr;
+		NetworkBuffer *lastBuffer = NetworkBuffer::FindLast(receivedData);
+		while (len != 0)
 		{
-			const size_t lengthToRead = min<size_t>((size_t)len, lastBuffer->SpaceLeft());
-			wiz_recv_data(socketNum, lastBuffer->UnwrittenData(), (uint16_t)lengthToRead);
-			lastBuffer->dataLength += lengthToRead;
-			if (reprap.Debug(moduleNetwork))
+			if (lastBuffer == nullptr || lastBuffer->SpaceLeft() == 0)
 			{
-				debugPrintf("Received %u bytes\n", (unsigned int)lengthToRead);
+				if (NetworkBuffer::Count(receivedData) >= MaxBuffersPerSocket)
+				{
+					break;
+				}
+				lastBuffer = NetworkBuffer::Allocate();
+				if (lastBuffer == nullptr)
+				{
+//					debugPrintf("no buffer\n");
+					break;
+				}
+				NetworkBuffer::AppendToList(&receivedData, lastBuffer);
 			}
+
+			const uint16_t lengthToRead = (uint16_t)min<size_t>((size_t)len, lastBuffer->SpaceLeft());
+			wiz_recv_data_at(socketNum, lastBuffer->UnwrittenData(), lengthToRead, ptr);
+			lastBuffer->dataLength += lengthToRead;
+			ptr += lengthToRead;
+			len -= lengthToRead;
 		}
-		else if (NetworkBuffer::Count(receivedData) < MaxBuffersPerSocket)
+
+		if (ptr != startPtr)
 		{
-			NetworkBuffer * const buf = NetworkBuffer::Allocate();
-			if (buf != nullptr)
+			setSn_RX_RD(socketNum, ptr);
+			ExecCommand(socketNum, Sn_CR_RECV);
+			if (reprap.Debug(moduleNetwork))
 			{
-				wiz_recv_data(socketNum, buf->Data(), len);
-				ExecCommand(socketNum, Sn_CR_RECV);
-				buf->dataLength = (size_t)len;
-				NetworkBuffer::AppendToList(&receivedData, buf);
-				if (reprap.Debug(moduleNetwork))
-				{
-					debugPrintf("Received %u bytes\n", (unsigned int)len);
-				}
+				debugPrintf("Received %u bytes\n", (unsigned int)(uint16_t)(ptr - startPtr));
 			}
 		}
-//		else debugPrintf("no buffer\n");
 	}
 }
 
@@ -256,26 +295,20 @@ size_t Socket::Send(const uint8_t *data, size_t length)
 {
 	if (CanSend() && length != 0 && getSn_SR(socketNum) == SOCK_ESTABLISHED)
 	{
-		// Check for previous send complete
-		if (isSending)									// are we already sending?
+		// If the last send is still in progress, we can still copy more data into the free part of the W5500 transmit buffer
+		// so that it is ready to go as soon as the last send completes
+		if (!CheckSendComplete() && state == SocketState::aborted)
 		{
-			const uint8_t tmp = getSn_IR(socketNum);
-			if (tmp & Sn_IR_SENDOK)						// did the previous send complete?
-			{
-				setSn_IR(socketNum, Sn_IR_SENDOK);		// if yes
-				isSending = false;
-			}
-			else if (tmp & Sn_IR_TIMEOUT)				// did it time out?
-			{
-				isSending = false;
-				disconnectNoWait(socketNum);			// if so, close the socket
-				state = SocketState::aborted;
-				return 0;								// and release buffers etc.
-			}
-			else
+			return 0;
+		}
+
+		if (sendOutstanding && wizTxBufferLeft == 0)
+		{
+			if (isSending)
 			{
-				return 0;								// last send is still in progress
+				return 0;								// the buffer filled up while the last send was in progress
 			}
+			Send();										// the last send has completed, so send the data we buffered while it was in progress
 		}
 
 		if (!sendOutstanding)
@@ -296,7 +329,7 @@ size_t Socket::Send(const uint8_t *data, size_t length)
 		wizTxBufferLeft -= length;
 		wizTxBufferPtr += length;
 		sendOutstanding = true;
-		if (wizTxBufferLeft == 0)
+		if (wizTxBufferLeft == 0 && !isSending)
 		{
 			Send();
 		}
@@ -305,10 +338,39 @@ size_t Socket::Send(const uint8_t *data, size_t length)
 	return 0;
 }
 
-// Tell the interface to send the outstanding data
+// Check whether the last send has completed, returning true if it has or if there was none.
+// If it timed out then we abort the connection and return false.
+bool Socket::CheckSendComplete()
+{
+	if (isSending)									// are we already sending?
+	{
+		const uint8_t tmp = getSn_IR(socketNum);
+		if (tmp & Sn_IR_SENDOK)						// did the previous send complete?
+		{
+			setSn_IR(socketNum, Sn_IR_SENDOK);		// if yes
+			isSending = false;
+		}
+		else if (tmp & Sn_IR_TIMEOUT)				// did it time out?
+		{
+			isSending = false;
+			sendOutstanding = false;
+			closeAfterSending = false;
+			disconnectNoWait(socketNum);			// if so, close the socket
+			state = SocketState::aborted;			// and release buffers etc.
+			return false;
+		}
+		else
+		{
+			return false;							// last send is still in progress
+		}
+	}
+	return true;
+}
+
+// Tell the interface to send the outstanding data. If the last send is still in progress then Poll will send it when the last send completes.
 void Socket::Send()
 {
-	if (CanSend() && sendOutstanding)
+	if (CanSend() && sendOutstanding && CheckSendComplete())
 	{
 		setSn_TX_WR(socketNum, wizTxBufferPtr);
 		ExecCommand(socketNum, Sn_CR_SEND);
@@ -47,6 +47,8 @@ private:
 	void ReInit();
 	void ReceiveData();
 	void DiscardReceivedData();
+	bool CheckSendComplete();
+	void DoClose();
 
 	Port localPort, remotePort;							// The local and remote ports
 	Protocol protocol;									// What protocol this socket is for
@@ -60,6 +62,7 @@ private:
 	SocketState state;
 	bool sendOutstanding;								// True if we have written data to the socket but not flushed it
 	bool isSending;										// True if we have written data to the W5500 to send and have not yet seen success or timeout
+	bool closeAfterSending;								// True if we have been asked to close the connection but still have data waiting for the last send to complete
 	uint16_t wizTxBufferPtr;							// Current offset into the Wizchip send buffer, if sendOutstanding is true
 	uint16_t wizTxBufferLeft;							// Transmit buffer space left, if sendOutstanding is true
 };
@@ -95,18 +95,36 @@ void WIZCHIP_WRITE_BUF(uint32_t AddrSel, const uint8_t* pBuf, uint16_t len)
 	WizSpi::ReleaseSS();
 }
 
+uint16_t WIZCHIP_READ16(uint32_t AddrSel)
+{
+	WizSpi::AssertSS();
+	WizSpi::SendAddress(AddrSel | (_W5500_SPI_READ_ | _W5500_SPI_VDM_OP_));
+	const uint8_t msb = WizSpi::ReadByte();
+	const uint8_t lsb = WizSpi::ReadByte();
+	WizSpi::ReleaseSS();
+	return ((uint16_t)msb << 8) | lsb;
+}
+
+void WIZCHIP_WRITE16(uint32_t AddrSel, uint16_t val)
+{
+	WizSpi::AssertSS();
+	WizSpi::SendAddress(AddrSel | (_W5500_SPI_WRITE_ | _W5500_SPI_VDM_OP_));
+	WizSpi::WriteByte((uint8_t)(val >> 8));
+	WizSpi::WriteByte((uint8_t)val);
+	WizSpi::ReleaseSS();
+}
+
 
+// The free size and received size registers can change while we read them, so we read them until we get the same value twice
 uint16_t getSn_TX_FSR(uint8_t sn)
 {
 	uint16_t val = 0, val1 = 0;
 	do
 	{
-		val1 = WIZCHIP_READ(Sn_TX_FSR(sn));
-		val1 = (val1 << 8) + WIZCHIP_READ(WIZCHIP_OFFSET_INC(Sn_TX_FSR(sn),1));
+		val1 = WIZCHIP_READ16(Sn_TX_FSR(sn));
 		if (val1 != 0)
 		{
-			val = WIZCHIP_READ(Sn_TX_FSR(sn));
-			val = (val << 8) + WIZCHIP_READ(WIZCHIP_OFFSET_INC(Sn_TX_FSR(sn),1));
+			val = WIZCHIP_READ16(Sn_TX_FSR(sn));
 		}
 	} while (val != val1);
 	return val;
@@ -117,12 +135,10 @@ uint16_t getSn_RX_RSR(uint8_t sn)
 	uint16_t val = 0, val1 = 0;
 	do
 	{
-		val1 = WIZCHIP_READ(Sn_RX_RSR(sn));
-		val1 = (val1 << 8) + WIZCHIP_READ(WIZCHIP_OFFSET_INC(Sn_RX_RSR(sn),1));
+		val1 = WIZCHIP_READ16(Sn_RX_RSR(sn));
 		if (val1 != 0)
 		{
-			val = WIZCHIP_READ(Sn_RX_RSR(sn));
-			val = (val << 8) + WIZCHIP_READ(WIZCHIP_OFFSET_INC(Sn_RX_RSR(sn),1));
+			val = WIZCHIP_READ16(Sn_RX_RSR(sn));
 		}
 	} while (val != val1);
 	return val;
@@ -167,6 +183,15 @@ void wiz_recv_data(uint8_t sn, uint8_t *wizdata, uint16_t len)
 }
 
 
+void wiz_recv_data_at(uint8_t sn, uint8_t *wizdata, uint16_t len, uint16_t ptr)
+{
+	if (len != 0)
+	{
+		const uint32_t addrsel = ((uint32_t)ptr << 8) + (WIZCHIP_RXBUF_BLOCK(sn) << 3);
+		WIZCHIP_READ_BUF(addrsel, wizdata, len);
+	}
+}
+
 void wiz_recv_ignore(uint8_t sn, uint16_t len)
 {
 	uint16_t ptr = getSn_RX_RD(sn);
@@ -1301,6 +1301,10 @@ void     WIZCHIP_READ_BUF (uint32_t AddrSel, uint8_t* pBuf, uint16_t len);
  */
 void     WIZCHIP_WRITE_BUF(uint32_t AddrSel, const uint8_t* pBuf, uint16_t len);
 
+// Read or write a 16-bit register in a single SPI frame, instead of using one frame per byte
+uint16_t WIZCHIP_READ16(uint32_t AddrSel);
+void     WIZCHIP_WRITE16(uint32_t AddrSel, uint16_t val);
+
 /////////////////////////////////
 // Common Register I/O function //
 /////////////////////////////////
@@ -2110,8 +2114,7 @@ static inline uint16_t getSn_TX_RD(uint8_t sn)
  */
 static inline void setSn_TX_WR(uint8_t sn, uint16_t txwr)
 {
-	WIZCHIP_WRITE(Sn_TX_WR(sn), (uint8_t)(txwr >> 8));
-	WIZCHIP_WRITE(WIZCHIP_OFFSET_INC(Sn_TX_WR(sn), 1), (uint8_t) txwr);
+	WIZCHIP_WRITE16(Sn_TX_WR(sn), txwr);
 }
 
 /**
@@ -2123,8 +2126,7 @@ static inline void setSn_TX_WR(uint8_t sn, uint16_t txwr)
  */
 static inline uint16_t getSn_TX_WR(uint8_t sn)
 {
-	const uint8_t msb = WIZCHIP_READ(Sn_TX_WR(sn));
-	return ((uint16_t)msb << 8) + WIZCHIP_READ(WIZCHIP_OFFSET_INC(Sn_TX_WR(sn),1));
+	return WIZCHIP_READ16(Sn_TX_WR(sn));
 }
 
 
@@ -2146,8 +2148,7 @@ uint16_t getSn_RX_RSR(uint8_t sn);
  */
 static inline void setSn_RX_RD(uint8_t sn, uint16_t rxrd)
 {
-	WIZCHIP_WRITE(Sn_RX_RD(sn), (uint8_t)(rxrd >> 8));
-	WIZCHIP_WRITE(WIZCHIP_OFFSET_INC(Sn_RX_RD(sn),1), (uint8_t) rxrd);
+	WIZCHIP_WRITE16(Sn_RX_RD(sn), rxrd);
 }
 
 /**
@@ -2159,8 +2160,7 @@ static inline void setSn_RX_RD(uint8_t sn, uint16_t rxrd)
  */
 static inline uint16_t getSn_RX_RD(uint8_t sn)
 {
-	const uint8_t msb = WIZCHIP_READ(Sn_RX_RD(sn));
-	return ((uint16_t)msb << 8) + WIZCHIP_READ(WIZCHIP_OFFSET_INC(Sn_RX_RD(sn), 1));
+	return WIZCHIP_READ16(Sn_RX_RD(sn));
 }
 
 /**
@@ -2287,6 +2287,10 @@ void wiz_send_data_at(uint8_t sn, const uint8_t *wizdata, uint16_t len, uint16_t
  */
 void wiz_recv_data(uint8_t sn, uint8_t *wizdata, uint16_t len);
 
+// Alternative to wiz_recv_data that reads from a known position and doesn't update the read pointer, so that the caller can
+// read into several buffers and then update the read pointer once
+void wiz_recv_data_at(uint8_t sn, uint8_t *wizdata, uint16_t len, uint16_t ptr);
+
 /**
  * @ingroup Basic_IO_function
  * @brief It discard the received data in RX memory.
@@ -10,9 +10,11 @@
 #include "RepRap.h"
 #include <cstdarg>
 
-/*static*/ OutputBuffer * volatile OutputBuffer::freeOutputBuffers = nullptr;		// Messages may also be sent by ISRs,
-/*static*/ volatile size_t OutputBuffer::usedOutputBuffers = 0;						// so make these volatile.
-/*static*/ volatile size_t OutputBuffer::maxUsedOutputBuffers = 0;
+/*static*/ char *OutputBuffer::arena = nullptr;
+/*static*/ OutputBuffer * volatile OutputBuffer::freeOutputBuffers[NumOutputChunkClasses] = { nullptr, nullptr };	// Messages may also be sent by ISRs,
+/*static*/ volatile size_t OutputBuffer::usedOutputBuffers[NumOutputChunkClasses] = { 0, 0 };						// so make these volatile.
+/*static*/ volatile size_t OutputBuffer::maxUsedOutputBuffers[NumOutputChunkClasses] = { 0, 0 };
+/*static*/ volatile uint32_t OutputBuffer::wouldBlockCount = 0;
 
 //*************************************************************************************************
 // OutputBuffer class implementation
@@ -156,11 +158,11 @@ size_t OutputBuffer::copy(const char *src, size_t len)
 size_t OutputBuffer::cat(const char c)
 {
 	// See if we can append a char
-	if (last->dataLength == OUTPUT_BUFFER_SIZE)
+	if (last->dataLength == last->capacity)
 	{
 		// No - allocate a new item and copy the data
 		OutputBuffer *nextBuffer;
-		if (!Allocate(nextBuffer))
+		if (!AllocateContinuation(nextBuffer))
 		{
 			// We cannot store any more data. Should never happen
 			return 0;
@@ -193,11 +195,11 @@ size_t OutputBuffer::cat(const char *src, size_t len)
 	size_t copied = 0;
 	while (copied < len)
 	{
-		if (last->dataLength == OUTPUT_BUFFER_SIZE)
+		if (last->dataLength == last->capacity)
 		{
 			// The last buffer is full
 			OutputBuffer *nextBuffer;
-			if (!Allocate(nextBuffer))
+			if (!AllocateContinuation(nextBuffer))
 			{
 				// We cannot store any more data, stop here
 				break;
@@ -210,7 +212,7 @@ size_t OutputBuffer::cat(const char *src, size_t len)
 				item->last = last;
 			}
 		}
-		const size_t copyLength = min<size_t>(len - copied, OUTPUT_BUFFER_SIZE - last->dataLength);
+		const size_t copyLength = min<size_t>(len - copied, last->capacity - last->dataLength);
 		memcpy(last->data + last->dataLength, src + copied, copyLength);
 		last->dataLength += copyLength;
 		copied += copyLength;
@@ -330,42 +332,87 @@ bool OutputBuffer::WriteToFile(FileData& f) const
 // Initialise the output buffers manager
 /*static*/ void OutputBuffer::Init()
 {
-	freeOutputBuffers = nullptr;
+	// Carve all the chunks out of a single region, small ones first
+	arena = new char[OUTPUT_BUFFER_ARENA_SIZE];
+	char *p = arena;
+
+	freeOutputBuffers[(size_t)OutputChunkClass::small] = nullptr;
 	for (size_t i = 0; i < OUTPUT_BUFFER_COUNT; i++)
 	{
-		freeOutputBuffers = new OutputBuffer(freeOutputBuffers);
+		freeOutputBuffers[(size_t)OutputChunkClass::small] = new OutputBuffer(freeOutputBuffers[(size_t)OutputChunkClass::small], p, OUTPUT_BUFFER_SIZE, OutputChunkClass::small);
+		p += OUTPUT_BUFFER_SIZE;
+	}
+
+	freeOutputBuffers[(size_t)OutputChunkClass::large] = nullptr;
+	for (size_t i = 0; i < LARGE_OUTPUT_BUFFER_COUNT; i++)
+	{
+		freeOutputBuffers[(size_t)OutputChunkClass::large] = new OutputBuffer(freeOutputBuffers[(size_t)OutputChunkClass::large], p, LARGE_OUTPUT_BUFFER_SIZE, OutputChunkClass::large);
+		p += LARGE_OUTPUT_BUFFER_SIZE;
 	}
 }
 
-// Allocates an output buffer instance which can be used for (large) string outputs
+// Take an instance from the free list of the specified class. Interrupts must be disabled when calling this.
+/*static*/ OutputBuffer *OutputBuffer::TakeFreeBuffer(OutputChunkClass cls)
+{
+	const size_t index = (size_t)cls;
+	OutputBuffer * const buf = freeOutputBuffers[index];
+	if (buf != nullptr)
+	{
+		freeOutputBuffers[index] = buf->next;
+		usedOutputBuffers[index]++;
+		if (usedOutputBuffers[index] > maxUsedOutputBuffers[index])
+		{
+			maxUsedOutputBuffers[index] = usedOutputBuffers[index];
+		}
+
+		buf->next = nullptr;
+		buf->last = buf;
+		buf->dataLength = buf->bytesRead = 0;
+		buf->references = 1; // Assume it's only used once by default
+		buf->isReferenced = false;
+	}
+	return buf;
+}
+
+// Allocates an output buffer instance which can be used for (large) string outputs.
+// New responses start in a small chunk so that the large ones remain available for long responses.
 /*static*/ bool OutputBuffer::Allocate(OutputBuffer *&buf)
 {
 	const irqflags_t flags = cpu_irq_save();
 
-	if (freeOutputBuffers == nullptr)
+	buf = TakeFreeBuffer(OutputChunkClass::small);
+	if (buf == nullptr)
 	{
-		reprap.GetPlatform().LogError(ErrorCode::OutputStarvation);
-		cpu_irq_restore(flags);
-
-		buf = nullptr;
-		return false;
+		buf = TakeFreeBuffer(OutputChunkClass::large);
+		if (buf == nullptr)
+		{
+			reprap.GetPlatform().LogError(ErrorCode::OutputStarvation);
+			cpu_irq_restore(flags);
+			return false;
+		}
 	}
 
-	buf = freeOutputBuffers;
-	freeOutputBuffers = buf->next;
+	cpu_irq_restore(flags);
+	return true;
+}
+
+// Allocates an output buffer instance to extend a chain that is being written. We prefer a large chunk here.
+/*static*/ bool OutputBuffer::AllocateContinuation(OutputBuffer *&buf)
+{
+	const irqflags_t flags = cpu_irq_save();
 
-	usedOutputBuffers++;
-	if (usedOutputBuffers > maxUsedOutputBuffers)
+	buf = TakeFreeBuffer(OutputChunkClass::large);
+	if (buf == nullptr)
 	{
-		maxUsedOutputBuffers = usedOutputBuffers;
+		buf = TakeFreeBuffer(OutputChunkClass::small);
+		if (buf == nullptr)
+		{
+			reprap.GetPlatform().LogError(ErrorCode::OutputStarvation);
+			cpu_irq_restore(flags);
+			return false;
+		}
 	}
 
-	buf->next = nullptr;
-	buf->last = buf;
-	buf->dataLength = buf->bytesRead = 0;
-	buf->references = 1; // Assume it's only used once by default
-	buf->isReferenced = false;
-
 	cpu_irq_restore(flags);
 	return true;
 }
@@ -373,23 +420,35 @@ bool OutputBuffer::WriteToFile(FileData& f) const
 // Get the number of bytes left for continuous writing
 /*static*/ size_t OutputBuffer::GetBytesLeft(const OutputBuffer *writingBuffer)
 {
-	const size_t freeOutputBuffers = OUTPUT_BUFFER_COUNT - usedOutputBuffers;
+	const size_t freeSmallBuffers = OUTPUT_BUFFER_COUNT - usedOutputBuffers[(size_t)OutputChunkClass::small];
+	const size_t freeLargeBytes = (LARGE_OUTPUT_BUFFER_COUNT - usedOutputBuffers[(size_t)OutputChunkClass::large]) * LARGE_OUTPUT_BUFFER_SIZE;
 	if (writingBuffer == nullptr)
 	{
 		// Only return the total number of bytes left
-		return freeOutputBuffers * OUTPUT_BUFFER_SIZE;
+		return freeSmallBuffers * OUTPUT_BUFFER_SIZE + freeLargeBytes;
 	}
 
 	// We're doing a possibly long response like a filelist
-	const size_t bytesLeft = OUTPUT_BUFFER_SIZE - writingBuffer->last->DataLength();
+	const size_t bytesLeft = writingBuffer->last->Capacity() - writingBuffer->last->DataLength() + freeLargeBytes;
 
-	if (freeOutputBuffers < RESERVED_OUTPUT_BUFFERS)
+	if (freeSmallBuffers < RESERVED_OUTPUT_BUFFERS)
 	{
 		// Keep some space left to encapsulate the responses (e.g. via an HTTP header)
 		return bytesLeft;
 	}
 
-	return bytesLeft + (freeOutputBuffers - RESERVED_OUTPUT_BUFFERS) * OUTPUT_BUFFER_SIZE;
+	return bytesLeft + (freeSmallBuffers - RESERVED_OUTPUT_BUFFERS) * OUTPUT_BUFFER_SIZE;
+}
+
+// Check whether appending bytesNeeded more bytes to writingBuffer would exhaust the buffer pool
+/*static*/ bool OutputBuffer::WouldBlock(const OutputBuffer *writingBuffer, size_t bytesNeeded)
+{
+	if (GetBytesLeft(writingBuffer) >= bytesNeeded)
+	{
+		return false;
+	}
+	++wouldBlockCount;
+	return true;
 }
 
 
@@ -418,8 +477,8 @@ bool OutputBuffer::WriteToFile(FileData& f) const
 
 		// Unlink and free the last entry
 		previousItem->next = nullptr;
+		releasedBytes += lastItem->Capacity();
 		Release(lastItem);
-		releasedBytes += OUTPUT_BUFFER_SIZE;
 	} while (previousItem != buffer && releasedBytes < bytesNeeded);
 
 	// Update all the references to the last item
@@ -445,10 +504,11 @@ bool OutputBuffer::WriteToFile(FileData& f) const
 		return nextBuffer;
 	}
 
-	// Otherwise prepend it to the list of free output buffers again
-	buf->next = freeOutputBuffers;
-	freeOutputBuffers = buf;
-	usedOutputBuffers--;
+	// Otherwise prepend it to the list of free output buffers of its class again
+	const size_t index = (size_t)buf->chunkClass;
+	buf->next = freeOutputBuffers[index];
+	freeOutputBuffers[index] = buf;
+	usedOutputBuffers[index]--;
 
 	cpu_irq_restore(flags);
 	return nextBuffer;
@@ -464,8 +524,10 @@ bool OutputBuffer::WriteToFile(FileData& f) const
 
 /*static*/ void OutputBuffer::Diagnostics(MessageType mtype)
 {
-	reprap.GetPlatform().MessageF(mtype, "Used output buffers: %d of %d (%d max)\n",
-			usedOutputBuffers, OUTPUT_BUFFER_COUNT, maxUsedOutputBuffers);
+	reprap.GetPlatform().MessageF(mtype, "Used output buffers: small %u of %u (%u max), large %u of %u (%u max), waits %" PRIu32 "\n",
+			usedOutputBuffers[(size_t)OutputChunkClass::small], OUTPUT_BUFFER_COUNT, maxUsedOutputBuffers[(size_t)OutputChunkClass::small],
+			usedOutputBuffers[(size_t)OutputChunkClass::large], LARGE_OUTPUT_BUFFER_COUNT, maxUsedOutputBuffers[(size_t)OutputChunkClass::large],
+			wouldBlockCount);
 }
 
 //*************************************************************************************************
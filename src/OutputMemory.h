@@ -14,6 +14,15 @@
 
 const size_t OUTPUT_STACK_DEPTH = 4;	// Number of OutputBuffer chains that can be pushed onto one stack instance
 
+// Chunk classes that OutputBuffer instances are allocated from
+enum class OutputChunkClass : uint8_t
+{
+	small = 0,							// OUTPUT_BUFFER_SIZE bytes, used to start every response
+	large = 1							// LARGE_OUTPUT_BUFFER_SIZE bytes, preferred when a long response needs another chunk
+};
+
+const size_t NumOutputChunkClasses = 2;
+
 class OutputStack;
 
 // This class is used to hold data for sending (either for Serial or Network destinations)
@@ -22,7 +31,7 @@ class OutputBuffer
 	public:
 		friend class OutputStack;
 
-		OutputBuffer(OutputBuffer *n) : next(n) { }
+		OutputBuffer(OutputBuffer *n, char *d, uint16_t cap, OutputChunkClass cls) : next(n), data(d), capacity(cap), chunkClass(cls) { }
 
 		void Append(OutputBuffer *other);
 		OutputBuffer *Next() const { return next; }
@@ -32,6 +41,7 @@ class OutputBuffer
 		const char *Data() const { return data; }
 		const char *UnreadData() const { return data + bytesRead; }
 		size_t DataLength() const { return dataLength; }	// How many bytes have been written to this instance?
+		size_t Capacity() const { return capacity; }		// How many bytes can this instance hold?
 		size_t Length() const;								// How many bytes have been written to the whole chain?
 
 		char& operator[](size_t index);
@@ -71,6 +81,10 @@ class OutputBuffer
 		// continuous writes, i.e. for writes that need to allocate an extra OutputBuffer instance to finish the message.
 		static size_t GetBytesLeft(const OutputBuffer *writingBuffer);
 
+		// Check whether appending another bytesNeeded bytes to writingBuffer would exhaust the buffer pool.
+		// If this returns true then the producer should finish what it is doing and resume once the pending output has been sent.
+		static bool WouldBlock(const OutputBuffer *writingBuffer, size_t bytesNeeded);
+
 		// Truncate an OutputBuffer instance to free up more memory. Returns the number of released bytes.
 		static size_t Truncate(OutputBuffer *buffer, size_t bytesNeeded);
 
@@ -83,21 +97,30 @@ class OutputBuffer
 		static void Diagnostics(MessageType mtype);
 
 	private:
+		// Allocate an instance for a chain that is already being written, preferring a large chunk
+		static bool AllocateContinuation(OutputBuffer *&buf);
+
+		// Take an instance from the free list of the specified chunk class, returning nullptr if there is none. Call with interrupts disabled.
+		static OutputBuffer *TakeFreeBuffer(OutputChunkClass cls);
 
 		OutputBuffer *next;
 		OutputBuffer *last;
 
 		uint32_t whenQueued;
 
-		char data[OUTPUT_BUFFER_SIZE];
+		char *data;											// points into the shared output buffer arena
 		size_t dataLength, bytesRead;
+		uint16_t capacity;
+		OutputChunkClass chunkClass;
 
 		bool isReferenced;
 		size_t references;
 
-		static OutputBuffer * volatile freeOutputBuffers;		// Messages may also be sent by ISRs,
-		static volatile size_t usedOutputBuffers;				// so make these volatile.
-		static volatile size_t maxUsedOutputBuffers;
+		static char *arena;										// the memory region that all chunks are carved from
+		static OutputBuffer * volatile freeOutputBuffers[NumOutputChunkClasses];		// Messages may also be sent by ISRs,
+		static volatile size_t usedOutputBuffers[NumOutputChunkClasses];				// so make these volatile.
+		static volatile size_t maxUsedOutputBuffers[NumOutputChunkClasses];
+		static volatile uint32_t wouldBlockCount;				// number of times a producer was told to wait for buffers
 };
 
 inline uint32_t OutputBuffer::GetAge() const
@@ -465,6 +465,10 @@ void Platform::Init()
 	SetZProbeDefaults();
 	InitZProbe();								// this also sets up zProbeModulationPin
 
+	// ENDSTOP INTERRUPTS
+	interruptEndstops = latchedEndstops = 0;
+	endstopInterruptStops = maxEndstopLatency = totalEndstopLatency = 0;
+
 	// AXES
 	ARRAY_INIT(axisMaxima, AXIS_MAXIMA);
 	ARRAY_INIT(axisMinima, AXIS_MINIMA);
@@ -1387,6 +1391,11 @@ void Platform::Spin()
 			// We cannot do this in ISRs, so do it here
 			files[i]->Close();
 		}
+		else
+		{
+			// Write a slice of any data queued by files being written, e.g. uploads
+			files[i]->Spin();
+		}
 	}
 
 	// Try to flush messages to serial ports
@@ -2193,6 +2202,13 @@ void Platform::Diagnostics(MessageType mtype)
 	}
 	MessageF(mtype, "Free file entries: %u\n", numFreeFiles);
 
+	// Show how quickly we acted on endstop and Z probe interrupts
+	MessageF(mtype, "Endstop interrupt stops: %" PRIu32 ", latency max %" PRIu32 "us, mean %" PRIu32 "us\n",
+				endstopInterruptStops,
+				(maxEndstopLatency * 1000000)/DDA::stepClockRate,
+				(endstopInterruptStops == 0) ? 0 : (uint32_t)(((uint64_t)totalEndstopLatency * 1000000)/(DDA::stepClockRate * endstopInterruptStops)));
+	endstopInterruptStops = maxEndstopLatency = totalEndstopLatency = 0;
+
 	// Show the HSMCI CD pin and speed
 #if HAS_HIGH_SPEED_SD
 	MessageF(mtype, "SD card 0 %s, interface speed: %.1fMBytes/sec\n", (sd_mmc_card_detected(0) ? "detected" : "not detected"), (double)((float)hsmci_get_speed() * 0.000001));
@@ -2202,6 +2218,7 @@ void Platform::Diagnostics(MessageType mtype)
 
 	// Show the longest SD card write time
 	MessageF(mtype, "SD card longest block write time: %.1fms\n", (double)FileStore::GetAndClearLongestWriteTime());
+	massStorage->Diagnostics(mtype);
 
 #if HAS_CPU_TEMP_SENSOR
 	// Show the MCU temperatures
@@ -2707,6 +2724,99 @@ EndStopHit Platform::GetZProbeResult() const
 				: EndStopHit::noStop;
 }
 
+// Attach pin change interrupts to those of the specified endstops and the Z probe that are plain switches with no filtering,
+// so that the step ISR need not poll them. Anything else, for example an analog or modulated Z probe, motor stall detection or an endstop
+// connected to the DueX I/O expander, is still polled.
+// This is called from the step ISR when a move that checks endstops starts.
+void Platform::EnableEndstopInterrupts(AxesBitmap axes, bool zProbe)
+{
+	DisableEndstopInterrupts();
+	latchedEndstops = 0;
+	for (size_t axis = 0; axis < reprap.GetGCodes().GetTotalAxes(); ++axis)
+	{
+		if (IsBitSet(axes, axis) && endStopPins[axis] != NoPin
+#ifdef DUET_NG
+			&& endStopPins[axis] < DueXnExpansionStart				// endstops on the DueX I/O expander can't generate pin change interrupts, so we keep polling them
+#endif
+			&& (endStopInputType[axis] == EndStopInputType::activeLow || endStopInputType[axis] == EndStopInputType::activeHigh))
+		{
+			SetBit(interruptEndstops, axis);
+			attachInterrupt(endStopPins[axis], EndstopInterruptEntry, CHANGE, reinterpret_cast<void*>(axis));
+		}
+	}
+	if (zProbe && zProbeType == 8 && zProbePin != NoPin)
+	{
+		SetBit(interruptEndstops, ZProbeInterruptSource);
+		attachInterrupt(zProbePin, EndstopInterruptEntry, CHANGE, reinterpret_cast<void*>(ZProbeInterruptSource));
+	}
+
+	// A switch may have been triggered already, in which case we won't get an edge.
+	// Disable interrupts while we check, because the pin change ISR also updates latchedEndstops.
+	const irqflags_t flags = cpu_irq_save();
+	for (size_t source = 0; source <= ZProbeInterruptSource; ++source)
+	{
+		if (IsBitSet(interruptEndstops, source))
+		{
+			EndstopInterrupt(source);
+		}
+	}
+	cpu_irq_restore(flags);
+}
+
+void Platform::DisableEndstopInterrupts()
+{
+	if (interruptEndstops != 0)
+	{
+		for (size_t axis = 0; axis < MaxAxes; ++axis)
+		{
+			if (IsBitSet(interruptEndstops, axis))
+			{
+				detachInterrupt(endStopPins[axis]);
+			}
+		}
+		if (IsBitSet(interruptEndstops, ZProbeInterruptSource))
+		{
+			detachInterrupt(zProbePin);
+		}
+		interruptEndstops = 0;
+	}
+}
+
+/*static*/ void Platform::EndstopInterruptEntry(void *param)
+{
+	reprap.GetPlatform().EndstopInterrupt(reinterpret_cast<size_t>(param));
+}
+
+// Handle a change on an endstop or Z probe input. This runs at a higher priority than the step ISR, so all we do is latch the trigger
+// and the time, then bring the step interrupt forward so that the step ISR stops the drives without waiting for the next step.
+void Platform::EndstopInterrupt(size_t source)
+{
+	if (IsBitSet(interruptEndstops, source) && !IsBitSet<AxesBitmap>(latchedEndstops, source))
+	{
+		const bool triggered = (source == ZProbeInterruptSource)
+								? GetZProbeResult() == EndStopHit::lowHit
+									: Stopped(source) != EndStopHit::noStop;
+		if (triggered)
+		{
+			endstopTriggerTimes[source] = GetInterruptClocks();
+			latchedEndstops |= MakeBitmap<AxesBitmap>(source);
+			RequestEarlyStepInterrupt();
+		}
+	}
+}
+
+// Record how long it took the step ISR to act on a latched endstop trigger
+void Platform::RecordEndstopLatency(size_t source)
+{
+	const uint32_t latency = GetInterruptClocks() - endstopTriggerTimes[source];
+	++endstopInterruptStops;
+	totalEndstopLatency += latency;
+	if (latency > maxEndstopLatency)
+	{
+		maxEndstopLatency = latency;
+	}
+}
+
 // Write the platform parameters to file
 bool Platform::WritePlatformParameters(FileStore *f) const
 {
@@ -3721,7 +3831,94 @@ void Platform::SetPressureAdvance(size_t extruder, float factor)
 	if (extruder < MaxExtruders)
 	{
 		pressureAdvance[extruder] = factor;
+		numPressureAdvancePoints[extruder] = 0;
+	}
+}
+
+// Check a table of extrusion rates and pressure advance values. The rates must be positive and in increasing order. Return true if they are not.
+/*static*/ bool Platform::CheckPressureAdvanceTable(const float rates[], const float advances[], size_t numPoints)
+{
+	if (numPoints > MaxPressureAdvancePoints)
+	{
+		return true;
+	}
+	for (size_t i = 0; i < numPoints; ++i)
+	{
+		if (rates[i] <= ((i == 0) ? 0.0 : rates[i - 1]) || advances[i] < 0.0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Set the non-linear pressure advance model for an extruder. The pressure advance at zero extrusion rate is the one set by SetPressureAdvance.
+// Return true if the table is not valid, in which case the existing one is left unchanged.
+bool Platform::SetPressureAdvanceTable(size_t extruder, const float rates[], const float advances[], size_t numPoints)
+{
+	if (extruder >= MaxExtruders || CheckPressureAdvanceTable(rates, advances, numPoints))
+	{
+		return true;
+	}
+	for (size_t i = 0; i < numPoints; ++i)
+	{
+		pressureAdvanceRates[extruder][i] = rates[i];
+		pressureAdvanceTable[extruder][i] = advances[i];
+	}
+	numPressureAdvancePoints[extruder] = numPoints;
+	return false;
+}
+
+// Get the pressure advance table for an extruder, returning the number of points in it
+size_t Platform::GetPressureAdvanceTable(size_t extruder, const float *&rates, const float *&advances) const
+{
+	if (extruder >= MaxExtruders)
+	{
+		return 0;
+	}
+	rates = pressureAdvanceRates[extruder];
+	advances = pressureAdvanceTable[extruder];
+	return numPressureAdvancePoints[extruder];
+}
+
+// Get the pressure advance for a move whose peak extrusion rate is as specified, in mm of filament per second.
+// We interpolate linearly between the rates in the table, with the pressure advance set by M572 S applying at zero rate, and hold the last value beyond the table.
+// This is called once per extruder when each move is prepared, so it doesn't affect the step interrupt.
+float Platform::GetPressureAdvance(size_t extruder, float extrusionRate) const
+{
+	if (extruder >= MaxExtruders)
+	{
+		return 0.0;
+	}
+
+	float lowRate = 0.0, lowAdvance = pressureAdvance[extruder];
+	for (size_t i = 0; i < numPressureAdvancePoints[extruder]; ++i)
+	{
+		const float highRate = pressureAdvanceRates[extruder][i];
+		const float highAdvance = pressureAdvanceTable[extruder][i];
+		if (extrusionRate < highRate)
+		{
+			return lowAdvance + (highAdvance - lowAdvance) * (extrusionRate - lowRate)/(highRate - lowRate);
+		}
+		lowRate = highRate;
+		lowAdvance = highAdvance;
+	}
+	return lowAdvance;
+}
+
+// Get the largest pressure advance that we may use for this extruder
+float Platform::GetMaxPressureAdvance(size_t extruder) const
+{
+	if (extruder >= MaxExtruders)
+	{
+		return 0.0;
 	}
+	float maxAdvance = pressureAdvance[extruder];
+	for (size_t i = 0; i < numPressureAdvancePoints[extruder]; ++i)
+	{
+		maxAdvance = max<float>(maxAdvance, pressureAdvanceTable[extruder][i]);
+	}
+	return maxAdvance;
 }
 
 float Platform::ActualInstantDv(size_t drive) const
@@ -3730,7 +3927,7 @@ float Platform::ActualInstantDv(size_t drive) const
 	const size_t numAxes = reprap.GetGCodes().GetTotalAxes();
 	if (drive >= numAxes)
 	{
-		const float eComp = pressureAdvance[drive - numAxes];
+		const float eComp = GetMaxPressureAdvance(drive - numAxes);
 		// If we are using pressure advance then we need to limit the extruder instantDv to avoid velocity mismatches.
 		// Assume that we want the extruder motor position to be accurate to within 0.01mm of extrusion.
 		// TODO remove this limit and add/remove steps to the previous and/or next move instead
@@ -4390,6 +4587,22 @@ void STEP_TC_HANDLER()
 	STEP_TC->TC_CHANNEL[STEP_TC_CHAN].TC_IDR = TC_IER_CPAS;
 }
 
+// Bring the next step interrupt forward to as soon as is safe, if one is scheduled. The step ISR allows for being called prematurely.
+// If the step ISR is running already then the interrupt is not enabled, so we do nothing and the ISR sees the change when it next runs.
+/*static*/ void Platform::RequestEarlyStepInterrupt()
+{
+	const irqflags_t flags = cpu_irq_save();
+	if ((STEP_TC->TC_CHANNEL[STEP_TC_CHAN].TC_IMR & TC_IMR_CPAS) != 0)
+	{
+		const uint32_t tim = GetInterruptClocks() + DDA::minInterruptInterval;
+		if ((int32_t)(STEP_TC->TC_CHANNEL[STEP_TC_CHAN].TC_RA - tim) > 0)
+		{
+			STEP_TC->TC_CHANNEL[STEP_TC_CHAN].TC_RA = tim;
+		}
+	}
+	cpu_irq_restore(flags);
+}
+
 // Schedule an interrupt at the specified clock count, or return true if that time is imminent or has passed already.
 /*static*/ bool Platform::ScheduleSoftTimerInterrupt(uint32_t tim)
 {
@@ -4512,6 +4725,10 @@ void Platform::Tick()
 
 	case 4:			// last conversion started was the Z probe, with IR LED off if modulation is enabled
 		const_cast<ZProbeAveragingFilter&>(zProbeOffFilter).ProcessReading(GetRawZProbeReading());
+		if (reprap.GetMove().AccessSweepProbe().IsSampling())
+		{
+			reprap.GetMove().RecordSweepSample(GetZProbeReading());		// we are probing the bed on the fly
+		}
 		// no break
 	case 0:			// this is the state after initialisation, no conversion has been started
 	default:
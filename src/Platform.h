@@ -69,6 +69,7 @@ const float MAX_FEEDRATES[DRIVES] = DRIVES_(100.0, 100.0, 3.0, 20.0, 20.0, 20.0,
 const float ACCELERATIONS[DRIVES] = DRIVES_(500.0, 500.0, 20.0, 250.0, 250.0, 250.0, 250.0, 250.0, 250.0, 250.0, 250.0, 250.0);					// mm/sec^2
 const float DRIVE_STEPS_PER_UNIT[DRIVES] = DRIVES_(87.4890, 87.4890, 4000.0, 420.0, 420.0, 420.0, 420.0, 420.0, 420.0, 420.0, 420.0, 420.0);	// steps/mm
 const float INSTANT_DVS[DRIVES] = DRIVES_(15.0, 15.0, 0.2, 2.0, 2.0, 2.0, 2.0, 2.0, 2.0, 2.0, 2.0, 2.0);										// mm/sec
+constexpr size_t MaxPressureAdvancePoints = 4;			// Maximum number of extrusion rates at which the pressure advance can be specified, in addition to zero
 
 // AXES
 
@@ -79,6 +80,8 @@ const float AXIS_MAXIMA[MaxAxes] = AXES_(230.0, 210.0, 200.0, 0.0, 0.0, 0.0, 0.0
 
 constexpr float Z_PROBE_STOP_HEIGHT = 0.7;						// Millimetres
 constexpr unsigned int Z_PROBE_AVERAGE_READINGS = 8;			// We average this number of readings with IR on, and the same number with IR off
+constexpr uint32_t TickIntervalMicros = 1000;					// The tick ISR runs every millisecond
+constexpr uint32_t TickStatesPerCycle = 4;						// and cycles through this many states, see Platform::Tick
 constexpr int Z_PROBE_AD_VALUE = 500;							// Default for the Z probe - should be overwritten by experiment
 
 // HEATERS - The bed is assumed to be the at index 0
@@ -318,6 +321,7 @@ public:
 	static uint32_t GetInterruptClocks() __attribute__ ((hot));					// Get the interrupt clock count
 	static bool ScheduleStepInterrupt(uint32_t tim) __attribute__ ((hot));		// Schedule an interrupt at the specified clock count, or return true if it has passed already
 	static void DisableStepInterrupt();						// Make sure we get no step interrupts
+	static void RequestEarlyStepInterrupt();				// Bring the next step interrupt forward, if one is scheduled
 	static bool ScheduleSoftTimerInterrupt(uint32_t tim);	// Schedule an interrupt at the specified clock count, or return true if it has passed already
 	static void DisableSoftTimerInterrupt();				// Make sure we get no software timer interrupts
 	void Tick() __attribute__((hot));						// Process a systick interrupt
@@ -431,7 +435,12 @@ public:
 	void SetAxisMinimum(size_t axis, float value, bool byProbing);
 	float AxisTotalLength(size_t axis) const;
 	float GetPressureAdvance(size_t drive) const;
+	float GetPressureAdvance(size_t extruder, float extrusionRate) const;	// Get the pressure advance to use for a move with the specified peak extrusion rate
+	float GetMaxPressureAdvance(size_t extruder) const;
 	void SetPressureAdvance(size_t extruder, float factor);
+	bool SetPressureAdvanceTable(size_t extruder, const float rates[], const float advances[], size_t numPoints);
+	static bool CheckPressureAdvanceTable(const float rates[], const float advances[], size_t numPoints);
+	size_t GetPressureAdvanceTable(size_t extruder, const float *&rates, const float *&advances) const;
 
 	void SetEndStopConfiguration(size_t axis, EndStopPosition endstopPos, EndStopInputType inputType)
 	pre(axis < MaxAxes);
@@ -440,6 +449,15 @@ public:
 	pre(axis < MaxAxes);
 
 	uint32_t GetAllEndstopStates() const;
+
+	// Endstop and Z probe pin change interrupts, used during moves that check endstops so that the step ISR doesn't have to poll switches
+	static constexpr size_t ZProbeInterruptSource = MaxAxes;	// the source number we use for the Z probe in the endstop interrupt bitmaps
+	void EnableEndstopInterrupts(AxesBitmap axes, bool zProbe);	// attach interrupts to those of the specified inputs that are unfiltered switches
+	void DisableEndstopInterrupts();
+	bool EndstopsNeedChecking(AxesBitmap axes, bool zProbe) const;
+	EndStopHit GetMoveEndstopResult(size_t axis);				// called by the step ISR in place of Stopped()
+	EndStopHit GetMoveZProbeResult();							// called by the step ISR in place of GetZProbeResult()
+	void EndstopInterrupt(size_t source);						// called by the pin change ISR
 	void SetAxisDriversConfig(size_t drive, const AxisDriversConfig& config);
 	const AxisDriversConfig& GetAxisDriversConfig(size_t drive) const
 		{ return axisDrivers[drive]; }
@@ -461,6 +479,7 @@ public:
 	float GetZProbeStartingHeight();
 	float GetZProbeTravelSpeed() const;
 	int GetZProbeReading() const;
+	uint32_t GetZProbeLagMicros() const;
 	EndStopHit GetZProbeResult() const;
 	int GetZProbeSecondaryValues(int& v1, int& v2);
 	void SetZProbeType(int iZ);
@@ -699,6 +718,9 @@ private:
 	float driveStepsPerUnit[DRIVES];
 	float instantDvs[DRIVES];
 	float pressureAdvance[MaxExtruders];
+	float pressureAdvanceRates[MaxExtruders][MaxPressureAdvancePoints];		// extrusion rates in mm/sec at which additional pressure advance values are given, in increasing order
+	float pressureAdvanceTable[MaxExtruders][MaxPressureAdvancePoints];		// the pressure advance at each of those rates
+	uint8_t numPressureAdvancePoints[MaxExtruders];							// zero for the linear pressure advance model
 	float motorCurrents[DRIVES];					// the normal motor current for each stepper driver
 	float motorCurrentFraction[DRIVES];				// the percentages of normal motor current that each driver is set to
 #if HAS_SMART_DRIVERS
@@ -768,6 +790,16 @@ private:
 	EndStopPosition endStopPos[MaxAxes];
 	EndStopInputType endStopInputType[MaxAxes];
 
+	// Endstop pin change interrupts
+	static void EndstopInterruptEntry(void *param);
+	void RecordEndstopLatency(size_t source);
+
+	AxesBitmap interruptEndstops;							// endstops and Z probe (bit ZProbeInterruptSource) that have interrupts attached
+	volatile AxesBitmap latchedEndstops;					// those of the above that have triggered since the interrupts were attached
+	uint32_t endstopTriggerTimes[MaxAxes + 1];				// step clock when each source triggered
+	uint32_t endstopInterruptStops;							// number of moves stopped by an endstop interrupt since the last diagnostics
+	uint32_t maxEndstopLatency, totalEndstopLatency;		// step clocks from the trigger to the step ISR acting on it
+
 	static bool WriteAxisLimits(FileStore *f, AxesBitmap axesProbed, const float limits[MaxAxes], int sParam);
 
 	// Heaters - bed is assumed to be the first
@@ -1102,6 +1134,55 @@ inline float Platform::GetPressureAdvance(size_t extruder) const
 	return STEP_TC->TC_CHANNEL[STEP_TC_CHAN].TC_CV;
 }
 
+// Return true if the step ISR needs to look at any of the specified endstops, i.e. one is polled or an interrupt-driven one has triggered
+inline bool Platform::EndstopsNeedChecking(AxesBitmap axes, bool zProbe) const
+{
+	if (zProbe)
+	{
+		axes |= MakeBitmap<AxesBitmap>(ZProbeInterruptSource);
+	}
+	return (axes & ~interruptEndstops) != 0 || (axes & latchedEndstops) != 0;
+}
+
+// Return the state of an axis endstop during a move, using the latched trigger if it is interrupt-driven
+inline EndStopHit Platform::GetMoveEndstopResult(size_t axis)
+{
+	if (!IsBitSet(interruptEndstops, axis))
+	{
+		return Stopped(axis);
+	}
+	if (!IsBitSet<AxesBitmap>(latchedEndstops, axis))
+	{
+		return EndStopHit::noStop;
+	}
+	RecordEndstopLatency(axis);
+	return (endStopPos[axis] == EndStopPosition::highEndStop) ? EndStopHit::highHit : EndStopHit::lowHit;
+}
+
+// Return the state of the Z probe during a move, using the latched trigger if it is interrupt-driven
+inline EndStopHit Platform::GetMoveZProbeResult()
+{
+	if (!IsBitSet(interruptEndstops, ZProbeInterruptSource))
+	{
+		return GetZProbeResult();
+	}
+	if (!IsBitSet<AxesBitmap>(latchedEndstops, ZProbeInterruptSource))
+	{
+		return EndStopHit::noStop;
+	}
+	RecordEndstopLatency(ZProbeInterruptSource);
+	return EndStopHit::lowHit;
+}
+
+// Return how long the filtered Z probe reading lags behind the probe, in microseconds.
+// Each filter averages readings taken evenly over its span, so the lag is half the span. A modulated IR probe feeds each filter
+// once per cycle of tick states, because it needs a tick to settle after switching the IR emitter. Other probes feed each filter twice per cycle.
+inline uint32_t Platform::GetZProbeLagMicros() const
+{
+	const uint32_t readingsPerCycle = (zProbeType == 2) ? 1 : 2;
+	return (Z_PROBE_AVERAGE_READINGS * TickStatesPerCycle * TickIntervalMicros)/(2 * readingsPerCycle);
+}
+
 // This is called by the tick ISR to get the raw Z probe reading to feed to the filter
 inline uint16_t Platform::GetRawZProbeReading() const
 {
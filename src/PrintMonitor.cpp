@@ -308,6 +308,7 @@ bool PrintMonitor::GetFileInfo(const char *directory, const char *fileName, GCod
 		parsedFileInfo.objectHeight = 0.0;
 		parsedFileInfo.layerHeight = 0.0;
 		parsedFileInfo.numFilaments = 0;
+		parsedFileInfo.simulatedTime = 0;
 		parsedFileInfo.generatedBy[0] = 0;
 		for(size_t extr = 0; extr < MaxExtruders; extr++)
 		{
@@ -452,6 +453,12 @@ bool PrintMonitor::GetFileInfo(const char *directory, const char *fileName, GCod
 			}
 			headerInfoComplete &= (parsedFileInfo.generatedBy[0] != 0);
 
+			// Search for the simulated print time. We append it to the end of the file, so we don't keep looking if it isn't there.
+			if (parsedFileInfo.simulatedTime == 0)
+			{
+				(void)FindSimulatedTime(buf, sizeToScan, parsedFileInfo.simulatedTime);
+			}
+
 			// Keep track of the time stats
 			accumulatedParseTime += millis() - startTime;
 
@@ -631,6 +638,10 @@ bool PrintMonitor::GetFileInfoResponse(const char *filename, OutputBuffer *&resp
 			}
 			response->cat("],\"generatedBy\":");
 			response->EncodeString(info.generatedBy, ARRAY_SIZE(info.generatedBy), false);
+			if (info.simulatedTime != 0)
+			{
+				response->catf(",\"simulatedTime\":%" PRIu32, info.simulatedTime);
+			}
 			response->cat("}");
 		}
 		else
@@ -671,6 +682,10 @@ bool PrintMonitor::GetFileInfoResponse(const char *filename, OutputBuffer *&resp
 		}
 		response->cat("],\"generatedBy\":");
 		response->EncodeString(printingFileInfo.generatedBy, ARRAY_SIZE(printingFileInfo.generatedBy), false);
+		if (printingFileInfo.simulatedTime != 0)
+		{
+			response->catf(",\"simulatedTime\":%" PRIu32, printingFileInfo.simulatedTime);
+		}
 		response->catf(",\"printDuration\":%d,\"fileName\":", (int)GetPrintDuration());
 		response->EncodeString(filenameBeingPrinted, ARRAY_SIZE(filenameBeingPrinted), false);
 		response->cat('}');
@@ -831,6 +846,15 @@ float PrintMonitor::EstimateTimeLeft(PrintEstimationMethod method) const
 				return (timeLeft > 0.0) ? timeLeft : 0.1;
 			}
 			break;
+
+		case simulationBased:
+			// The simulation doesn't include heating time, so compare it with the time since warm-up finished
+			if (printingFileInfo.simulatedTime != 0 && !heatingUp)
+			{
+				const float timeLeft = (float)printingFileInfo.simulatedTime - realPrintDuration;
+				return (timeLeft > 0.0) ? timeLeft : 0.1;
+			}
+			break;
 	}
 
 	return 0.0;
@@ -1056,6 +1080,34 @@ bool PrintMonitor::FindLayerHeight(const char *buf, size_t len, float& layerHeig
 	return false;
 }
 
+// Scan the buffer for the simulated print time that we append to a file when we simulate it. The buffer is null-terminated.
+bool PrintMonitor::FindSimulatedTime(const char* buf, size_t len, uint32_t& simulatedTime) const
+{
+	static const char* const SimulatedTimeString = "; Simulated print time:";
+
+	const char *pos = strstr(buf, SimulatedTimeString);
+	if (pos == nullptr)
+	{
+		return false;
+	}
+
+	// If the file was simulated more than once, use the last one
+	for (const char *next; (next = strstr(pos + 1, SimulatedTimeString)) != nullptr; )
+	{
+		pos = next;
+	}
+
+	pos += strlen(SimulatedTimeString);
+	char *tailPtr;
+	const uint32_t val = strtoul(pos, &tailPtr, 10);
+	if (tailPtr == pos)
+	{
+		return false;
+	}
+	simulatedTime = val;
+	return true;
+}
+
 // Scan the buffer for the filament used. The buffer is null-terminated.
 // Returns the number of filaments found.
 unsigned int PrintMonitor::FindFilamentUsed(const char* buf, size_t len, float *filamentUsed, unsigned int maxFilaments) const
@@ -47,7 +47,8 @@ enum PrintEstimationMethod
 {
 	filamentBased,
 	fileBased,
-	layerBased
+	layerBased,
+	simulationBased
 };
 
 // Struct to hold Gcode file information
@@ -61,6 +62,7 @@ struct GCodeFileInfo
 	float filamentNeeded[MaxExtruders];
 	unsigned int numFilaments;
 	float layerHeight;
+	uint32_t simulatedTime;							// print time found by simulating the file (see M37), or zero if not known
 	char generatedBy[50];
 };
 
@@ -145,6 +147,7 @@ class PrintMonitor
 		bool FindHeight(const char* buf, size_t len, float& height) const;
 		bool FindFirstLayerHeight(const char* buf, size_t len, float& layerHeight) const;
 		bool FindLayerHeight(const char* buf, size_t len, float& layerHeight) const;
+		bool FindSimulatedTime(const char* buf, size_t len, uint32_t& simulatedTime) const;
 		unsigned int FindFilamentUsed(const char* buf, size_t len, float *filamentUsed, unsigned int maxFilaments) const;
 
 		uint32_t accumulatedParseTime, accumulatedReadTime, accumulatedSeekTime;
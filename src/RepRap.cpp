@@ -57,7 +57,7 @@ extern "C" void hsmciIdle()
 
 RepRap::RepRap() : toolList(nullptr), currentTool(nullptr), lastWarningMillis(0), activeExtruders(0),
 	activeToolHeaters(0), ticksInSpinState(0), spinningModule(noModule), debug(0), stopped(false),
-	active(false), resetting(false), processingConfig(true), beepFrequency(0), beepDuration(0)
+	active(false), resetting(false), processingConfig(true), beepFrequency(0), beepDuration(0), eventSeq(0)
 {
 	OutputBuffer::Init();
 	platform = new Platform();
@@ -87,11 +87,24 @@ RepRap::RepRap() : toolList(nullptr), currentTool(nullptr), lastWarningMillis(0)
 void RepRap::Init()
 {
 	// All of the following init functions must execute reasonably quickly before the watchdog times us out
+	uint32_t phaseStartTime = millis();
+	auto endPhase = [this, &phaseStartTime](BootPhase phase)
+		{
+			const uint32_t now = millis();
+			bootPhaseTimes[(size_t)phase] = now - phaseStartTime;
+			phaseStartTime = now;
+		};
+
 	platform->Init();
+	endPhase(BootPhase::platform);
 	gCodes->Init();
+	endPhase(BootPhase::gcodes);
 	network->Init();
+	endPhase(BootPhase::network);
 	move->Init();
+	endPhase(BootPhase::move);
 	heat->Init();
+	endPhase(BootPhase::heat);
 #if SUPPORT_ROLAND
 	roland->Init();
 #endif
@@ -102,16 +115,25 @@ void RepRap::Init()
 	portControl->Init();
 #endif
 	printMonitor->Init();
+	endPhase(BootPhase::otherModules);
 	active = true;					// must do this before we start the network, else the watchdog may time out
 
 	platform->MessageF(UsbMessage, "%s Version %s dated %s\n", FIRMWARE_NAME, VERSION, DATE);
 
-	// Run the configuration file
+	// Run the configuration file, or the snapshot of it if we have a valid one
 	const char *configFile = platform->GetConfigFile();
 	platform->Message(UsbMessage, "\nExecuting ");
 	if (platform->GetMassStorage()->FileExists(platform->GetSysDir(), configFile))
 	{
-		platform->MessageF(UsbMessage, "%s...", platform->GetConfigFile());
+		if (gCodes->ConfigSnapshotValid(configFile))
+		{
+			platform->MessageF(UsbMessage, "%s (snapshot of %s)...", GCodes::CONFIG_SNAPSHOT_G, configFile);
+			configFile = GCodes::CONFIG_SNAPSHOT_G;
+		}
+		else
+		{
+			platform->MessageF(UsbMessage, "%s...", configFile);
+		}
 	}
 	else
 	{
@@ -133,13 +155,16 @@ void RepRap::Init()
 		platform->Message(UsbMessage, "Error, not found\n");
 	}
 	processingConfig = false;
+	endPhase(BootPhase::config);
 
 	// Enable network (unless it's disabled)
 	network->Activate();			// Need to do this here, as the configuration GCodes may set IP address etc.
+	endPhase(BootPhase::networkActivate);
 
 #if HAS_HIGH_SPEED_SD
 	hsmci_set_idle_func(hsmciIdle);
 #endif
+	ReportBootTimes(UsbMessage);
 	platform->MessageF(UsbMessage, "%s is up and running.\n", FIRMWARE_NAME);
 	fastLoop = UINT32_MAX;
 	slowLoop = 0;
@@ -189,6 +214,23 @@ void RepRap::Spin()
 	spinningModule = moduleMove;
 	move->Spin();
 
+	// When simulating a whole file, keep feeding moves through the planner for a while so that the simulation finishes in seconds rather than minutes.
+	// No steps are generated in simulation mode, so the time taken is mostly parsing the file and planning the moves.
+	if (gCodes->IsSimulatingFile())
+	{
+		const uint32_t simStartTime = millis();
+		do
+		{
+			ticksInSpinState = 0;
+			spinningModule = moduleGcodes;
+			gCodes->Spin();
+
+			ticksInSpinState = 0;
+			spinningModule = moduleMove;
+			move->Spin();
+		} while (gCodes->IsSimulatingFile() && millis() - simStartTime < FastSimulationSliceTime);
+	}
+
 	ticksInSpinState = 0;
 	spinningModule = moduleHeat;
 	heat->Spin();
@@ -273,6 +315,21 @@ void RepRap::Diagnostics(MessageType mtype)
 	gCodes->Diagnostics(mtype);
 	network->Diagnostics(mtype);
 	FilamentSensor::Diagnostics(mtype);
+	ReportBootTimes(mtype);
+}
+
+/*static*/ const char * const RepRap::BootPhaseNames[] = { "platform", "gcodes", "network", "move", "heat", "other", "config", "net start" };
+
+// Report how long each phase of the startup process took
+void RepRap::ReportBootTimes(MessageType mtype) const
+{
+	static_assert(ARRAY_SIZE(BootPhaseNames) == (size_t)BootPhase::numPhases, "Wrong number of boot phase names");
+	platform->Message(mtype, "Startup times (ms):");
+	for (size_t i = 0; i < (size_t)BootPhase::numPhases; ++i)
+	{
+		platform->MessageF(mtype, " %s %" PRIu32, BootPhaseNames[i], bootPhaseTimes[i]);
+	}
+	platform->Message(mtype, "\n");
 }
 
 // Turn off the heaters, disable the motors, and deactivate the Heat and Move classes. Leave everything else working.
@@ -1100,7 +1157,10 @@ OutputBuffer *RepRap::GetStatusResponse(uint8_t type, ResponseSource source)
 			response->catf(",\"filament\":%.1f", (double)(printMonitor->EstimateTimeLeft(filamentBased)));
 
 			// Based on layers
-			response->catf(",\"layer\":%.1f}", (double)(printMonitor->EstimateTimeLeft(layerBased)));
+			response->catf(",\"layer\":%.1f", (double)(printMonitor->EstimateTimeLeft(layerBased)));
+
+			// Based on simulating the file
+			response->catf(",\"simulation\":%.1f}", (double)(printMonitor->EstimateTimeLeft(simulationBased)));
 		}
 	}
 
@@ -1421,7 +1481,11 @@ OutputBuffer *RepRap::GetLegacyStatusResponse(uint8_t type, int seq)
 
 // Get the list of files in the specified directory in JSON format.
 // If flagDirs is true then we prefix each directory with a * character.
-OutputBuffer *RepRap::GetFilesResponse(const char *dir, bool flagsDirs)
+// The listing starts at directory entry 'startAt' and returns at most 'maxItems' files (0 means no limit).
+// If we stop early because of the limit or because we ran short of output buffers, 'next' is set to the index to pass
+// as 'startAt' to get the rest of the listing, otherwise it is zero.
+// Return nullptr if we can't get enough output buffers to return at least one entry, in which case the caller should try again later.
+OutputBuffer *RepRap::GetFilesResponse(const char *dir, unsigned int startAt, unsigned int maxItems, bool flagsDirs)
 {
 	// Need something to write to...
 	OutputBuffer *response;
@@ -1432,8 +1496,9 @@ OutputBuffer *RepRap::GetFilesResponse(const char *dir, bool flagsDirs)
 
 	response->copy("{\"dir\":");
 	response->EncodeString(dir, strlen(dir), false);
-	response->cat(",\"files\":[");
+	response->catf(",\"first\":%u,\"files\":[", startAt);
 	unsigned int err;
+	unsigned int nextFile = 0;
 
 	if (!platform->GetMassStorage()->CheckDriveMounted(dir))
 	{
@@ -1444,9 +1509,10 @@ OutputBuffer *RepRap::GetFilesResponse(const char *dir, bool flagsDirs)
 		err = 0;
 		FileInfo fileInfo;
 		bool firstFile = true;
-		bool gotFile = platform->GetMassStorage()->FindFirst(dir, fileInfo);	// TODO error handling here
+		unsigned int numItems = 0;
+		unsigned int fileIndex = startAt;
+		bool gotFile = platform->GetMassStorage()->FindAt(dir, startAt, fileInfo);	// TODO error handling here
 
-		size_t bytesLeft = OutputBuffer::GetBytesLeft(response);	// don't write more bytes than we can
 		char filename[FILENAME_LENGTH];
 		filename[0] = '*';
 		const char *fname;
@@ -1467,30 +1533,41 @@ OutputBuffer *RepRap::GetFilesResponse(const char *dir, bool flagsDirs)
 				}
 
 				// Make sure we can end this response properly
-				if (bytesLeft < strlen(fname) * 2 + 4)
+				if ((maxItems != 0 && numItems == maxItems) || OutputBuffer::WouldBlock(response, strlen(fname) * 2 + 16))
 				{
-					// No more space available - stop here
+					if (numItems == 0)
+					{
+						// We can't return even one entry, and 'next' must not be the same as 'startAt', so the client must try again later
+						OutputBuffer::ReleaseAll(response);
+						return nullptr;
+					}
+
+					// No more space available - stop here and tell the client where to carry on
+					nextFile = fileIndex;
 					break;
 				}
 
 				// Write separator and filename
 				if (!firstFile)
 				{
-					bytesLeft -= response->cat(',');
+					response->cat(',');
 				}
-				bytesLeft -= response->EncodeString(fname, FILENAME_LENGTH, false);
+				response->EncodeString(fname, FILENAME_LENGTH, false);
 
 				firstFile = false;
+				++numItems;
 			}
+			++fileIndex;
 			gotFile = platform->GetMassStorage()->FindNext(fileInfo);	// TODO error handling here
 		}
 	}
-	response->catf("],\"err\":%u}", err);
+	response->catf("],\"next\":%u,\"err\":%u}", nextFile, err);
 	return response;
 }
 
-// Get a JSON-style filelist including file types and sizes
-OutputBuffer *RepRap::GetFilelistResponse(const char *dir)
+// Get a JSON-style filelist including file types and sizes.
+// The 'startAt' and 'maxItems' parameters and the 'next' value in the response work as for GetFilesResponse.
+OutputBuffer *RepRap::GetFilelistResponse(const char *dir, unsigned int startAt, unsigned int maxItems)
 {
 	// Need something to write to...
 	OutputBuffer *response;
@@ -1515,52 +1592,64 @@ OutputBuffer *RepRap::GetFilelistResponse(const char *dir)
 
 	response->copy("{\"dir\":");
 	response->EncodeString(dir, strlen(dir), false);
-	response->cat(",\"files\":[");
+	response->catf(",\"first\":%u,\"files\":[", startAt);
 
 	FileInfo fileInfo;
 	bool firstFile = true;
-	bool gotFile = platform->GetMassStorage()->FindFirst(dir, fileInfo);
-	size_t bytesLeft = OutputBuffer::GetBytesLeft(response);	// don't write more bytes than we can
+	unsigned int numItems = 0;
+	unsigned int fileIndex = startAt;
+	unsigned int nextFile = 0;
+	bool gotFile = platform->GetMassStorage()->FindAt(dir, startAt, fileInfo);
 
 	while (gotFile)
 	{
 		if (fileInfo.fileName[0] != '.')			// ignore Mac resource files and Linux hidden files
 		{
 			// Make sure we can end this response properly
-			if (bytesLeft < strlen(fileInfo.fileName) + 70)
+			if ((maxItems != 0 && numItems == maxItems) || OutputBuffer::WouldBlock(response, strlen(fileInfo.fileName) + 80))
 			{
-				// No more space available - stop here
+				if (numItems == 0)
+				{
+					// We can't return even one entry, and 'next' must not be the same as 'startAt', so the client must try again later
+					OutputBuffer::ReleaseAll(response);
+					return nullptr;
+				}
+
+				// No more space available - stop here and tell the client where to carry on
+				nextFile = fileIndex;
 				break;
 			}
 
 			// Write delimiter
 			if (!firstFile)
 			{
-				bytesLeft -= response->cat(',');
+				response->cat(',');
 			}
 			firstFile = false;
+			++numItems;
 
 			// Write another file entry
-			bytesLeft -= response->catf("{\"type\":\"%c\",\"name\":", fileInfo.isDirectory ? 'd' : 'f');
-			bytesLeft -= response->EncodeString(fileInfo.fileName, FILENAME_LENGTH, false);
-			bytesLeft -= response->catf(",\"size\":%" PRIu32, fileInfo.size);
+			response->catf("{\"type\":\"%c\",\"name\":", fileInfo.isDirectory ? 'd' : 'f');
+			response->EncodeString(fileInfo.fileName, FILENAME_LENGTH, false);
+			response->catf(",\"size\":%" PRIu32, fileInfo.size);
 
 			const struct tm * const timeInfo = gmtime(&fileInfo.lastModified);
 			if (timeInfo->tm_year <= /*19*/80)
 			{
 				// Don't send the last modified date if it is invalid
-				bytesLeft -= response->cat('}');
+				response->cat('}');
 			}
 			else
 			{
-				bytesLeft -= response->catf(",\"date\":\"%04u-%02u-%02uT%02u:%02u:%02u\"}",
+				response->catf(",\"date\":\"%04u-%02u-%02uT%02u:%02u:%02u\"}",
 						timeInfo->tm_year + 1900, timeInfo->tm_mon + 1, timeInfo->tm_mday,
 						timeInfo->tm_hour, timeInfo->tm_min, timeInfo->tm_sec);
 			}
 		}
+		++fileIndex;
 		gotFile = platform->GetMassStorage()->FindNext(fileInfo);
 	}
-	response->cat("]}");
+	response->catf("],\"next\":%u}", nextFile);
 
 	return response;
 }
@@ -1570,6 +1659,7 @@ void RepRap::Beep(int freq, int ms)
 {
 	beepFrequency = freq;
 	beepDuration = ms;
+	++eventSeq;
 
 	if (platform->HaveAux())
 	{
@@ -1582,6 +1672,7 @@ void RepRap::Beep(int freq, int ms)
 void RepRap::SetMessage(const char *msg)
 {
 	SafeStrncpy(message, msg, ARRAY_SIZE(message));
+	++eventSeq;
 
 	if (platform->HaveAux())
 	{
@@ -1599,12 +1690,14 @@ void RepRap::SetAlert(const char *msg, const char *title, int mode, float timeou
 	boxTimeout = round(max<float>(timeout, 0.0) * 1000.0);
 	boxControls = controls;
 	displayMessageBox = true;
+	++eventSeq;
 }
 
 // Clear pending message box
 void RepRap::ClearAlert()
 {
 	displayMessageBox = false;
+	++eventSeq;
 }
 
 // Get the status character for the new-style status response
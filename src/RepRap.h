@@ -97,13 +97,16 @@ public:
 	OutputBuffer *GetStatusResponse(uint8_t type, ResponseSource source);
 	OutputBuffer *GetConfigResponse();
 	OutputBuffer *GetLegacyStatusResponse(uint8_t type, int seq);
-	OutputBuffer *GetFilesResponse(const char* dir, bool flagsDirs);
-	OutputBuffer *GetFilelistResponse(const char* dir);
+	OutputBuffer *GetFilesResponse(const char* dir, unsigned int startAt, unsigned int maxItems, bool flagsDirs);
+	OutputBuffer *GetFilelistResponse(const char* dir, unsigned int startAt, unsigned int maxItems);
 
 	void Beep(int freq, int ms);
 	void SetMessage(const char *msg);
 	void SetAlert(const char *msg, const char *title, int mode, float timeout, AxesBitmap controls);
 	void ClearAlert();
+	uint32_t GetEventSeq() const { return eventSeq; }		// incremented whenever there is a new beep, message or message box change
+	bool HavePendingMessage() const { return message[0] != 0; }
+	char GetStatusCharacter() const;
 
 	bool WriteToolSettings(FileStore *f) const;				// save some information for the resume file
 	bool WriteToolParameters(FileStore *f) const;			// save some information in config-override.g
@@ -116,8 +119,6 @@ public:
 private:
 	static void EncodeString(StringRef& response, const char* src, size_t spaceToLeave, bool allowControlChars = false, char prefix = 0);
 
-	char GetStatusCharacter() const;
-
 	static constexpr uint32_t MaxTicksInSpinState = 20000;	// timeout before we reset the processor
 	static constexpr uint32_t HighTicksInSpinState = 16000;	// how long before we warn that timeout is approaching
 
@@ -152,11 +153,18 @@ private:
 	bool resetting;
 	bool processingConfig;
 
+	// Time taken by each phase of the startup process, reported by M122
+	enum class BootPhase : uint8_t { platform = 0, gcodes, network, move, heat, otherModules, config, networkActivate, numPhases };
+	static const char * const BootPhaseNames[];
+	uint32_t bootPhaseTimes[(size_t)BootPhase::numPhases];
+	void ReportBootTimes(MessageType mtype) const;
+
 	char password[PASSWORD_LENGTH + 1];
 	char myName[MACHINE_NAME_LENGTH + 1];
 
 	int beepFrequency, beepDuration;
 	char message[MESSAGE_LENGTH + 1];
+	uint32_t eventSeq;							// lets clients that wait for status changes know about new notifications
 
 	bool displayMessageBox;
 	char boxMessage[MESSAGE_LENGTH + 1], boxTitle[MESSAGE_LENGTH + 1];
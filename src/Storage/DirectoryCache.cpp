@@ -0,0 +1,305 @@
+/*
+ * DirectoryCache.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#include "DirectoryCache.h"
+#include "MassStorage.h"
+#include "Platform.h"
+#include "RepRap.h"
+
+//*************************************************************************************************
+// CachedDirectory class implementation
+
+void CachedDirectory::Clear()
+{
+	path[0] = 0;
+	numEntries = 0;
+	nameBytesUsed = 0;
+	tooLarge = false;
+	lastUsed = 0;
+}
+
+void CachedDirectory::Start(const char *dir, uint32_t now)
+{
+	SafeStrncpy(path, dir, ARRAY_SIZE(path));
+	numEntries = 0;
+	nameBytesUsed = 0;
+	tooLarge = false;
+	lastUsed = now;
+	++generation;
+}
+
+// Return true if this is the specified directory or one of its subdirectories
+bool CachedDirectory::IsWithin(const char *dir) const
+{
+	if (!IsValid())
+	{
+		return false;
+	}
+	const size_t len = strlen(dir);
+	if (len == 1 && dir[0] == '/')
+	{
+		return true;							// everything is within the root directory
+	}
+	if (strlen(path) < len)
+	{
+		return false;
+	}
+	for (size_t i = 0; i < len; ++i)
+	{
+		if (tolower(path[i]) != tolower(dir[i]))
+		{
+			return false;
+		}
+	}
+	return path[len] == 0 || path[len] == '/';
+}
+
+// Return true if the name of the entry at the specified index matches a name, ignoring case as FAT does
+bool CachedDirectory::NameMatches(size_t index, const char *name) const
+{
+	const char *entryName = names + entries[index].nameOffset;
+	const size_t entryLength = entries[index].nameLength;
+	for (size_t i = 0; i < entryLength; ++i)
+	{
+		if (tolower(entryName[i]) != tolower(name[i]))					// if name[i] is the null terminator then they differ
+		{
+			return false;
+		}
+	}
+	return name[entryLength] == 0;
+}
+
+// Return the index of the named entry, or -1 if not found. The entries are in card order, so this is a linear search.
+int CachedDirectory::Find(const char *name) const
+{
+	for (size_t i = 0; i < numEntries; ++i)
+	{
+		if (NameMatches(i, name))
+		{
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+void CachedDirectory::GetEntry(size_t index, FileInfo& info) const
+{
+	const CachedDirectoryEntry& entry = entries[index];
+	memcpy(info.fileName, names + entry.nameOffset, entry.nameLength);
+	info.fileName[entry.nameLength] = 0;
+	info.isDirectory = entry.isDirectory;
+	info.size = entry.size;
+	info.lastModified = entry.lastModified;
+}
+
+// Update an entry, or add it at the end if it isn't present. Return false if there is no room for it.
+bool CachedDirectory::Store(const char *name, uint32_t size, time_t lastModified, bool isDirectory, bool sizeMayBeStale)
+{
+	int found = Find(name);
+	if (found < 0)
+	{
+		const size_t nameLength = strlen(name);
+		if (tooLarge || numEntries == MaxCachedDirectoryEntries || nameLength > UINT8_MAX || nameBytesUsed + nameLength > CachedDirectoryNameSpace)
+		{
+			return false;
+		}
+
+		found = (int)numEntries;
+		memcpy(names + nameBytesUsed, name, nameLength);
+		entries[found].nameOffset = nameBytesUsed;
+		entries[found].nameLength = nameLength;
+		nameBytesUsed += nameLength;
+		++numEntries;
+	}
+
+	CachedDirectoryEntry& entry = entries[found];
+	entry.size = size;
+	entry.lastModified = lastModified;
+	entry.isDirectory = isDirectory;
+	entry.sizeMayBeStale = sizeMayBeStale;
+	return true;
+}
+
+// Remove an entry, returning true if it was present
+bool CachedDirectory::Remove(const char *name)
+{
+	const int found = Find(name);
+	if (found < 0)
+	{
+		return false;
+	}
+	const size_t index = (size_t)found;
+
+	// Close up the name store so that it never needs to be garbage collected
+	const size_t offset = entries[index].nameOffset;
+	const size_t nameLength = entries[index].nameLength;
+	memmove(names + offset, names + offset + nameLength, nameBytesUsed - offset - nameLength);
+	nameBytesUsed -= nameLength;
+
+	--numEntries;
+	memmove(entries + index, entries + index + 1, (numEntries - index) * sizeof(CachedDirectoryEntry));
+	for (size_t i = 0; i < numEntries; ++i)
+	{
+		if (entries[i].nameOffset > offset)
+		{
+			entries[i].nameOffset -= nameLength;
+		}
+	}
+	return true;
+}
+
+//*************************************************************************************************
+// DirectoryCache class implementation
+
+DirectoryCache::DirectoryCache() : hits(0), misses(0), builds(0), overflows(0), useCounter(0)
+{
+	for (CachedDirectory& d : directories)
+	{
+		d.generation = 0;
+	}
+}
+
+// Convert a directory path to the form we use as a key. We drop the volume specifier for volume 0 and any trailing '/',
+// and make sure that paths on volume 0 start with '/'.
+/*static*/ void DirectoryCache::NormalisePath(const char *in, char *out, size_t outLength)
+{
+	if (in[0] == '0' && in[1] == ':')
+	{
+		in += 2;
+	}
+
+	size_t outIndex = 0;
+	if (in[0] != '/' && !(isdigit(in[0]) && in[1] == ':'))
+	{
+		out[outIndex++] = '/';
+	}
+	while (*in != 0 && outIndex + 1 < outLength)
+	{
+		out[outIndex++] = *in++;
+	}
+	if (outIndex > 1 && out[outIndex - 1] == '/')
+	{
+		--outIndex;
+	}
+	out[outIndex] = 0;
+}
+
+// Normalise the directory part of a file path into 'dir' and return a pointer to the file name part
+/*static*/ const char *DirectoryCache::SplitPath(const char *in, char *dir, size_t dirLength)
+{
+	const char * const lastSlash = strrchr(in, '/');
+	if (lastSlash == nullptr)
+	{
+		// File in the root directory, possibly with a volume specifier
+		if (isdigit(in[0]) && in[1] == ':')
+		{
+			const char volume[3] = { in[0], ':', 0 };
+			NormalisePath(volume, dir, dirLength);
+			return in + 2;
+		}
+		NormalisePath("/", dir, dirLength);
+		return in;
+	}
+
+	char temp[FILENAME_LENGTH];
+	const size_t dirPartLength = min<size_t>(lastSlash - in + 1, ARRAY_SIZE(temp) - 1);	// include the slash so that we get "/" for the root
+	memcpy(temp, in, dirPartLength);
+	temp[dirPartLength] = 0;
+	NormalisePath(temp, dir, dirLength);
+	return lastSlash + 1;
+}
+
+// Return the cached directory or nullptr, counting a hit or a miss
+CachedDirectory *DirectoryCache::Lookup(const char *dir)
+{
+	CachedDirectory * const d = Peek(dir);
+	if (d == nullptr || d->IsTooLarge())
+	{
+		++misses;
+	}
+	else
+	{
+		++hits;
+		d->lastUsed = ++useCounter;
+	}
+	return d;
+}
+
+// Return the cached directory or nullptr without affecting the statistics
+CachedDirectory *DirectoryCache::Peek(const char *dir)
+{
+	for (CachedDirectory& d : directories)
+	{
+		if (d.IsFor(dir))
+		{
+			return &d;
+		}
+	}
+	return nullptr;
+}
+
+// Get a slot to cache the specified directory, evicting the least recently used one if necessary
+size_t DirectoryCache::AllocateSlot(const char *dir)
+{
+	size_t slot = 0;
+	for (size_t i = 0; i < NumCachedDirectories; ++i)
+	{
+		if (!directories[i].IsValid())
+		{
+			slot = i;
+			break;
+		}
+		if (directories[i].lastUsed < directories[slot].lastUsed)
+		{
+			slot = i;
+		}
+	}
+
+	directories[slot].Start(dir, ++useCounter);
+	++builds;
+	return slot;
+}
+
+// Forget the specified directory and any subdirectories of it
+void DirectoryCache::Invalidate(const char *dir)
+{
+	for (CachedDirectory& d : directories)
+	{
+		if (d.IsWithin(dir))
+		{
+			d.Clear();
+		}
+	}
+}
+
+// Forget everything
+void DirectoryCache::Clear()
+{
+	for (CachedDirectory& d : directories)
+	{
+		d.Clear();
+	}
+}
+
+void DirectoryCache::Diagnostics(MessageType mtype)
+{
+	size_t entriesUsed = 0, nameBytesUsed = 0, dirsUsed = 0;
+	for (const CachedDirectory& d : directories)
+	{
+		if (d.IsValid())
+		{
+			++dirsUsed;
+			entriesUsed += d.NumEntries();
+			nameBytesUsed += d.NameBytesUsed();
+		}
+	}
+	reprap.GetPlatform().MessageF(mtype, "Directory cache: %u of %u directories, %u entries, %u name bytes, hits %" PRIu32 ", misses %" PRIu32 ", builds %" PRIu32 ", too large %" PRIu32 "\n",
+			dirsUsed, NumCachedDirectories, entriesUsed, nameBytesUsed, hits, misses, builds, overflows);
+	hits = misses = builds = overflows = 0;
+}
+
+// End
@@ -0,0 +1,105 @@
+/*
+ * DirectoryCache.h
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: agent
+ */
+
+#ifndef SRC_STORAGE_DIRECTORYCACHE_H_
+#define SRC_STORAGE_DIRECTORYCACHE_H_
+
+#include "RepRapFirmware.h"
+#include "MessageType.h"
+#include <ctime>
+
+#if SAM4E || SAM4S
+const size_t NumCachedDirectories = 2;					// Number of directory listings we keep
+const size_t MaxCachedDirectoryEntries = 64;			// Maximum number of entries in each cached directory
+const size_t CachedDirectoryNameSpace = 1536;			// Bytes available for the entry names in each cached directory
+#else
+const size_t NumCachedDirectories = 1;
+const size_t MaxCachedDirectoryEntries = 32;
+const size_t CachedDirectoryNameSpace = 768;
+#endif
+
+struct FileInfo;
+
+// One entry in a cached directory. The name is held in the name store of the directory that owns it.
+struct CachedDirectoryEntry
+{
+	uint32_t size;
+	time_t lastModified;
+	uint16_t nameOffset;
+	uint8_t nameLength;
+	bool isDirectory : 1;
+	bool sizeMayBeStale : 1;							// the file was opened for writing after we cached it
+};
+
+// Copy of the listing of one directory, held in RAM so that repeated listings and FileExists checks don't touch the card.
+// Entries are kept in the order they are on the card, so that a listing returned in several parts carries on correctly
+// whether or not the directory is still cached when the next part is requested.
+class CachedDirectory
+{
+public:
+	CachedDirectory() { Clear(); }
+
+	void Clear();
+	void Start(const char *dir, uint32_t now);			// start caching the specified directory, which must already be normalised
+	void MarkTooLarge() { numEntries = 0; nameBytesUsed = 0; tooLarge = true; }
+
+	bool IsValid() const { return path[0] != 0; }
+	bool IsTooLarge() const { return tooLarge; }
+	bool IsFor(const char *dir) const { return IsValid() && StringEquals(path, dir); }
+	bool IsWithin(const char *dir) const;				// return true if this is the specified directory or one of its subdirectories
+	const char *GetPath() const { return path; }
+
+	size_t NumEntries() const { return numEntries; }
+	size_t NameBytesUsed() const { return nameBytesUsed; }
+	int Find(const char *name) const;					// return the index of the named entry, or -1 if not found
+	void GetEntry(size_t index, FileInfo& info) const;
+	bool IsStale(size_t index) const { return entries[index].sizeMayBeStale; }
+
+	bool Store(const char *name, uint32_t size, time_t lastModified, bool isDirectory, bool sizeMayBeStale);	// update an entry or add it at the end, returning false if there is no room
+	bool Remove(const char *name);						// remove an entry, returning true if it was present
+
+	uint32_t lastUsed;									// used to find the least recently used directory when we need a slot
+	uint32_t generation;								// incremented every time the slot is reused, so that iterators can tell
+
+private:
+	bool NameMatches(size_t index, const char *name) const;
+
+	char path[FILENAME_LENGTH];
+	CachedDirectoryEntry entries[MaxCachedDirectoryEntries];
+	char names[CachedDirectoryNameSpace];
+	size_t numEntries;
+	size_t nameBytesUsed;
+	bool tooLarge;										// we tried to cache this directory but it didn't fit
+};
+
+// The collection of cached directories
+class DirectoryCache
+{
+public:
+	DirectoryCache();
+
+	static void NormalisePath(const char *in, char *out, size_t outLength);		// convert a directory path to the form we use as a key
+	static const char *SplitPath(const char *in, char *dir, size_t dirLength);	// normalise the directory part of a file path and return the file name part
+
+	CachedDirectory *Lookup(const char *dir);			// return the cached directory or nullptr, counting a hit or a miss
+	CachedDirectory *Peek(const char *dir);				// return the cached directory or nullptr without affecting the statistics
+	CachedDirectory *GetSlot(size_t slot) { return &directories[slot]; }
+	size_t AllocateSlot(const char *dir);				// get a slot to cache the specified directory, evicting the least recently used one
+	void Invalidate(const char *dir);					// forget the specified directory and any subdirectories of it
+	void Clear();										// forget everything, e.g. because a card has been mounted or unmounted
+
+	void CountHit() { ++hits; }
+	void CountOverflow() { ++overflows; }
+	void Diagnostics(MessageType mtype);
+
+private:
+	CachedDirectory directories[NumCachedDirectories];
+	uint32_t hits, misses, builds, overflows;
+	uint32_t useCounter;
+};
+
+#endif /* SRC_STORAGE_DIRECTORYCACHE_H_ */
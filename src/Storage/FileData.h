@@ -76,6 +76,21 @@ public:
 		return f->Flush();
 	}
 
+	bool IsWriteBacklogged() const
+	{
+		return f->IsWriteBacklogged();
+	}
+
+	bool PreAllocate(FilePosition size)
+	{
+		return f->PreAllocate(size);
+	}
+
+	uint32_t GetCRC32() const
+	{
+		return f->GetCRC32();
+	}
+
 	FilePosition GetPosition() const
 	{
 		return f->Position();
@@ -8,7 +8,7 @@
 
 uint32_t FileStore::longestWriteTime = 0;
 
-FileStore::FileStore(Platform* p) : platform(p), writeBuffer(nullptr)
+FileStore::FileStore(Platform* p) : platform(p), writeBuffer(nullptr), queuedBuffers(nullptr), preAllocatedSize(0)
 {
 }
 
@@ -16,6 +16,7 @@ void FileStore::Init()
 {
 	inUse = false;
 	writing = false;
+	queuedWriteFailed = false;
 	openCount = 0;
 	closeRequested = false;
 }
@@ -25,6 +26,7 @@ void FileStore::Invalidate(const FATFS *fs)
 {
 	if (file.fs == fs)
 	{
+		ReleaseQueuedBuffers();
 		Init();
 		file.fs = nullptr;
 	}
@@ -74,6 +76,9 @@ bool FileStore::Open(const char* directory, const char* fileName, OpenMode mode)
 			}
 		}
 
+		// Creating a file changes the directory, so any paginated listing in progress must start again
+		platform->GetMassStorage()->InvalidateFindCursor();
+
 		// Also try to allocate a write buffer so we can perform faster writes
 		writeBuffer = platform->GetMassStorage()->AllocateWriteBuffer();
 	}
@@ -92,7 +97,14 @@ bool FileStore::Open(const char* directory, const char* fileName, OpenMode mode)
 		}
 		return false;
 	}
+	if (writing)
+	{
+		// Add the file to any cached listing of its directory. Its size will change while we write it.
+		platform->GetMassStorage()->UpdateCachedEntry(location, true);
+	}
 	crc.Reset();
+	queuedWriteFailed = false;
+	preAllocatedSize = 0;
 	inUse = true;
 	openCount = 1;
 	return true;
@@ -153,6 +165,19 @@ bool FileStore::Close()
 	if (writing)
 	{
 		ok = Flush();
+		if (preAllocatedSize > file.fsize)
+		{
+			// Free any clusters we allocated in advance but didn't use. f_truncate cuts the file at the current position.
+			const FilePosition size = file.fsize;
+			FRESULT fr = f_lseek(&file, size);
+			file.fsize = preAllocatedSize;
+			if (fr == FR_OK)
+			{
+				fr = f_truncate(&file);
+			}
+			file.fsize = size;
+			ok = ok && fr == FR_OK;
+		}
 	}
 
 	if (writeBuffer != nullptr)
@@ -199,7 +224,12 @@ FilePosition FileStore::Length() const
 		return 0;
 	}
 
-	return (writeBuffer != nullptr) ? file.fsize + writeBuffer->BytesStored() : file.fsize;
+	FilePosition len = file.fsize;
+	for (const FileWriteBuffer *buf = queuedBuffers; buf != nullptr; buf = buf->Next())
+	{
+		len += buf->BytesUnwritten();
+	}
+	return (writeBuffer != nullptr) ? len + writeBuffer->BytesStored() : len;
 }
 
 // Single character read
@@ -294,7 +324,11 @@ bool FileStore::Write(const char *s, size_t len)
 
 	size_t totalBytesWritten = 0;
 	FRESULT writeStatus = FR_OK;
-	if (writeBuffer == nullptr)
+	if (queuedWriteFailed)
+	{
+		writeStatus = FR_DISK_ERR;
+	}
+	else if (writeBuffer == nullptr)
 	{
 		writeStatus = Store(s, len, &totalBytesWritten);
 	}
@@ -305,15 +339,31 @@ bool FileStore::Write(const char *s, size_t len)
 			size_t bytesStored = writeBuffer->Store(s + totalBytesWritten, len - totalBytesWritten);
 			if (writeBuffer->BytesLeft() == 0)
 			{
-				const size_t bytesToWrite = writeBuffer->BytesStored();
-				size_t bytesWritten;
-				writeStatus = Store(writeBuffer->Data(), bytesToWrite, &bytesWritten);
-				writeBuffer->DataTaken();
-
-				if (bytesToWrite != bytesWritten)
+				// If we can get another buffer then queue this one to be written by Spin, so that the caller doesn't have to wait for the card
+				FileWriteBuffer * const newBuffer = platform->GetMassStorage()->AllocateWriteBuffer();
+				if (newBuffer != nullptr)
 				{
-					// Something went wrong
-					break;
+					QueueWriteBuffer(writeBuffer);
+					writeBuffer = newBuffer;
+				}
+				else
+				{
+					if (!WriteQueuedData(true))
+					{
+						writeStatus = FR_DISK_ERR;
+						break;
+					}
+
+					const size_t bytesToWrite = writeBuffer->BytesStored();
+					size_t bytesWritten;
+					writeStatus = Store(writeBuffer->Data(), bytesToWrite, &bytesWritten);
+					writeBuffer->DataTaken();
+
+					if (bytesToWrite != bytesWritten)
+					{
+						// Something went wrong
+						break;
+					}
 				}
 			}
 			totalBytesWritten += bytesStored;
@@ -337,6 +387,12 @@ bool FileStore::Flush()
 		return false;
 	}
 
+	if (queuedWriteFailed || !WriteQueuedData(true))
+	{
+		platform->Message(ErrorMessage, "Failed to write to file. Drive may be full.\n");
+		return false;
+	}
+
 	if (writeBuffer != nullptr)
 	{
 		const size_t bytesToWrite = writeBuffer->BytesStored();
@@ -357,6 +413,113 @@ bool FileStore::Flush()
 	return f_sync(&file) == FR_OK;
 }
 
+// Allocate clusters for the file to grow to the specified size, so that it ends up in as few fragments as possible even if other files grow at the same time.
+// FatFs R0.09 has no f_expand, but seeking beyond the end of a file that is open for writing extends its cluster chain in one go.
+// We put the file size back afterwards so that the directory entry never covers data we haven't written. Close frees any clusters we didn't use.
+// Return true if the space is allocated, false if it isn't, e.g. because the card is nearly full.
+bool FileStore::PreAllocate(FilePosition size)
+{
+	if (!inUse || !writing)
+	{
+		return false;
+	}
+	if (size <= preAllocatedSize || size <= file.fsize)
+	{
+		return true;
+	}
+
+	const FilePosition oldPosition = file.fptr, oldSize = file.fsize;
+	FRESULT fr = f_lseek(&file, size);
+	const FilePosition allocatedSize = file.fptr;			// this is less than we asked for if the card is full
+	if (fr == FR_OK)
+	{
+		fr = f_lseek(&file, oldPosition);
+	}
+	file.fsize = oldSize;
+	preAllocatedSize = allocatedSize;
+	return fr == FR_OK && allocatedSize >= size;
+}
+
+// Return true if all the write buffers are full, so that writing any more data would make us wait for the card.
+// Callers that can hold off, such as uploads that can leave data in the socket, use this to avoid stalling the main loop.
+bool FileStore::IsWriteBacklogged() const
+{
+	return queuedBuffers != nullptr && !platform->GetMassStorage()->HasFreeWriteBuffer();
+}
+
+// Add a full buffer to the end of the queue of buffers to be written
+void FileStore::QueueWriteBuffer(FileWriteBuffer *buffer)
+{
+	buffer->SetNext(nullptr);
+	if (queuedBuffers == nullptr)
+	{
+		queuedBuffers = buffer;
+	}
+	else
+	{
+		FileWriteBuffer *last = queuedBuffers;
+		while (last->Next() != nullptr)
+		{
+			last = last->Next();
+		}
+		last->SetNext(buffer);
+	}
+}
+
+// Write either one slice or all of the queued data to the card, releasing each buffer when it has been written.
+// Return false if the write failed, in which case we discard the remaining queued data.
+bool FileStore::WriteQueuedData(bool all)
+{
+	while (queuedBuffers != nullptr)
+	{
+		FileWriteBuffer * const buffer = queuedBuffers;
+		const size_t bytesToWrite = (all) ? buffer->BytesUnwritten() : min<size_t>(buffer->BytesUnwritten(), FileWriteSliceLength);
+		size_t bytesWritten;
+		const FRESULT writeStatus = Store(buffer->UnwrittenData(), bytesToWrite, &bytesWritten);
+		if (writeStatus != FR_OK || bytesWritten != bytesToWrite)
+		{
+			ReleaseQueuedBuffers();
+			queuedWriteFailed = true;
+			return false;
+		}
+
+		buffer->DataWritten(bytesWritten);
+		if (buffer->BytesUnwritten() == 0)
+		{
+			queuedBuffers = buffer->Next();
+			buffer->DataTaken();
+			platform->GetMassStorage()->ReleaseWriteBuffer(buffer);
+		}
+
+		if (!all)
+		{
+			break;
+		}
+	}
+	return true;
+}
+
+void FileStore::ReleaseQueuedBuffers()
+{
+	while (queuedBuffers != nullptr)
+	{
+		FileWriteBuffer * const buffer = queuedBuffers;
+		queuedBuffers = buffer->Next();
+		buffer->DataTaken();
+		platform->GetMassStorage()->ReleaseWriteBuffer(buffer);
+	}
+}
+
+// Write a slice of any queued data to the card. This is called from the main loop, so we keep each write short.
+// If it fails, the error is reported by the next call to Write or Flush.
+void FileStore::Spin()
+{
+	if (inUse && queuedBuffers != nullptr)
+	{
+		(void)WriteQueuedData(false);
+	}
+}
+
 float FileStore::GetAndClearLongestWriteTime()
 {
 	float ret = (float)longestWriteTime/1000.0;
@@ -36,6 +36,8 @@ public:
 	FilePosition Length() const;					// File size in bytes
 	void Duplicate();								// Create a second reference to this file
 	bool Flush();									// Write remaining buffer data
+	bool IsWriteBacklogged() const;					// Return true if the caller should hold off writing more data until queued data has been written
+	bool PreAllocate(FilePosition size);			// Allocate space on the card for the file to grow to the specified size
 	void Invalidate(const FATFS *fs);				// Invalidate the file if it uses the specified FATFS object
 	bool IsOpenOn(const FATFS *fs) const;			// Return true if the file is open on the specified file system
 	uint32_t GetCRC32() const;
@@ -51,19 +53,27 @@ protected:
 
 	FileStore(Platform* p);
 	void Init();
+	void Spin();									// Write a slice of any queued data to the card
     bool Open(const char* directory, const char* fileName, OpenMode mode);
     FRESULT Store(const char *s, size_t len, size_t *bytesWritten); // Write data to the non-volatile storage
 
 private:
+	void QueueWriteBuffer(FileWriteBuffer *buffer);
+	bool WriteQueuedData(bool all);
+	void ReleaseQueuedBuffers();
+
 	Platform* platform;
 
 	FIL file;
-	FileWriteBuffer *writeBuffer;
+	FileWriteBuffer *writeBuffer;					// the buffer we are filling
+	FileWriteBuffer *queuedBuffers;					// full buffers waiting to be written to the card, oldest first
+	FilePosition preAllocatedSize;					// the size we allocated clusters for, so that we can free any we didn't use when we close the file
 	volatile unsigned int openCount;
 	volatile bool closeRequested;
 
 	bool inUse;
 	bool writing;
+	bool queuedWriteFailed;							// writing queued data from Spin failed, so the file is incomplete
 	CRC32 crc;
 
 	static uint32_t longestWriteTime;
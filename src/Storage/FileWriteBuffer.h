@@ -12,21 +12,25 @@
 
 
 #if SAM4E || SAM4S
-const size_t NumFileWriteBuffers = 2;					// Number of write buffers
+const size_t NumFileWriteBuffers = 3;					// Number of write buffers
 const size_t FileWriteBufLen = 8192;					// Size of each write buffer
+const size_t FileWriteSliceLength = 2048;				// Maximum amount of queued data we write to the card in one go from the main loop, a multiple of 512
 #else
 const size_t NumFileWriteBuffers = 1;
 const size_t FileWriteBufLen = 4096;
+const size_t FileWriteSliceLength = 1024;
 #endif
 
 
 // Class to cache data that is about to be written to the SD card. This is NOT a ring buffer,
 // instead it just provides simple interfaces to cache a certain amount of data so that fewer
 // f_write() calls are needed. This effectively improves upload speeds.
+// When a file has more than one buffer, full buffers are queued and written to the card a slice at a time,
+// so we also keep track of how much of the buffer has been written.
 class FileWriteBuffer
 {
 public:
-	FileWriteBuffer(FileWriteBuffer *n) : next(n), index(0) { }
+	FileWriteBuffer(FileWriteBuffer *n) : next(n), index(0), written(0) { }
 
 	FileWriteBuffer *Next() const { return next; }
 	void SetNext(FileWriteBuffer *n) { next = n; }
@@ -36,13 +40,18 @@ public:
 	const size_t BytesStored() const { return index; }
 	const size_t BytesLeft() const { return FileWriteBufLen - index; }
 
+	const char *UnwrittenData() const { return Data() + written; }
+	size_t BytesUnwritten() const { return index - written; }
+
 	size_t Store(const char *data, size_t length);		// Stores some data and returns how much could be stored
-	void DataTaken() { index = 0; }						// Called to indicate that the buffer has been written
+	void DataWritten(size_t length) { written += length; }	// Called to indicate that some of the queued data has been written
+	void DataTaken() { index = written = 0; }			// Called to indicate that the buffer has been written
 
 private:
 	FileWriteBuffer *next;
 
 	size_t index;
+	size_t written;
 	int32_t data32[FileWriteBufLen / sizeof(int32_t)];	// 32-bit aligned buffer for better HSMCI performance
 };
 
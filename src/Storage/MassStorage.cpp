@@ -48,9 +48,10 @@ static const char* TranslateCardError(sd_mmc_err_t err)
 }
 
 // Mass Storage class
-MassStorage::MassStorage(Platform* p) : platform(p)
+MassStorage::MassStorage(Platform* p) : platform(p), findDirIndex(0), findCachedDir(nullptr), findCachedGeneration(0), findCachedIndex(0)
 {
 	memset(&fileSystems, 0, sizeof(fileSystems));
+	findDirName[0] = 0;
 }
 
 void MassStorage::Init()
@@ -143,7 +144,20 @@ const char* MassStorage::CombineName(const char* directory, const char* fileName
 }
 
 // Open a directory to read a file list. Returns true if it contains any files, false otherwise.
+// If the directory is small enough to be cached then the listing comes from the cache, in the same order as on the card.
 bool MassStorage::FindFirst(const char *directory, FileInfo &file_info)
+{
+	char dir[FILENAME_LENGTH];
+	DirectoryCache::NormalisePath(directory, dir, ARRAY_SIZE(dir));
+	if (StartCachedListing(dir))
+	{
+		return GetNextCachedEntry(file_info);
+	}
+	return FindFirstOnCard(directory, file_info);
+}
+
+// Open a directory on the card to read a file list, bypassing the cache
+bool MassStorage::FindFirstOnCard(const char *directory, FileInfo &file_info)
 {
 	TCHAR loc[FILENAME_LENGTH + 1];
 
@@ -155,6 +169,8 @@ bool MassStorage::FindFirst(const char *directory, FileInfo &file_info)
 		loc[len - 1] = 0;
 	}
 
+	InvalidateFindCursor();
+	findCachedDir = nullptr;
 	findDir.lfn = nullptr;
 	FRESULT res = f_opendir(&findDir, loc);
 	if (res == FR_OK)
@@ -179,6 +195,9 @@ bool MassStorage::FindFirst(const char *directory, FileInfo &file_info)
 			file_info.size = entry.fsize;
 			file_info.lastModified = ConvertTimeStamp(entry.fdate, entry.ftime);
 
+			// Remember where we are so that a paginated listing can carry on from here
+			SafeStrncpy(findDirName, loc, ARRAY_SIZE(findDirName));
+			findDirIndex = 1;
 			return true;
 		}
 	}
@@ -189,16 +208,24 @@ bool MassStorage::FindFirst(const char *directory, FileInfo &file_info)
 // Find the next file in a directory. Returns true if another file has been read.
 bool MassStorage::FindNext(FileInfo &file_info)
 {
+	if (findCachedDir != nullptr)
+	{
+		return GetNextCachedEntry(file_info);
+	}
+
 	FILINFO entry;
 	entry.lfname = file_info.fileName;
 	entry.lfsize = ARRAY_SIZE(file_info.fileName);
 
 	findDir.lfn = nullptr;
+	findDirRewind = findDir;
 	if (f_readdir(&findDir, &entry) != FR_OK || entry.fname[0] == 0)
 	{
 		//f_closedir(findDir);
+		InvalidateFindCursor();
 		return false;
 	}
+	++findDirIndex;
 
 	file_info.isDirectory = (entry.fattrib & AM_DIR);
 	file_info.size = entry.fsize;
@@ -212,6 +239,217 @@ bool MassStorage::FindNext(FileInfo &file_info)
 	return true;
 }
 
+// Find the entry with index 'startAt' in the specified directory, where index 0 is the entry that FindFirst returns.
+// This is used to return long directory listings in several parts. If the previous part of the listing left the directory
+// open at (or one entry beyond) the requested index then we carry on from there, otherwise we have to skip the earlier entries.
+bool MassStorage::FindAt(const char *directory, unsigned int startAt, FileInfo &file_info)
+{
+	char dir[FILENAME_LENGTH];
+	DirectoryCache::NormalisePath(directory, dir, ARRAY_SIZE(dir));
+	if (StartCachedListing(dir))
+	{
+		findCachedIndex = startAt;
+		return GetNextCachedEntry(file_info);
+	}
+
+	if (startAt != 0)
+	{
+		char loc[FILENAME_LENGTH];
+		SafeStrncpy(loc, directory, ARRAY_SIZE(loc));
+		const size_t len = strlen(loc);
+		if (len != 0 && loc[len - 1] == '/')
+		{
+			loc[len - 1] = 0;
+		}
+
+		if (findDirName[0] != 0 && StringEquals(loc, findDirName))
+		{
+			if (startAt + 1 == findDirIndex)
+			{
+				// The caller read this entry last time but had no room to return it, so read it again
+				findDir = findDirRewind;
+				findDirIndex = startAt;
+			}
+			if (startAt == findDirIndex)
+			{
+				return FindNext(file_info);
+			}
+		}
+	}
+
+	if (!FindFirstOnCard(directory, file_info))
+	{
+		return false;
+	}
+	while (findDirIndex <= startAt)
+	{
+		if (!FindNext(file_info))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Start iterating over the cached copy of a directory, building the cache entry if we don't have one.
+// Return false if the directory cannot be cached, in which case the caller must read the directory from the card.
+bool MassStorage::StartCachedListing(const char *dir)
+{
+	findCachedDir = nullptr;
+	CachedDirectory *cd = dirCache.Lookup(dir);
+	if (cd == nullptr)
+	{
+		cd = BuildCachedDirectory(dir);
+	}
+	if (cd == nullptr || cd->IsTooLarge())
+	{
+		return false;
+	}
+
+	InvalidateFindCursor();
+	findCachedDir = cd;
+	findCachedGeneration = cd->generation;
+	findCachedIndex = 0;
+	return true;
+}
+
+// Return the next entry from the cached directory we are iterating over
+bool MassStorage::GetNextCachedEntry(FileInfo &file_info)
+{
+	if (!findCachedDir->IsValid() || findCachedDir->generation != findCachedGeneration || findCachedIndex >= findCachedDir->NumEntries())
+	{
+		// Finished, or the cached directory has been discarded since we started
+		findCachedDir = nullptr;
+		return false;
+	}
+
+	findCachedDir->GetEntry(findCachedIndex, file_info);
+	if (findCachedDir->IsStale(findCachedIndex))
+	{
+		// The file has been written since we cached it, so fetch the current size and date
+		FILINFO fil;
+		fil.lfname = nullptr;
+		if (f_stat(CombineName(findCachedDir->GetPath(), file_info.fileName), &fil) == FR_OK)
+		{
+			file_info.size = fil.fsize;
+			file_info.lastModified = ConvertTimeStamp(fil.fdate, fil.ftime);
+			(void)findCachedDir->Store(file_info.fileName, file_info.size, file_info.lastModified, file_info.isDirectory, true);
+		}
+	}
+	++findCachedIndex;
+	return true;
+}
+
+// Read a directory into a cache slot. If it doesn't fit then we record that so that we don't try again until the directory changes.
+// Return nullptr if the directory can't be read.
+CachedDirectory *MassStorage::BuildCachedDirectory(const char *dir)
+{
+	DIR cacheDir;
+	cacheDir.lfn = nullptr;
+	if (f_opendir(&cacheDir, dir) != FR_OK)
+	{
+		return nullptr;
+	}
+
+	CachedDirectory * const cd = dirCache.GetSlot(dirCache.AllocateSlot(dir));
+	char longName[FILENAME_LENGTH];
+	FILINFO entry;
+	entry.lfname = longName;
+	entry.lfsize = ARRAY_SIZE(longName);
+	for (;;)
+	{
+		if (f_readdir(&cacheDir, &entry) != FR_OK)
+		{
+			cd->Clear();
+			return nullptr;
+		}
+		if (entry.fname[0] == 0)
+		{
+			break;
+		}
+		if (StringEquals(entry.fname, ".") || StringEquals(entry.fname, ".."))
+		{
+			continue;
+		}
+
+		const char * const name = (longName[0] != 0) ? longName : entry.fname;
+		if (!cd->Store(name, entry.fsize, ConvertTimeStamp(entry.fdate, entry.ftime), (entry.fattrib & AM_DIR) != 0, false))
+		{
+			cd->MarkTooLarge();
+			dirCache.CountOverflow();
+			break;
+		}
+	}
+	return cd;
+}
+
+// Bring the cached entry for the specified file or directory up to date, if we are caching its parent directory
+void MassStorage::UpdateCachedEntry(const char *location, bool sizeMayBeStale)
+{
+	char dir[FILENAME_LENGTH];
+	const char * const name = DirectoryCache::SplitPath(location, dir, ARRAY_SIZE(dir));
+	CachedDirectory * const cd = dirCache.Peek(dir);
+	if (cd != nullptr && name[0] != 0)
+	{
+		if (cd->IsTooLarge())
+		{
+			cd->Clear();							// the directory has changed, so it may fit in the cache now
+			return;
+		}
+
+		FILINFO fil;
+		fil.lfname = nullptr;
+		if (f_stat(location, &fil) != FR_OK)
+		{
+			(void)cd->Remove(name);
+		}
+		else if (cd->Find(name) < 0)
+		{
+			// FAT puts a new entry in the first free slot in the directory, which we don't know.
+			// Forget the cached listing so that we read it again in card order next time it is used.
+			cd->Clear();
+		}
+		else
+		{
+			(void)cd->Store(name, fil.fsize, ConvertTimeStamp(fil.fdate, fil.ftime), (fil.fattrib & AM_DIR) != 0, sizeMayBeStale);
+		}
+	}
+}
+
+// Remove the cached entry for the specified file or directory, if we are caching its parent directory
+void MassStorage::RemoveCachedEntry(const char *location)
+{
+	char dir[FILENAME_LENGTH];
+	const char * const name = DirectoryCache::SplitPath(location, dir, ARRAY_SIZE(dir));
+	CachedDirectory * const cd = dirCache.Peek(dir);
+	if (cd != nullptr && name[0] != 0)
+	{
+		if (cd->IsTooLarge())
+		{
+			cd->Clear();							// the directory has changed, so it may fit in the cache now
+		}
+		else
+		{
+			(void)cd->Remove(name);
+		}
+	}
+
+	// If it was a directory then we must forget any cached listing of it
+	DirectoryCache::NormalisePath(location, dir, ARRAY_SIZE(dir));
+	dirCache.Invalidate(dir);
+}
+
+// Call this when a file has been written by other means than FileStore, or its attributes have changed
+void MassStorage::UpdateCachedFileInfo(const char* directory, const char *fileName)
+{
+	UpdateCachedEntry((directory != nullptr) ? CombineName(directory, fileName) : fileName, false);
+}
+
+void MassStorage::Diagnostics(MessageType mtype)
+{
+	dirCache.Diagnostics(mtype);
+}
+
 // Month names. The first entry is used for invalid month numbers.
 static const char *monthNames[13] = { "???", "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
 
@@ -227,6 +465,7 @@ bool MassStorage::Delete(const char* directory, const char* fileName, bool silen
 	const char* const location = (directory != nullptr)
 									? platform->GetMassStorage()->CombineName(directory, fileName)
 									: fileName;
+	InvalidateFindCursor();
 	if (f_unlink(location) != FR_OK)
 	{
 		if (!silent)
@@ -235,6 +474,7 @@ bool MassStorage::Delete(const char* directory, const char* fileName, bool silen
 		}
 		return false;
 	}
+	RemoveCachedEntry(location);
 	return true;
 }
 
@@ -242,21 +482,25 @@ bool MassStorage::Delete(const char* directory, const char* fileName, bool silen
 bool MassStorage::MakeDirectory(const char *parentDir, const char *dirName)
 {
 	const char* const location = platform->GetMassStorage()->CombineName(parentDir, dirName);
+	InvalidateFindCursor();
 	if (f_mkdir(location) != FR_OK)
 	{
 		platform->MessageF(ErrorMessage, "Failed to create directory %s\n", location);
 		return false;
 	}
+	UpdateCachedEntry(location, false);
 	return true;
 }
 
 bool MassStorage::MakeDirectory(const char *directory)
 {
+	InvalidateFindCursor();
 	if (f_mkdir(directory) != FR_OK)
 	{
 		platform->MessageF(ErrorMessage, "Failed to create directory %s\n", directory);
 		return false;
 	}
+	UpdateCachedEntry(directory, false);
 	return true;
 }
 
@@ -270,17 +514,29 @@ bool MassStorage::Rename(const char *oldFilename, const char *newFilename)
 		// We are assuming that the user isn't really trying to rename across volumes. This is a safe assumption when the client is DWC.
 		newFilename += 2;
 	}
+	InvalidateFindCursor();
 	if (f_rename(oldFilename, newFilename) != FR_OK)
 	{
 		platform->MessageF(ErrorMessage, "Failed to rename file or directory %s to %s\n", oldFilename, newFilename);
 		return false;
 	}
+	RemoveCachedEntry(oldFilename);
+	UpdateCachedEntry(newFilename, false);
 	return true;
 }
 
-// Check if the specified file exists
+// Check if the specified file exists. If we have a cached listing of its directory then we don't need to access the card.
 bool MassStorage::FileExists(const char *file) const
 {
+	char dir[FILENAME_LENGTH];
+	const char * const name = DirectoryCache::SplitPath(file, dir, ARRAY_SIZE(dir));
+	const CachedDirectory * const cd = dirCache.Peek(dir);
+	if (cd != nullptr && !cd->IsTooLarge() && name[0] != 0)
+	{
+		dirCache.CountHit();
+		return cd->Find(name) >= 0;
+	}
+
 	FILINFO fil;
 	fil.lfname = nullptr;
 	return (f_stat(file, &fil) == FR_OK);
@@ -332,7 +588,11 @@ bool MassStorage::SetLastModifiedTime(const char* directory, const char *fileNam
     fno.fdate = (WORD)(((timeInfo->tm_year - 80) * 512U) | (timeInfo->tm_mon + 1) * 32U | timeInfo->tm_mday);
     fno.ftime = (WORD)(timeInfo->tm_hour * 2048U | timeInfo->tm_min * 32U | timeInfo->tm_sec / 2U);
     const bool ok = (f_utime(location, &fno) == FR_OK);
-    if (!ok)
+    if (ok)
+    {
+    	UpdateCachedEntry(location, false);
+    }
+    else
 	{
 		reprap.GetPlatform().MessageF(ErrorMessage, "Failed to set last modified time for file '%s'\n", location);
 	}
@@ -362,6 +622,9 @@ GCodeResult MassStorage::Mount(size_t card, StringRef& reply, bool reportSuccess
 
 	if (!mounting)
 	{
+		InvalidateFindCursor();
+		dirCache.Clear();
+		findCachedDir = nullptr;
 		f_mount(card, nullptr);			// un-mount it from FATFS
 		sd_mmc_unmount(card);			// this forces it to re-initialise the card
 		isMounted[card] = false;
@@ -428,6 +691,9 @@ GCodeResult MassStorage::Unmount(size_t card, StringRef& reply)
 	}
 
 	platform->InvalidateFiles(&fileSystems[card]);
+	InvalidateFindCursor();
+	dirCache.Clear();
+	findCachedDir = nullptr;
 	f_mount(card, nullptr);
 	sd_mmc_unmount(card);
 	isMounted[card] = false;
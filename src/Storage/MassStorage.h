@@ -4,6 +4,7 @@
 #include "RepRapFirmware.h"
 #include "Pins.h"
 #include "FileWriteBuffer.h"
+#include "DirectoryCache.h"
 #include "Libraries/Fatfs/ff.h"
 #include "GCodes/GCodeResult.h"
 #include <ctime>
@@ -23,6 +24,7 @@ public:
 
 	bool FindFirst(const char *directory, FileInfo &file_info);
 	bool FindNext(FileInfo &file_info);
+	bool FindAt(const char *directory, unsigned int startAt, FileInfo &file_info);
 	const char* GetMonthName(const uint8_t month);
 	const char* CombineName(const char* directory, const char* fileName);
 	bool Delete(const char* directory, const char* fileName, bool silent = false);
@@ -39,6 +41,8 @@ public:
 	GCodeResult Unmount(size_t card, StringRef& reply);
 	bool IsDriveMounted(size_t drive) const { return drive < NumSdCards && isMounted[drive]; }
 	bool CheckDriveMounted(const char* path);
+	void UpdateCachedFileInfo(const char* directory, const char *fileName);	// call this when a file has been written by other means than FileStore, e.g. on upload completion
+	void Diagnostics(MessageType mtype);
 
 friend class Platform;
 friend class FileStore;
@@ -50,13 +54,30 @@ protected:
 
 	FileWriteBuffer *AllocateWriteBuffer();
 	void ReleaseWriteBuffer(FileWriteBuffer *buffer);
+	bool HasFreeWriteBuffer() const { return freeWriteBuffers != nullptr; }
 
 private:
 	static time_t ConvertTimeStamp(uint16_t fdate, uint16_t ftime);
 
+	void InvalidateFindCursor() { findDirName[0] = 0; }
+	bool FindFirstOnCard(const char *directory, FileInfo &file_info);
+	bool StartCachedListing(const char *dir);
+	bool GetNextCachedEntry(FileInfo &file_info);
+	CachedDirectory *BuildCachedDirectory(const char *dir);
+	void UpdateCachedEntry(const char *location, bool sizeMayBeStale);
+	void RemoveCachedEntry(const char *location);
+
 	Platform* platform;
 	FATFS fileSystems[NumSdCards];
 	DIR findDir;
+	DIR findDirRewind;								// state of findDir before the last entry was read, so that a listing can resume at that entry
+	char findDirName[FILENAME_LENGTH];				// directory that findDir is iterating over, or empty if the listing cursor is not valid
+	unsigned int findDirIndex;						// index of the entry that the next call to FindNext will return
+
+	mutable DirectoryCache dirCache;				// listings of recently used directories
+	CachedDirectory *findCachedDir;					// the cached directory that FindNext is iterating over, or nullptr if it is using findDir
+	uint32_t findCachedGeneration;					// generation of findCachedDir when we started iterating over it
+	size_t findCachedIndex;							// index of the cached entry that the next call to FindNext will return
 	bool isMounted[NumSdCards];
 	char combinedName[FILENAME_LENGTH + 1];
 